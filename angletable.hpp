@@ -0,0 +1,361 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_ANGLETABLE_HPP
+#define WINTEN_ANGLETABLE_HPP
+
+// Include external header files
+#include <cstdint>
+#include <utility>
+
+// Include project header files
+#include "cfixed.hpp"
+#include "winten_constants.hpp"
+
+// Quantized ball angles from BALL_MIN_THETA to BALL_MAX_THETA inclusive, odd
+// so that straight across and the mirror of every angle are on the grid
+#ifndef WINTEN_ANGLE_STEPS
+#define WINTEN_ANGLE_STEPS 513
+#endif
+
+// Equally likely paddle noise draws per angle, a power of two
+#ifndef WINTEN_ANGLE_DRAWS
+#define WINTEN_ANGLE_DRAWS 8
+#endif
+
+/// <summary>
+///     Ball angles quantized to a grid with their direction vectors, and the
+///     angle after a paddle hit for every incoming angle and noise draw, all
+///     generated at compile time. A bounce is then a table lookup with no
+///     trigonometry, clamping or branching.
+/// </summary>
+namespace angle_table
+{
+    constexpr int STEPS = WINTEN_ANGLE_STEPS;
+    constexpr int DRAWS = WINTEN_ANGLE_DRAWS;
+    // Step of a ball travelling straight across
+    constexpr int ZERO = STEPS / 2;
+    constexpr double STEP =
+        (static_cast<double>(winten_constants::BALL_MAX_THETA) - winten_constants::BALL_MIN_THETA) / (STEPS - 1);
+
+    static_assert(STEPS % 2 == 1 && STEPS <= 65535, "angle steps must be odd and fit 16 bits");
+    static_assert(DRAWS > 0 && (DRAWS & (DRAWS - 1)) == 0, "noise draws must be a power of two");
+
+    /// <summary>
+    ///     Unit vector of a ball moving right at one quantized angle.
+    /// </summary>
+    struct Direction
+    {
+        float angle;
+        float x;
+        float y;
+    };
+
+    /// <summary>
+    ///     The same unit vector in Q16.16 for the fixed-point match core.
+    /// </summary>
+    struct FixedDirection
+    {
+        CFixed x;
+        CFixed y;
+    };
+
+    namespace detail
+    {
+        /// <summary>
+        ///     Unit vector of an angle with both Taylor series summed in one
+        ///     loop, accurate to double precision over the ball's range of
+        ///     angles.
+        /// </summary>
+        constexpr void unitVector(double x, double& cosineSum, double& sineSum)
+        {
+            double square = -x * x;
+            double cosineTerm = 1.0;
+            double sineTerm = x;
+
+            cosineSum = 1.0;
+            sineSum = x;
+            for (int n = 1; n < 12; n++)
+            {
+                double even = 2.0 * n;
+                cosineTerm *= square / ((even - 1.0) * even);
+                sineTerm *= square / (even * (even + 1.0));
+                cosineSum += cosineTerm;
+                sineSum += sineTerm;
+            }
+        }
+
+        constexpr double sine(double x)
+        {
+            double cosineSum = 0.0;
+            double sineSum = 0.0;
+            unitVector(x, cosineSum, sineSum);
+            return sineSum;
+        }
+
+        constexpr double cosine(double x)
+        {
+            double cosineSum = 0.0;
+            double sineSum = 0.0;
+            unitVector(x, cosineSum, sineSum);
+            return cosineSum;
+        }
+
+        constexpr double tangent(double x)
+        {
+            return sine(x) / cosine(x);
+        }
+
+        constexpr double absolute(double x)
+        {
+            return x < 0.0 ? -x : x;
+        }
+
+        /// <summary>
+        ///     Angle of a grid step in radians.
+        /// </summary>
+        constexpr double angle(int step)
+        {
+            return winten_constants::BALL_MIN_THETA + step * STEP;
+        }
+
+        /// <summary>
+        ///     Noise at the centre of a draw's share of the noise range.
+        /// </summary>
+        constexpr double noise(int draw)
+        {
+            return winten_constants::BALL_ANGLE_NOISE * (draw + 0.5) / DRAWS;
+        }
+
+        /// <summary>
+        ///     Exact angle after a paddle hit: mirrored, plus the draw's
+        ///     noise, then clamped.
+        /// </summary>
+        constexpr double exactHit(double incoming, double drawNoise)
+        {
+            double result = -incoming + drawNoise;
+            if (result > winten_constants::BALL_MAX_THETA)
+                result = winten_constants::BALL_MAX_THETA;
+            if (result < winten_constants::BALL_MIN_THETA)
+                result = winten_constants::BALL_MIN_THETA;
+            return result;
+        }
+
+        /// <summary>
+        ///     Nearest grid step to an angle within the ball's range.
+        /// </summary>
+        constexpr int quantize(double angle)
+        {
+            return static_cast<int>((angle - winten_constants::BALL_MIN_THETA) / STEP + 0.5);
+        }
+    }
+
+    // Grid steps generated by each constant expression. Compilers cap the
+    // work of one evaluation, so the table is built a run of steps at a time
+    constexpr int RUN_STEPS = 16;
+    constexpr int RUNS = (STEPS + RUN_STEPS - 1) / RUN_STEPS;
+
+    /// <summary>
+    ///     Directions and hits of one run of grid steps, with the worst
+    ///     errors found building them.
+    /// </summary>
+    struct Rows
+    {
+        Direction directions[RUN_STEPS];
+        FixedDirection fixedDirections[RUN_STEPS];
+        std::uint16_t hits[RUN_STEPS][DRAWS];
+        // Largest distance of a quantized hit from the exact angle, in radians
+        double hitError;
+        // Largest deviation of a direction vector from unit length
+        double normError;
+
+        constexpr Rows(int run)
+            : directions()
+            , fixedDirections()
+            , hits()
+            , hitError(0.0)
+            , normError(0.0)
+        {
+            double noise[DRAWS] = {};
+            for (int draw = 0; draw < DRAWS; draw++)
+                noise[draw] = detail::noise(draw);
+
+            // Every entry is assigned, past the last step too, as compilers
+            // reject a constant with some array entries left unset
+            for (int index = 0; index < RUN_STEPS; index++)
+            {
+                int step = run * RUN_STEPS + index;
+                double angle = detail::angle(step < STEPS ? step : STEPS - 1);
+                double x = 0.0;
+                double y = 0.0;
+                detail::unitVector(angle, x, y);
+                double norm = detail::absolute(x * x + y * y - 1.0);
+
+                directions[index].angle = static_cast<float>(angle);
+                directions[index].x = static_cast<float>(x);
+                directions[index].y = static_cast<float>(y);
+                normError = norm > normError ? norm : normError;
+
+                // Fixed-point directions are rounded from the upper half and
+                // negated for the lower, so a mirrored angle is exactly the
+                // mirrored vector whatever the rounding of the grid angles
+                if (step < ZERO)
+                {
+                    double mirrorX = 0.0;
+                    double mirrorY = 0.0;
+                    detail::unitVector(detail::angle(STEPS - 1 - step), mirrorX, mirrorY);
+                    fixedDirections[index].x = CFixed(mirrorX);
+                    fixedDirections[index].y = -CFixed(mirrorY);
+                }
+                else
+                {
+                    fixedDirections[index].x = CFixed(x);
+                    fixedDirections[index].y = step == ZERO ? CFixed() : CFixed(y);
+                }
+
+                for (int draw = 0; draw < DRAWS; draw++)
+                {
+                    double exact = detail::exactHit(angle, noise[draw]);
+                    int hit = detail::quantize(exact);
+                    double error = detail::absolute(detail::angle(hit) - exact);
+
+                    hits[index][draw] = static_cast<std::uint16_t>(hit);
+                    hitError = error > hitError ? error : hitError;
+                }
+            }
+        }
+    };
+
+    template <int RUN>
+    constexpr Rows ROWS = Rows(RUN);
+
+    /// <summary>
+    ///     The run numbers, each read back from its rows as a template
+    ///     argument so that every run is evaluated on its own rather than
+    ///     inside the evaluation of the whole table.
+    /// </summary>
+    template <typename Sequence>
+    struct Evaluated;
+
+    template <int... RUN>
+    struct Evaluated<std::integer_sequence<int, RUN...>>
+    {
+        using Type = std::integer_sequence<int, (ROWS<RUN>.normError >= 0.0 ? RUN : -1)...>;
+    };
+
+    /// <summary>
+    ///     The generated runs making up the whole grid, with the worst errors
+    ///     found building them.
+    /// </summary>
+    struct Table
+    {
+        Rows runs[RUNS];
+        double hitError;
+        double normError;
+
+        constexpr Table(void)
+            : Table(typename Evaluated<std::make_integer_sequence<int, RUNS>>::Type())
+        {
+        }
+
+        template <int... RUN>
+        constexpr Table(std::integer_sequence<int, RUN...>)
+            : runs{ ROWS<RUN>... }
+            , hitError(0.0)
+            , normError(0.0)
+        {
+            for (int run = 0; run < RUNS; run++)
+            {
+                hitError = runs[run].hitError > hitError ? runs[run].hitError : hitError;
+                normError = runs[run].normError > normError ? runs[run].normError : normError;
+            }
+        }
+
+        /// <summary>
+        ///     FNV-1a hash of the fixed-point directions, to check that every
+        ///     compiler generates the same table.
+        /// </summary>
+        constexpr std::uint32_t fixedChecksum(void) const
+        {
+            std::uint32_t hash = 2166136261u;
+            for (int step = 0; step < STEPS; step++)
+            {
+                const FixedDirection& direction = runs[step / RUN_STEPS].fixedDirections[step % RUN_STEPS];
+                hash = (hash ^ static_cast<std::uint32_t>(direction.x.raw())) * 16777619u;
+                hash = (hash ^ static_cast<std::uint32_t>(direction.y.raw())) * 16777619u;
+            }
+            return hash;
+        }
+    };
+
+    constexpr Table TABLE = Table();
+
+    static_assert(detail::absolute(detail::sine(winten_constants::PI / 6.0) - 0.5) < 1e-6, "sine series is inaccurate");
+    static_assert(detail::absolute(detail::cosine(winten_constants::PI / 3.0) - 0.5) < 1e-6, "cosine series is inaccurate");
+    static_assert(TABLE.normError < 1e-12, "direction vectors are not unit length");
+    static_assert(TABLE.hitError <= STEP / 2.0 + 1e-9, "a hit is more than half a step from its exact angle");
+    // Crossing the whole court after a hit at the steepest angle, where the
+    // error grows fastest, the quantized path stays within a ball of the exact one
+    static_assert(
+        winten_constants::W * (detail::tangent(winten_constants::BALL_MAX_THETA)
+            - detail::tangent(winten_constants::BALL_MAX_THETA - TABLE.hitError))
+            <= winten_constants::BALL_DIAMETER,
+        "angle steps are too coarse for the court size");
+
+#if WINTEN_ANGLE_STEPS == 513 && WINTEN_ANGLE_DRAWS == 8
+    // Replays and lockstep play depend on the fixed-point table being the same
+    // everywhere, so a compiler evaluating the series differently fails here
+    static_assert(TABLE.fixedChecksum() == 0x9D4A59EFu, "fixed-point directions differ from the reference build");
+#endif
+
+    /// <summary>
+    ///     Step of the angle mirrored about the horizontal.
+    /// </summary>
+    /// <param name="step">Grid step.</param>
+    inline int mirror(int step)
+    {
+        return STEPS - 1 - step;
+    }
+
+    /// <summary>
+    ///     Step of the angle after a paddle hit.
+    /// </summary>
+    /// <param name="step">Incoming grid step.</param>
+    /// <param name="random">Random bits choosing the noise draw.</param>
+    inline int hit(int step, std::uint64_t random)
+    {
+        return TABLE.runs[step / RUN_STEPS].hits[step % RUN_STEPS][random & (DRAWS - 1)];
+    }
+
+    /// <summary>
+    ///     Direction of travel of a ball moving right at a grid step.
+    /// </summary>
+    /// <param name="step">Grid step.</param>
+    inline const Direction& direction(int step)
+    {
+        return TABLE.runs[step / RUN_STEPS].directions[step % RUN_STEPS];
+    }
+
+    /// <summary>
+    ///     Fixed-point direction of travel of a ball moving right at a grid step.
+    /// </summary>
+    /// <param name="step">Grid step.</param>
+    inline const FixedDirection& fixedDirection(int step)
+    {
+        return TABLE.runs[step / RUN_STEPS].fixedDirections[step % RUN_STEPS];
+    }
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "ballkernels.hpp"
+
+#if WINTEN_RASTER_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    void advanceFixedScalar(
+        std::int32_t* x,
+        std::int32_t* y,
+        const std::int32_t* stepX,
+        std::int32_t* stepY,
+        int count,
+        std::int32_t top,
+        std::int32_t bottom)
+    {
+        for (int index = 0; index < count; index++)
+        {
+            x[index] += stepX[index];
+            y[index] += stepY[index];
+            if (y[index] > bottom || y[index] < top)
+            {
+                stepY[index] = -stepY[index];
+                y[index] = y[index] < top ? top : bottom;
+            }
+        }
+    }
+
+    void advanceFloatScalar(
+        float* x,
+        float* y,
+        const float* stepX,
+        float* stepY,
+        int count,
+        float top,
+        float bottom)
+    {
+        for (int index = 0; index < count; index++)
+        {
+            x[index] += stepX[index];
+            y[index] += stepY[index];
+            if (y[index] > bottom || y[index] < top)
+            {
+                stepY[index] = -stepY[index];
+                y[index] = y[index] < top ? top : bottom;
+            }
+        }
+    }
+
+#if WINTEN_RASTER_X86
+    WINTEN_TARGET_SSE2 void advanceFixedSSE2(
+        std::int32_t* x,
+        std::int32_t* y,
+        const std::int32_t* stepX,
+        std::int32_t* stepY,
+        int count,
+        std::int32_t top,
+        std::int32_t bottom)
+    {
+        const __m128i topV = _mm_set1_epi32(top);
+        const __m128i bottomV = _mm_set1_epi32(bottom);
+        int index = 0;
+
+        for (; index + 4 <= count; index += 4)
+        {
+            __m128i* px = reinterpret_cast<__m128i*>(x + index);
+            __m128i* py = reinterpret_cast<__m128i*>(y + index);
+            __m128i* pdy = reinterpret_cast<__m128i*>(stepY + index);
+            __m128i dy = _mm_loadu_si128(pdy);
+            __m128i newY = _mm_add_epi32(_mm_loadu_si128(py), dy);
+            __m128i above = _mm_cmplt_epi32(newY, topV);
+            __m128i below = _mm_cmpgt_epi32(newY, bottomV);
+            __m128i out = _mm_or_si128(above, below);
+
+            _mm_storeu_si128(px, _mm_add_epi32(_mm_loadu_si128(px), _mm_loadu_si128(reinterpret_cast<const __m128i*>(stepX + index))));
+            // SSE2 has no blend, so select with masks
+            newY = _mm_or_si128(
+                _mm_andnot_si128(out, newY),
+                _mm_or_si128(_mm_and_si128(above, topV), _mm_and_si128(below, bottomV)));
+            _mm_storeu_si128(py, newY);
+            // Negate where out: (dy ^ mask) - mask
+            _mm_storeu_si128(pdy, _mm_sub_epi32(_mm_xor_si128(dy, out), out));
+        }
+        advanceFixedScalar(x + index, y + index, stepX + index, stepY + index, count - index, top, bottom);
+    }
+
+    WINTEN_TARGET_SSE2 void advanceFloatSSE2(
+        float* x,
+        float* y,
+        const float* stepX,
+        float* stepY,
+        int count,
+        float top,
+        float bottom)
+    {
+        const __m128 topV = _mm_set1_ps(top);
+        const __m128 bottomV = _mm_set1_ps(bottom);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        int index = 0;
+
+        for (; index + 4 <= count; index += 4)
+        {
+            __m128 dy = _mm_loadu_ps(stepY + index);
+            __m128 newY = _mm_add_ps(_mm_loadu_ps(y + index), dy);
+            __m128 out = _mm_or_ps(_mm_cmplt_ps(newY, topV), _mm_cmpgt_ps(newY, bottomV));
+
+            _mm_storeu_ps(x + index, _mm_add_ps(_mm_loadu_ps(x + index), _mm_loadu_ps(stepX + index)));
+            _mm_storeu_ps(y + index, _mm_min_ps(_mm_max_ps(newY, topV), bottomV));
+            _mm_storeu_ps(stepY + index, _mm_xor_ps(dy, _mm_and_ps(out, sign)));
+        }
+        advanceFloatScalar(x + index, y + index, stepX + index, stepY + index, count - index, top, bottom);
+    }
+
+    WINTEN_TARGET_AVX2 void advanceFixedAVX2(
+        std::int32_t* x,
+        std::int32_t* y,
+        const std::int32_t* stepX,
+        std::int32_t* stepY,
+        int count,
+        std::int32_t top,
+        std::int32_t bottom)
+    {
+        const __m256i topV = _mm256_set1_epi32(top);
+        const __m256i bottomV = _mm256_set1_epi32(bottom);
+        int index = 0;
+
+        for (; index + 8 <= count; index += 8)
+        {
+            __m256i* px = reinterpret_cast<__m256i*>(x + index);
+            __m256i* py = reinterpret_cast<__m256i*>(y + index);
+            __m256i* pdy = reinterpret_cast<__m256i*>(stepY + index);
+            __m256i dy = _mm256_loadu_si256(pdy);
+            __m256i newY = _mm256_add_epi32(_mm256_loadu_si256(py), dy);
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(topV, newY), _mm256_cmpgt_epi32(newY, bottomV));
+
+            _mm256_storeu_si256(px, _mm256_add_epi32(_mm256_loadu_si256(px), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stepX + index))));
+            _mm256_storeu_si256(py, _mm256_min_epi32(_mm256_max_epi32(newY, topV), bottomV));
+            _mm256_storeu_si256(pdy, _mm256_sub_epi32(_mm256_xor_si256(dy, out), out));
+        }
+        advanceFixedScalar(x + index, y + index, stepX + index, stepY + index, count - index, top, bottom);
+    }
+
+    WINTEN_TARGET_AVX2 void advanceFloatAVX2(
+        float* x,
+        float* y,
+        const float* stepX,
+        float* stepY,
+        int count,
+        float top,
+        float bottom)
+    {
+        const __m256 topV = _mm256_set1_ps(top);
+        const __m256 bottomV = _mm256_set1_ps(bottom);
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        int index = 0;
+
+        for (; index + 8 <= count; index += 8)
+        {
+            __m256 dy = _mm256_loadu_ps(stepY + index);
+            __m256 newY = _mm256_add_ps(_mm256_loadu_ps(y + index), dy);
+            __m256 out = _mm256_or_ps(_mm256_cmp_ps(newY, topV, _CMP_LT_OQ), _mm256_cmp_ps(newY, bottomV, _CMP_GT_OQ));
+
+            _mm256_storeu_ps(x + index, _mm256_add_ps(_mm256_loadu_ps(x + index), _mm256_loadu_ps(stepX + index)));
+            _mm256_storeu_ps(y + index, _mm256_min_ps(_mm256_max_ps(newY, topV), bottomV));
+            _mm256_storeu_ps(stepY + index, _mm256_xor_ps(dy, _mm256_and_ps(out, sign)));
+        }
+        advanceFloatScalar(x + index, y + index, stepX + index, stepY + index, count - index, top, bottom);
+    }
+#endif
+}
+
+namespace ball_kernels {
+    const BallKernels SCALAR = { "scalar", advanceFixedScalar, advanceFloatScalar };
+#if WINTEN_RASTER_X86
+    const BallKernels SSE2 = { "sse2", advanceFixedSSE2, advanceFloatSSE2 };
+    const BallKernels AVX2 = { "avx2", advanceFixedAVX2, advanceFloatAVX2 };
+#endif
+
+    /// <summary>
+    ///     Get every variant the processor supports.
+    /// </summary>
+    /// <returns>Variants ordered slowest first.</returns>
+    std::vector<const BallKernels*> supported(void)
+    {
+        std::vector<const BallKernels*> variants;
+
+        variants.push_back(&SCALAR);
+#if WINTEN_RASTER_X86
+        if (raster_kernels::cpuSupportsSSE2())
+            variants.push_back(&SSE2);
+        if (raster_kernels::cpuSupportsAVX2())
+            variants.push_back(&AVX2);
+#endif
+        return variants;
+    }
+}
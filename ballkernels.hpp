@@ -0,0 +1,68 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_BALLKERNELS_HPP
+#define WINTEN_BALLKERNELS_HPP
+
+// Include external header files
+#include <cstdint>
+#include <vector>
+
+// Include project header files
+#include "rasterkernels.hpp"
+
+/// <summary>
+///     Ball movement kernels over many balls stored coordinate by coordinate,
+///     one frame per call: each step is added to its position, and a ball past
+///     the top or bottom is clamped there with its vertical step negated, as
+///     systems::movement and systems::collision do for one ball. The fixed-point
+///     form takes Q16.16 raw values and every variant gives identical results;
+///     the float form is there to compare throughput.
+/// </summary>
+struct BallKernels
+{
+    const char* name;
+
+    void (*advanceFixed)(
+        std::int32_t* x,
+        std::int32_t* y,
+        const std::int32_t* stepX,
+        std::int32_t* stepY,
+        int count,
+        std::int32_t top,
+        std::int32_t bottom);
+
+    void (*advanceFloat)(
+        float* x,
+        float* y,
+        const float* stepX,
+        float* stepY,
+        int count,
+        float top,
+        float bottom);
+};
+
+namespace ball_kernels {
+    extern const BallKernels SCALAR;
+#if WINTEN_RASTER_X86
+    extern const BallKernels SSE2;
+    extern const BallKernels AVX2;
+#endif
+
+    // All variants this CPU supports, slowest first
+    std::vector<const BallKernels*> supported(void);
+}
+
+#endif
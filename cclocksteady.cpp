@@ -0,0 +1,38 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <chrono>
+
+// Include project header files
+#include "cclocksteady.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+CClockSteady::CClockSteady(void)
+    : m_origin(std::chrono::steady_clock::now())
+{
+}
+
+/// <summary>
+///     Get the current time.
+/// </summary>
+/// <returns>Nanoseconds since the clock was created.</returns>
+std::int64_t CClockSteady::now(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_origin).count();
+}
@@ -0,0 +1,39 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CCLOCKSTEADY_HPP
+#define WINTEN_CCLOCKSTEADY_HPP
+
+// Include external header files
+#include <chrono>
+#include <cstdint>
+
+// Include project header files
+#include "iclock.hpp"
+
+/// <summary>
+///     Real-time clock backed by std::chrono::steady_clock.
+/// </summary>
+class CClockSteady : public IClock
+{
+private:
+    std::chrono::steady_clock::time_point m_origin;
+
+public:
+    CClockSteady(void);
+    std::int64_t now(void) override;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "cclockvirtual.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+CClockVirtual::CClockVirtual(void)
+    : m_time(0)
+{
+}
+
+/// <summary>
+///     Get the simulated time.
+/// </summary>
+/// <returns>Nanoseconds advanced since creation.</returns>
+std::int64_t CClockVirtual::now(void)
+{
+    return m_time;
+}
+
+/// <summary>
+///     Move simulated time forward.
+/// </summary>
+/// <param name="delta">Nanoseconds to advance.</param>
+void CClockVirtual::advance(std::int64_t delta)
+{
+    m_time += delta;
+}
@@ -0,0 +1,39 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CCLOCKVIRTUAL_HPP
+#define WINTEN_CCLOCKVIRTUAL_HPP
+
+// Include external header files
+#include <cstdint>
+
+// Include project header files
+#include "iclock.hpp"
+
+/// <summary>
+///     Simulated clock which only moves when advanced, for headless runs.
+/// </summary>
+class CClockVirtual : public IClock
+{
+private:
+    std::int64_t m_time;
+
+public:
+    CClockVirtual(void);
+    std::int64_t now(void) override;
+    void advance(std::int64_t delta);
+};
+
+#endif
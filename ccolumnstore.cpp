@@ -0,0 +1,657 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Include project header files
+#include "ccolumnstore.hpp"
+
+const std::uint32_t CColumnStore::BLOCK_ROWS;
+const std::uint32_t CColumnStore::SEGMENT_BLOCKS;
+const std::size_t CColumnStore::MAX_SEGMENTS;
+const std::size_t CColumnStore::SEGMENT_ALIGN;
+
+namespace
+{
+    const char MAGIC[4] = { 'W', 'T', 'C', '1' };
+
+    /// <summary>
+    ///     Round up to a multiple of a power of two.
+    /// </summary>
+    std::size_t roundUp(std::size_t value, std::size_t multiple)
+    {
+        return (value + multiple - 1) & ~(multiple - 1);
+    }
+
+    /// <summary>
+    ///     Bytes of one value of a column type.
+    /// </summary>
+    std::size_t width(ColumnType type)
+    {
+        return type == COLUMN_UINT64 ? 8 : 4;
+    }
+
+    /// <summary>
+    ///     Type used to sum a column: exact 64-bit integers for 32-bit
+    ///     integers, double otherwise.
+    /// </summary>
+    template <typename V>
+    struct SumType
+    {
+        typedef double Type;
+    };
+
+    template <>
+    struct SumType<std::int32_t>
+    {
+        typedef std::int64_t Type;
+    };
+
+    /// <summary>
+    ///     Smallest and largest of a run of values.
+    /// </summary>
+    template <typename V>
+    void extremes(const V* values, std::size_t count, double& minimum, double& maximum)
+    {
+        V low = values[0];
+        V high = values[0];
+
+        for (std::size_t row = 1; row < count; row++)
+        {
+            low = values[row] < low ? values[row] : low;
+            high = values[row] > high ? values[row] : high;
+        }
+        minimum = static_cast<double>(low);
+        maximum = static_cast<double>(high);
+    }
+
+    /// <summary>
+    ///     Add a run of values, or those selected by a mask, to an aggregate.
+    ///     Four independent sums keep the additions from waiting on each
+    ///     other, and the selection is applied by arithmetic, not branches.
+    /// </summary>
+    template <typename V>
+    void reduce(const V* values, const std::uint8_t* mask, std::size_t count, ColumnAggregate& result)
+    {
+        typedef typename SumType<V>::Type Sum;
+        const V none = std::numeric_limits<V>::lowest();
+        const V all = std::numeric_limits<V>::max();
+        Sum sums[4] = { 0, 0, 0, 0 };
+        V low = all;
+        V high = none;
+        std::uint64_t selected = 0;
+        std::size_t row = 0;
+
+        if (mask == nullptr)
+        {
+            for (; row + 4 <= count; row += 4)
+            {
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    V value = values[row + lane];
+                    sums[lane] += static_cast<Sum>(value);
+                    low = value < low ? value : low;
+                    high = value > high ? value : high;
+                }
+            }
+            for (; row < count; row++)
+            {
+                sums[0] += static_cast<Sum>(values[row]);
+                low = values[row] < low ? values[row] : low;
+                high = values[row] > high ? values[row] : high;
+            }
+            selected = count;
+        }
+        else
+        {
+            for (; row < count; row++)
+            {
+                V value = values[row];
+                bool chosen = mask[row] != 0;
+                sums[row & 3] += static_cast<Sum>(chosen ? value : V(0));
+                low = chosen && value < low ? value : low;
+                high = chosen && value > high ? value : high;
+                selected += mask[row];
+            }
+        }
+
+        if (selected == 0)
+            return;
+        if (result.count == 0 || static_cast<double>(low) < result.minimum)
+            result.minimum = static_cast<double>(low);
+        if (result.count == 0 || static_cast<double>(high) > result.maximum)
+            result.maximum = static_cast<double>(high);
+        result.sum += static_cast<double>(sums[0] + sums[1] + sums[2] + sums[3]);
+        result.count += selected;
+    }
+
+    /// <summary>
+    ///     Mark the values of a run lying in an inclusive range.
+    /// </summary>
+    template <typename V>
+    void select(const V* values, std::size_t count, double low, double high, std::uint8_t* mask)
+    {
+        for (std::size_t row = 0; row < count; row++)
+        {
+            double value = static_cast<double>(values[row]);
+            mask[row] = static_cast<std::uint8_t>((value >= low) & (value <= high));
+        }
+    }
+}
+
+/// <summary>
+///     Class constructor, laying out a block for the columns.
+/// </summary>
+/// <param name="columns">Columns and their offsets in a record.</param>
+/// <param name="count">Number of columns.</param>
+CColumnStore::CColumnStore(const ColumnSpec* columns, int count)
+    : m_columns(columns, columns + count)
+    , m_widths()
+    , m_offsets()
+    , m_blockBytes(0)
+    , m_schema(14695981039346656037ull)
+    , m_writable(false)
+    , m_reserved(0)
+    , m_written(0)
+    , m_limit(std::numeric_limits<std::uint64_t>::max())
+    , m_segments(new std::atomic<char*>[MAX_SEGMENTS])
+    , m_growMutex()
+    , m_mappedSegments(0)
+    , m_fileSize(0)
+    , m_header(nullptr)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE)
+#else
+    , m_file(-1)
+#endif
+{
+    // Each column starts on a cache line after the header and summaries
+    std::size_t offset = roundUp(sizeof(BlockHeader) + sizeof(Summary) * m_columns.size(), 64);
+    for (const ColumnSpec& column : m_columns)
+    {
+        m_widths.push_back(width(column.type));
+        m_offsets.push_back(offset);
+        offset = roundUp(offset + m_widths.back() * BLOCK_ROWS, 64);
+
+        // The schema hash covers the names and types in order
+        for (const char* name = column.name; *name != '\0'; name++)
+            m_schema = (m_schema ^ static_cast<std::uint8_t>(*name)) * 1099511628211ull;
+        m_schema = (m_schema ^ column.type) * 1099511628211ull;
+    }
+    m_blockBytes = roundUp(offset, 4096);
+
+    for (std::size_t index = 0; index < MAX_SEGMENTS; index++)
+        m_segments[index].store(nullptr, std::memory_order_relaxed);
+}
+
+/// <summary>
+///     Class destructor, closing the file.
+/// </summary>
+CColumnStore::~CColumnStore()
+{
+    close();
+}
+
+/// <summary>
+///     Map part of the file.
+/// </summary>
+/// <param name="offset">Offset, a multiple of SEGMENT_ALIGN.</param>
+/// <param name="size">Bytes to map.</param>
+/// <returns>The address, or nullptr on failure.</returns>
+char* CColumnStore::mapRange(std::uint64_t offset, std::size_t size)
+{
+#ifdef _WIN32
+    std::uint64_t end = offset + size;
+    HANDLE mapping = CreateFileMappingA(
+        m_file,
+        nullptr,
+        m_writable ? PAGE_READWRITE : PAGE_READONLY,
+        static_cast<DWORD>(end >> 32),
+        static_cast<DWORD>(end),
+        nullptr);
+    if (mapping == nullptr)
+        return nullptr;
+    void* address = MapViewOfFile(
+        mapping,
+        m_writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+        static_cast<DWORD>(offset >> 32),
+        static_cast<DWORD>(offset),
+        size);
+    // The view keeps the mapping alive
+    CloseHandle(mapping);
+    return static_cast<char*>(address);
+#else
+    void* address = mmap(
+        nullptr,
+        size,
+        m_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+        MAP_SHARED,
+        m_file,
+        static_cast<off_t>(offset));
+    return address == MAP_FAILED ? nullptr : static_cast<char*>(address);
+#endif
+}
+
+/// <summary>
+///     Unmap part of the file mapped by mapRange.
+/// </summary>
+void CColumnStore::unmapRange(char* address, std::size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(address);
+#else
+    munmap(address, size);
+#endif
+}
+
+/// <summary>
+///     Grow the file.
+/// </summary>
+/// <param name="size">New size in bytes.</param>
+/// <returns>False on failure.</returns>
+bool CColumnStore::resize(std::uint64_t size)
+{
+#ifdef _WIN32
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN) && SetEndOfFile(m_file);
+#else
+    return ftruncate(m_file, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+/// <summary>
+///     Open or create a store. A store opened for writing appends after the
+///     rows it already holds.
+/// </summary>
+/// <param name="path">File path.</param>
+/// <param name="writable">True to append, creating the file if needed.</param>
+/// <returns>False if it could not be opened or has other columns.</returns>
+bool CColumnStore::open(const std::string& path, bool writable)
+{
+    std::uint64_t size;
+
+    close();
+    m_writable = writable;
+#ifdef _WIN32
+    m_file = CreateFileA(
+        path.c_str(),
+        writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        writable ? OPEN_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(m_file, &fileSize);
+    size = static_cast<std::uint64_t>(fileSize.QuadPart);
+#else
+    struct stat status;
+    m_file = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (m_file < 0)
+        return false;
+    fstat(m_file, &status);
+    size = static_cast<std::uint64_t>(status.st_size);
+#endif
+
+    // A new file starts with just its header
+    bool created = size == 0;
+    if (created && (!writable || !resize(SEGMENT_ALIGN)))
+    {
+        close();
+        return false;
+    }
+    m_fileSize = std::max<std::uint64_t>(size, SEGMENT_ALIGN);
+    m_header = reinterpret_cast<FileHeader*>(mapRange(0, SEGMENT_ALIGN));
+    if (m_header == nullptr)
+    {
+        close();
+        return false;
+    }
+    if (created)
+    {
+        std::memcpy(m_header->magic, MAGIC, sizeof(MAGIC));
+        m_header->columns = static_cast<std::uint32_t>(m_columns.size());
+        m_header->schema = m_schema;
+        m_header->rows = 0;
+    }
+    else if (std::memcmp(m_header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || m_header->columns != m_columns.size()
+        || m_header->schema != m_schema)
+    {
+        close();
+        return false;
+    }
+    m_reserved = m_header->rows;
+    m_written = m_header->rows;
+    m_limit = std::numeric_limits<std::uint64_t>::max();
+
+    // The last block is summarized again once appending finishes
+    if (writable && m_header->rows % BLOCK_ROWS != 0)
+    {
+        BlockHeader* last = reinterpret_cast<BlockHeader*>(block(m_header->rows / BLOCK_ROWS));
+        last->sealed.store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/// <summary>
+///     Summarize a partly filled last block, record the row count and unmap
+///     the file. Every append must have returned.
+/// </summary>
+void CColumnStore::close(void)
+{
+    std::uint64_t rows = std::min(m_written.load(), m_limit.load());
+    std::size_t segmentBytes = m_blockBytes * SEGMENT_BLOCKS;
+
+    if (m_header != nullptr && m_writable)
+    {
+        if (rows % BLOCK_ROWS != 0)
+            seal(block(rows / BLOCK_ROWS), static_cast<std::uint32_t>(rows % BLOCK_ROWS));
+        m_header->rows = rows;
+    }
+    for (std::size_t index = 0; index < m_mappedSegments; index++)
+    {
+        char* address = m_segments[index].exchange(nullptr);
+        if (address != nullptr)
+            unmapRange(address, segmentBytes);
+    }
+    m_mappedSegments = 0;
+    m_fileSize = 0;
+    if (m_header != nullptr)
+        unmapRange(reinterpret_cast<char*>(m_header), SEGMENT_ALIGN);
+    m_header = nullptr;
+    m_reserved = 0;
+    m_written = 0;
+    m_limit = std::numeric_limits<std::uint64_t>::max();
+#ifdef _WIN32
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_file >= 0)
+        ::close(m_file);
+    m_file = -1;
+#endif
+}
+
+/// <summary>
+///     Get a mapped segment, growing the file and mapping it on first use.
+/// </summary>
+/// <param name="index">Segment index.</param>
+/// <returns>Its address, or nullptr if it could not be mapped.</returns>
+char* CColumnStore::segment(std::uint64_t index)
+{
+    std::size_t segmentBytes = m_blockBytes * SEGMENT_BLOCKS;
+    char* address;
+
+    if (index >= MAX_SEGMENTS)
+        return nullptr;
+    address = m_segments[index].load(std::memory_order_acquire);
+    if (address != nullptr)
+        return address;
+
+    // Only a writer reaching a new segment waits here
+    std::lock_guard<std::mutex> lock(m_growMutex);
+    address = m_segments[index].load(std::memory_order_relaxed);
+    if (address != nullptr)
+        return address;
+
+    std::uint64_t offset = SEGMENT_ALIGN + index * segmentBytes;
+    if (offset + segmentBytes > m_fileSize)
+    {
+        if (!m_writable || !resize(offset + segmentBytes))
+            return nullptr;
+        m_fileSize = offset + segmentBytes;
+    }
+    address = mapRange(offset, segmentBytes);
+    if (address != nullptr)
+    {
+        m_mappedSegments = std::max(m_mappedSegments, static_cast<std::size_t>(index + 1));
+        m_segments[index].store(address, std::memory_order_release);
+    }
+    return address;
+}
+
+/// <summary>
+///     Get the address of a block.
+/// </summary>
+/// <param name="index">Block index.</param>
+/// <returns>Its address, or nullptr if it could not be mapped.</returns>
+char* CColumnStore::block(std::uint64_t index)
+{
+    char* base = segment(index / SEGMENT_BLOCKS);
+    return base == nullptr ? nullptr : base + (index % SEGMENT_BLOCKS) * m_blockBytes;
+}
+
+/// <summary>
+///     Record the extremes of each column of a block and mark it summarized.
+/// </summary>
+/// <param name="address">Block address.</param>
+/// <param name="rows">Rows in the block.</param>
+void CColumnStore::seal(char* address, std::uint32_t rows)
+{
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(address);
+    Summary* summaries = reinterpret_cast<Summary*>(address + sizeof(BlockHeader));
+
+    // Wait for the block's other writers to finish their rows
+    std::atomic_thread_fence(std::memory_order_acquire);
+    for (std::size_t column = 0; column < m_columns.size(); column++)
+    {
+        const char* values = address + m_offsets[column];
+        Summary& summary = summaries[column];
+        switch (m_columns[column].type)
+        {
+        case COLUMN_INT32:
+            extremes(reinterpret_cast<const std::int32_t*>(values), rows, summary.minimum, summary.maximum);
+            break;
+        case COLUMN_UINT64:
+            extremes(reinterpret_cast<const std::uint64_t*>(values), rows, summary.minimum, summary.maximum);
+            break;
+        default:
+            extremes(reinterpret_cast<const float*>(values), rows, summary.minimum, summary.maximum);
+        }
+    }
+    header->rows = rows;
+    header->sealed.store(1, std::memory_order_release);
+}
+
+/// <summary>
+///     Append a row from a record, safe from any number of threads. The
+///     thread counting in a block's last row summarizes it.
+/// </summary>
+/// <param name="record">Record holding each column at its offset.</param>
+/// <returns>False if the row could not be stored as the table is full.</returns>
+bool CColumnStore::append(const void* record)
+{
+    std::uint64_t row = m_reserved.fetch_add(1, std::memory_order_relaxed);
+    std::size_t slot = static_cast<std::size_t>(row % BLOCK_ROWS);
+    if (row >= m_limit.load(std::memory_order_relaxed))
+        return false;
+    char* address = block(row / BLOCK_ROWS);
+    if (address == nullptr)
+    {
+        // Refuse the rest of the segment and beyond, so the rows stored
+        // stay a run from the start
+        std::uint64_t first = row / BLOCK_ROWS / SEGMENT_BLOCKS * SEGMENT_BLOCKS * BLOCK_ROWS;
+        std::uint64_t limit = m_limit.load(std::memory_order_relaxed);
+        while (first < limit && !m_limit.compare_exchange_weak(limit, first, std::memory_order_relaxed))
+        {
+        }
+        return false;
+    }
+
+    for (std::size_t column = 0; column < m_columns.size(); column++)
+        std::memcpy(
+            address + m_offsets[column] + slot * m_widths[column],
+            static_cast<const char*>(record) + m_columns[column].offset,
+            m_widths[column]);
+
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(address);
+    if (header->committed.fetch_add(1, std::memory_order_acq_rel) + 1 == BLOCK_ROWS)
+        seal(address, BLOCK_ROWS);
+    m_written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/// <summary>
+///     Number of rows appended.
+/// </summary>
+std::uint64_t CColumnStore::rows(void) const
+{
+    return m_written;
+}
+
+/// <summary>
+///     Number of leading rows of a block a query may read. Rows are counted
+///     in out of order, so the rows reserved in the block are all written
+///     only once as many have been counted in. Reading the count before the
+///     reservations makes that test safe while appends go on. A block still
+///     being written is retried briefly, then treated as empty.
+/// </summary>
+/// <param name="index">Block index.</param>
+/// <param name="header">The block's header.</param>
+/// <returns>Rows to read, all written.</returns>
+std::uint32_t CColumnStore::written(std::uint64_t index, const BlockHeader* header)
+{
+    const int RETRIES = 16;
+    std::uint64_t first = index * BLOCK_ROWS;
+
+    for (int attempt = 0; attempt < RETRIES; attempt++)
+    {
+        std::uint32_t committed = header->committed.load(std::memory_order_acquire);
+        std::uint64_t rows = std::min(m_reserved.load(), m_limit.load());
+        std::uint32_t count = rows > first
+            ? static_cast<std::uint32_t>(std::min<std::uint64_t>(BLOCK_ROWS, rows - first))
+            : 0;
+        if (committed >= count)
+            return count;
+        std::this_thread::yield();
+    }
+    return 0;
+}
+
+/// <summary>
+///     Find a column by name.
+/// </summary>
+/// <param name="name">Column name.</param>
+/// <returns>Its index, or -1.</returns>
+int CColumnStore::column(const char* name) const
+{
+    for (std::size_t index = 0; index < m_columns.size(); index++)
+    {
+        if (std::strcmp(m_columns[index].name, name) == 0)
+            return static_cast<int>(index);
+    }
+    return -1;
+}
+
+/// <summary>
+///     Count, sum and find the extremes of a column over every row, or the
+///     rows passing a filter. Blocks whose summary puts them wholly outside
+///     the filter are skipped and those wholly inside need no filtering, so
+///     only the blocks straddling its bounds read the filter column.
+/// </summary>
+/// <param name="column">Column to aggregate.</param>
+/// <param name="filter">Range filter, or nullptr for every row.</param>
+/// <returns>The aggregate.</returns>
+ColumnAggregate CColumnStore::aggregate(int column, const ColumnFilter* filter)
+{
+    ColumnAggregate result;
+    std::uint64_t rows = std::min(m_reserved.load(), m_limit.load());
+    std::uint64_t blocks = (rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    std::vector<std::uint8_t> mask(BLOCK_ROWS);
+
+    if (column < 0 || column >= static_cast<int>(m_columns.size())
+        || (filter != nullptr && (filter->column < 0 || filter->column >= static_cast<int>(m_columns.size()))))
+        return result;
+
+    for (std::uint64_t index = 0; index < blocks; index++)
+    {
+        char* address = block(index);
+        if (address == nullptr)
+            break;
+        const BlockHeader* header = reinterpret_cast<const BlockHeader*>(address);
+        // Stop at the first block with rows not yet written
+        std::size_t count = written(index, header);
+        if (count == 0)
+            break;
+        const Summary* summaries = reinterpret_cast<const Summary*>(address + sizeof(BlockHeader));
+        bool summarized = header->sealed.load(std::memory_order_acquire) != 0 && header->rows == count;
+        const std::uint8_t* selection = nullptr;
+
+        if (filter != nullptr)
+        {
+            const Summary& summary = summaries[filter->column];
+            bool inside = summarized && summary.minimum >= filter->low && summary.maximum <= filter->high;
+            if (summarized && (summary.maximum < filter->low || summary.minimum > filter->high))
+            {
+                result.blocksSkipped++;
+                continue;
+            }
+            if (!inside)
+            {
+                const char* values = address + m_offsets[filter->column];
+                switch (m_columns[filter->column].type)
+                {
+                case COLUMN_INT32:
+                    select(reinterpret_cast<const std::int32_t*>(values), count, filter->low, filter->high, mask.data());
+                    break;
+                case COLUMN_UINT64:
+                    select(reinterpret_cast<const std::uint64_t*>(values), count, filter->low, filter->high, mask.data());
+                    break;
+                default:
+                    select(reinterpret_cast<const float*>(values), count, filter->low, filter->high, mask.data());
+                }
+                selection = mask.data();
+                result.bytesRead += count * m_widths[filter->column];
+            }
+        }
+
+        const char* values = address + m_offsets[column];
+        switch (m_columns[column].type)
+        {
+        case COLUMN_INT32:
+            reduce(reinterpret_cast<const std::int32_t*>(values), selection, count, result);
+            break;
+        case COLUMN_UINT64:
+            reduce(reinterpret_cast<const std::uint64_t*>(values), selection, count, result);
+            break;
+        default:
+            reduce(reinterpret_cast<const float*>(values), selection, count, result);
+        }
+        result.bytesRead += count * m_widths[column];
+        result.blocksScanned++;
+    }
+    return result;
+}
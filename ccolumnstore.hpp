@@ -0,0 +1,177 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CCOLUMNSTORE_HPP
+#define WINTEN_CCOLUMNSTORE_HPP
+
+// Include external header files
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+///     Fixed-width column value types.
+/// </summary>
+enum ColumnType : std::uint8_t
+{
+    COLUMN_INT32,
+    COLUMN_UINT64,
+    COLUMN_FLOAT
+};
+
+/// <summary>
+///     A column and where its value is found in a record structure.
+/// </summary>
+struct ColumnSpec
+{
+    const char* name;
+    ColumnType type;
+    std::size_t offset;
+};
+
+/// <summary>
+///     Rows whose value of one column, converted to double, lies in an
+///     inclusive range.
+/// </summary>
+struct ColumnFilter
+{
+    int column;
+    double low;
+    double high;
+};
+
+/// <summary>
+///     Count, sum and extremes of a column over the selected rows, with how
+///     many blocks had to be read.
+/// </summary>
+struct ColumnAggregate
+{
+    std::uint64_t count;
+    double sum;
+    double minimum;
+    double maximum;
+    std::uint64_t blocksScanned;
+    std::uint64_t blocksSkipped;
+    std::uint64_t bytesRead;
+
+    ColumnAggregate(void)
+        : count(0)
+        , sum(0)
+        , minimum(0)
+        , maximum(0)
+        , blocksScanned(0)
+        , blocksSkipped(0)
+        , bytesRead(0) {}
+
+    double mean(void) const
+    {
+        return count > 0 ? sum / count : 0.0;
+    }
+};
+
+/// <summary>
+///     Append-only table of fixed-width columns in a memory-mapped file. Rows
+///     are grouped into blocks of BLOCK_ROWS, each holding every column of its
+///     rows contiguously after a header of the block's row count and the
+///     minimum and maximum of each column, so a query reads only the columns
+///     it needs and skips blocks the summaries rule out. Writers on any number
+///     of threads reserve rows with an atomic counter and count them in with
+///     another per block; whichever completes a block summarizes it. Queries
+///     only read rows which have been counted in. The file is mapped a
+///     segment of blocks at a time, and only growing it by a segment takes a
+///     lock. Once a segment cannot be mapped the table is full, and no row
+///     from that segment on is stored.
+/// </summary>
+class CColumnStore
+{
+private:
+    // File header, the first SEGMENT_ALIGN bytes of the file
+    struct FileHeader
+    {
+        char magic[4];
+        std::uint32_t columns;
+        std::uint64_t schema;
+        std::uint64_t rows;
+    };
+
+    // Block header, followed by a summary per column then the columns
+    struct BlockHeader
+    {
+        std::atomic<std::uint32_t> committed;
+        std::atomic<std::uint32_t> sealed;
+        std::uint32_t rows;
+        std::uint32_t reserved;
+    };
+
+    struct Summary
+    {
+        double minimum;
+        double maximum;
+    };
+
+    std::vector<ColumnSpec> m_columns;
+    std::vector<std::size_t> m_widths;
+    // Offset of each column within a block, and the size of a block
+    std::vector<std::size_t> m_offsets;
+    std::size_t m_blockBytes;
+    std::uint64_t m_schema;
+    bool m_writable;
+    std::atomic<std::uint64_t> m_reserved;
+    // Rows written, and the first row which cannot be stored
+    std::atomic<std::uint64_t> m_written;
+    std::atomic<std::uint64_t> m_limit;
+    // Mapped segments, published once mapped
+    std::unique_ptr<std::atomic<char*>[]> m_segments;
+    std::mutex m_growMutex;
+    std::size_t m_mappedSegments;
+    std::uint64_t m_fileSize;
+    FileHeader* m_header;
+#ifdef _WIN32
+    void* m_file;
+#else
+    int m_file;
+#endif
+
+    char* mapRange(std::uint64_t offset, std::size_t size);
+    void unmapRange(char* address, std::size_t size);
+    bool resize(std::uint64_t size);
+    char* block(std::uint64_t index);
+    char* segment(std::uint64_t index);
+    void seal(char* address, std::uint32_t rows);
+    std::uint32_t written(std::uint64_t index, const BlockHeader* header);
+
+public:
+    static const std::uint32_t BLOCK_ROWS = 4096;
+    static const std::uint32_t SEGMENT_BLOCKS = 16;
+    static const std::size_t MAX_SEGMENTS = 65536;
+    static const std::size_t SEGMENT_ALIGN = 65536;
+
+    CColumnStore(const ColumnSpec* columns, int count);
+    ~CColumnStore();
+    CColumnStore(const CColumnStore&) = delete;
+    CColumnStore& operator=(const CColumnStore&) = delete;
+    bool open(const std::string& path, bool writable);
+    void close(void);
+    bool append(const void* record);
+    std::uint64_t rows(void) const;
+    int column(const char* name) const;
+    ColumnAggregate aggregate(int column, const ColumnFilter* filter);
+};
+
+#endif
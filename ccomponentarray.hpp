@@ -0,0 +1,147 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CCOMPONENTARRAY_HPP
+#define WINTEN_CCOMPONENTARRAY_HPP
+
+// Include external header files
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Include project header files
+#include "components.hpp"
+
+/// <summary>
+///     Sparse set of one component type. Components are packed densely in
+///     insertion order for iteration, with a sparse map from entity to slot
+///     for lookup. Removal moves the last component into the gap.
+/// </summary>
+template <typename T>
+class CComponentArray
+{
+private:
+    static const int NONE = -1;
+
+    std::vector<T> m_dense;
+    std::vector<Entity> m_entities;
+    std::vector<int> m_sparse;
+
+public:
+    /// <summary>
+    ///     Add or replace an entity's component.
+    /// </summary>
+    /// <param name="entity">Entity to add to.</param>
+    /// <param name="component">Component value.</param>
+    /// <returns>The stored component.</returns>
+    T& add(Entity entity, const T& component)
+    {
+        if (entity >= m_sparse.size())
+            m_sparse.resize(entity + 1, NONE);
+        if (m_sparse[entity] != NONE)
+            return m_dense[m_sparse[entity]] = component;
+
+        m_sparse[entity] = static_cast<int>(m_dense.size());
+        m_dense.push_back(component);
+        m_entities.push_back(entity);
+        return m_dense.back();
+    }
+
+    /// <summary>
+    ///     Remove an entity's component if it has one.
+    /// </summary>
+    void remove(Entity entity)
+    {
+        if (!has(entity))
+            return;
+
+        int slot = m_sparse[entity];
+        Entity moved = m_entities.back();
+        m_dense[slot] = std::move(m_dense.back());
+        m_entities[slot] = moved;
+        m_sparse[moved] = slot;
+        m_sparse[entity] = NONE;
+        m_dense.pop_back();
+        m_entities.pop_back();
+    }
+
+    /// <summary>
+    ///     Whether an entity has this component.
+    /// </summary>
+    bool has(Entity entity) const
+    {
+        return entity < m_sparse.size() && m_sparse[entity] != NONE;
+    }
+
+    /// <summary>
+    ///     Component of an entity, which must have one.
+    /// </summary>
+    T& get(Entity entity)
+    {
+        return m_dense[m_sparse[entity]];
+    }
+
+    const T& get(Entity entity) const
+    {
+        return m_dense[m_sparse[entity]];
+    }
+
+    /// <summary>
+    ///     Component of an entity, or nullptr.
+    /// </summary>
+    T* find(Entity entity)
+    {
+        return has(entity) ? &m_dense[m_sparse[entity]] : nullptr;
+    }
+
+    const T* find(Entity entity) const
+    {
+        return has(entity) ? &m_dense[m_sparse[entity]] : nullptr;
+    }
+
+    /// <summary>
+    ///     Number of components.
+    /// </summary>
+    std::size_t size(void) const
+    {
+        return m_dense.size();
+    }
+
+    /// <summary>
+    ///     Component in dense slot order.
+    /// </summary>
+    T& operator [](std::size_t slot)
+    {
+        return m_dense[slot];
+    }
+
+    const T& operator [](std::size_t slot) const
+    {
+        return m_dense[slot];
+    }
+
+    /// <summary>
+    ///     Entity owning the component in a dense slot.
+    /// </summary>
+    Entity entity(std::size_t slot) const
+    {
+        return m_entities[slot];
+    }
+};
+
+template <typename T>
+const int CComponentArray<T>::NONE;
+
+#endif
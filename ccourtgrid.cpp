@@ -0,0 +1,273 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Include project header files
+#include "ccourtgrid.hpp"
+#include "cstatedemo.hpp"
+#include "systems.hpp"
+#include "tracing.hpp"
+#include "winten_constants.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock clock;
+
+    // String table entry of the cost overlay
+    const int TEXT_GRID_STATS = 0;
+
+    /// <summary>
+    ///     Nanoseconds between two clock readings.
+    /// </summary>
+    std::int64_t elapsed(clock::time_point start, clock::time_point end)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+}
+
+/// <summary>
+///     Class constructor, starting a demo match on every court.
+/// </summary>
+/// <param name="columns">Courts across.</param>
+/// <param name="rows">Courts down.</param>
+CCourtGrid::CCourtGrid(int columns, int rows)
+    : m_columns(columns)
+    , m_rows(rows)
+    , m_scale(1.0f / std::max(columns, rows))
+    , m_frames(0)
+    , m_updateTime(0)
+    , m_buildTime(0)
+    , m_drawTime(0)
+{
+    // Centre the grid on the field keeping each court's aspect ratio
+    m_xOrigin = (winten_constants::W - m_columns * winten_constants::W * m_scale) / 2.0f;
+    m_yOrigin = (winten_constants::H - m_rows * winten_constants::H * m_scale) / 2.0f;
+
+    for (int index = 0; index < m_columns * m_rows; index++)
+        m_courts.push_back(std::unique_ptr<IState>(new CStateDemo()));
+    m_list.setString(TEXT_GRID_STATS, "");
+}
+
+/// <summary>
+///     Top left corner of a court in field coordinates.
+/// </summary>
+/// <param name="court">Row-major court index.</param>
+RenderInstance CCourtGrid::origin(int court) const
+{
+    RenderInstance position = {
+        m_xOrigin + (court % m_columns) * winten_constants::W * m_scale,
+        m_yOrigin + (court / m_columns) * winten_constants::H * m_scale };
+    return position;
+}
+
+/// <summary>
+///     Advance every match, applying any state transitions.
+/// </summary>
+/// <param name="deltaT">Time step in nanoseconds.</param>
+void CCourtGrid::update(std::int64_t deltaT)
+{
+    WINTEN_TRACE_ZONE("CCourtGrid::update");
+    clock::time_point start = clock::now();
+
+    // Learned paddles across all courts are evaluated in batches
+    m_worlds.clear();
+    for (std::unique_ptr<IState>& court : m_courts)
+        m_worlds.push_back(&court->world);
+    systems::decide(m_worlds.data(), static_cast<int>(m_worlds.size()));
+
+    for (std::unique_ptr<IState>& court : m_courts)
+    {
+        std::unique_ptr<IState> next = court->update(deltaT, false, false, false, false);
+        if (next)
+            court = std::move(next);
+    }
+    m_updateTime += elapsed(start, clock::now());
+}
+
+/// <summary>
+///     Build the frame: each kind of shape across all courts as one instanced
+///     command, and an overlay of the cost per court.
+/// </summary>
+/// <returns>The frame's render list, valid until the next build.</returns>
+const CRenderList& CCourtGrid::build(void)
+{
+    WINTEN_TRACE_ZONE("CCourtGrid::build");
+    clock::time_point start = clock::now();
+    GridStats stats = getStats();
+    char text[96];
+
+    m_list.clear();
+    for (Batch& batch : m_batches)
+        batch.positions.clear();
+
+    // Sort every court's shapes into batches, normally just paddles and balls
+    for (int index = 0; index < static_cast<int>(m_courts.size()); index++)
+    {
+        const CRegistry& world = m_courts[index]->world;
+        RenderInstance corner = origin(index);
+
+        for (std::size_t slot = 0; slot < world.renders.size(); slot++)
+        {
+            const Render& render = world.renders[slot];
+            const Position& position = world.positions.get(world.renders.entity(slot));
+            Batch* batch = nullptr;
+
+            for (Batch& candidate : m_batches)
+                if (candidate.shape == render.shape
+                    && candidate.colour == render.colour
+                    && candidate.width == render.width
+                    && candidate.height == render.height)
+                    batch = &candidate;
+            if (batch == nullptr)
+            {
+                m_batches.push_back(Batch());
+                batch = &m_batches.back();
+                batch->shape = render.shape;
+                batch->colour = render.colour;
+                batch->width = render.width;
+                batch->height = render.height;
+            }
+
+            RenderInstance instance = {
+                corner.x + (position.x - render.width / 2.0f) * m_scale,
+                corner.y + (position.y - render.height / 2.0f) * m_scale };
+            batch->positions.push_back(instance);
+        }
+    }
+    for (const Batch& batch : m_batches)
+    {
+        if (batch.positions.empty())
+            continue;
+        if (batch.shape == RENDER_SHAPE_RECT)
+            m_list.fillRects(
+                batch.positions.data(),
+                static_cast<int>(batch.positions.size()),
+                batch.width * m_scale,
+                batch.height * m_scale,
+                batch.colour);
+        else
+            m_list.fillEllipses(
+                batch.positions.data(),
+                static_cast<int>(batch.positions.size()),
+                batch.width * m_scale,
+                batch.height * m_scale,
+                batch.colour);
+    }
+
+    std::snprintf(
+        text,
+        sizeof(text),
+        "%d COURTS  UPDATE %.0f NS  DRAW %.0f NS PER COURT",
+        stats.courts,
+        stats.update,
+        stats.build + stats.draw);
+    m_list.setString(TEXT_GRID_STATS, text);
+    m_list.text(
+        TEXT_GRID_STATS,
+        winten_constants::FIELD_BORDER,
+        0.0f,
+        winten_constants::FIELD_BORDER,
+        winten_constants::COLOUR_FOREGROUND);
+
+    m_buildTime += elapsed(start, clock::now());
+    return m_list;
+}
+
+/// <summary>
+///     Draw the last built frame, recording the view's cost.
+/// </summary>
+/// <param name="view">View initialized with this grid's courts.</param>
+void CCourtGrid::draw(IView& view)
+{
+    clock::time_point start = clock::now();
+
+    view.DrawAll(m_list);
+    m_drawTime += elapsed(start, clock::now());
+    m_frames++;
+}
+
+/// <summary>
+///     Build the static background of every court, each as one instance of
+///     the normal court's rectangles.
+/// </summary>
+/// <param name="list">List to append the courts to.</param>
+void CCourtGrid::buildCourts(CRenderList& list) const
+{
+    std::vector<RenderInstance> outer;
+    std::vector<RenderInstance> inner;
+
+    for (int index = 0; index < static_cast<int>(m_courts.size()); index++)
+    {
+        RenderInstance corner = origin(index);
+        RenderInstance field = {
+            corner.x + winten_constants::FIELD_BORDER * m_scale,
+            corner.y + winten_constants::FIELD_BORDER * m_scale };
+        outer.push_back(corner);
+        inner.push_back(field);
+    }
+    list.fillRects(
+        outer.data(),
+        static_cast<int>(outer.size()),
+        winten_constants::W * m_scale,
+        winten_constants::H * m_scale,
+        winten_constants::COLOUR_FOREGROUND);
+    list.fillRects(
+        inner.data(),
+        static_cast<int>(inner.size()),
+        (winten_constants::W - 2.0f * winten_constants::FIELD_BORDER) * m_scale,
+        (winten_constants::H - 2.0f * winten_constants::FIELD_BORDER) * m_scale,
+        winten_constants::COLOUR_BACKGROUND);
+}
+
+/// <summary>
+///     Number of courts.
+/// </summary>
+int CCourtGrid::courtCount(void) const
+{
+    return static_cast<int>(m_courts.size());
+}
+
+/// <summary>
+///     Match state of a court.
+/// </summary>
+/// <param name="index">Row-major court index.</param>
+const IState& CCourtGrid::court(int index) const
+{
+    return *m_courts[index];
+}
+
+/// <summary>
+///     Get the mean cost per court of each stage of a frame.
+/// </summary>
+/// <returns>The statistics.</returns>
+GridStats CCourtGrid::getStats(void) const
+{
+    GridStats stats;
+    double frameCourts = static_cast<double>(m_frames) * m_courts.size();
+
+    stats.courts = static_cast<int>(m_courts.size());
+    stats.frames = m_frames;
+    if (frameCourts > 0)
+    {
+        stats.update = m_updateTime / frameCourts;
+        stats.build = m_buildTime / frameCourts;
+        stats.draw = m_drawTime / frameCourts;
+    }
+    return stats;
+}
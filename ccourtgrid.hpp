@@ -0,0 +1,108 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CCOURTGRID_HPP
+#define WINTEN_CCOURTGRID_HPP
+
+// Include external header files
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Include project header files
+#include "istate.hpp"
+#include "iview.hpp"
+#include "renderlist.hpp"
+
+/// <summary>
+///     Per-frame cost of a court grid, in mean nanoseconds per court.
+/// </summary>
+struct GridStats
+{
+    int courts;
+    std::uint64_t frames;
+    double update;
+    double build;
+    double draw;
+
+    GridStats(void)
+        : courts(0)
+        , frames(0)
+        , update(0)
+        , build(0)
+        , draw(0) {}
+
+    /// <summary>
+    ///     Total mean nanoseconds per court per frame.
+    /// </summary>
+    double total(void) const
+    {
+        return update + build + draw;
+    }
+};
+
+/// <summary>
+///     A grid of simultaneous matches drawn into one view. Every court is
+///     driven by its own state, all courts share one static background, and
+///     each frame draws every shape of the same kind, such as all paddles or
+///     all balls, as one instanced command.
+/// </summary>
+class CCourtGrid
+{
+private:
+    /// <summary>
+    ///     Every instance of one shape, size and colour across all courts.
+    /// </summary>
+    struct Batch
+    {
+        RenderShape shape;
+        std::uint32_t colour;
+        float width;
+        float height;
+        std::vector<RenderInstance> positions;
+    };
+
+    int m_columns;
+    int m_rows;
+    std::vector<std::unique_ptr<IState>> m_courts;
+    // Every court's registry, for deciding their policy paddles together
+    std::vector<CRegistry*> m_worlds;
+    // Court layout: scale of one court and position of the top left court
+    float m_scale;
+    float m_xOrigin;
+    float m_yOrigin;
+    // Frame and instance batches, reused between frames
+    CRenderList m_list;
+    std::vector<Batch> m_batches;
+    // Accumulated cost in nanoseconds
+    std::uint64_t m_frames;
+    std::int64_t m_updateTime;
+    std::int64_t m_buildTime;
+    std::int64_t m_drawTime;
+
+    RenderInstance origin(int court) const;
+
+public:
+    CCourtGrid(int columns, int rows);
+    void update(std::int64_t deltaT);
+    const CRenderList& build(void);
+    void draw(IView& view);
+    void buildCourts(CRenderList& list) const;
+    int courtCount(void) const;
+    const IState& court(int index) const;
+    GridStats getStats(void) const;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CEVENTRING_HPP
+#define WINTEN_CEVENTRING_HPP
+
+// Include external header files
+#include <cstdint>
+
+// Include project header files
+#include "components.hpp"
+
+/// <summary>
+///     Kinds of game event.
+/// </summary>
+enum GameEventType : std::uint8_t
+{
+    // A ball bounced off the top or bottom, value is its new angle step
+    EVENT_WALL_BOUNCE,
+    // A ball hit a paddle or obstacle, other is the box and value the ball's
+    // new angle step
+    EVENT_PADDLE_HIT,
+    // A ball reached an end, value is the Side scoring
+    EVENT_SCORE,
+    // The state is ending, value is the GameState entered
+    EVENT_TRANSITION,
+    EVENT_TYPE_COUNT
+};
+
+/// <summary>
+///     States a transition event can enter.
+/// </summary>
+enum GameState
+{
+    GAME_STATE_INTRO,
+    GAME_STATE_DEMO,
+    GAME_STATE_GAME
+};
+
+/// <summary>
+///     One event, stamped with the tick of the registry it happened in.
+/// </summary>
+struct GameEvent
+{
+    std::uint32_t tick;
+    GameEventType type;
+    // Ball the event is about and any box it hit, the ball again if none,
+    // both zero for transitions
+    Entity entity;
+    Entity other;
+    int value;
+};
+
+/// <summary>
+///     Read position of one consumer of an event ring.
+/// </summary>
+struct EventCursor
+{
+    std::uint64_t next;
+    // Events overwritten before this consumer read them
+    std::uint64_t lost;
+};
+
+/// <summary>
+///     Fixed-capacity ring of the events of a registry. Systems and states push
+///     events as they happen; consumers such as statistics or replays each
+///     keep a cursor and read what was pushed since, normally after every tick,
+///     with no allocation or callback. Pushing does nothing while no consumer
+///     is subscribed, and overwrites the oldest events if one falls behind.
+/// </summary>
+class CEventRing
+{
+public:
+    static const std::uint32_t CAPACITY = 64;
+
+private:
+    GameEvent m_events[CAPACITY];
+    std::uint64_t m_written;
+    std::uint32_t m_tick;
+    int m_readers;
+
+public:
+    CEventRing(void)
+        : m_written(0)
+        , m_tick(0)
+        , m_readers(0) {}
+
+    /// <summary>
+    ///     Start stamping events with the next tick.
+    /// </summary>
+    void beginTick(void)
+    {
+        m_tick++;
+    }
+
+    /// <summary>
+    ///     Whether any consumer is subscribed.
+    /// </summary>
+    bool enabled(void) const
+    {
+        return m_readers > 0;
+    }
+
+    /// <summary>
+    ///     Record an event if anyone is listening.
+    /// </summary>
+    void push(GameEventType type, Entity entity, Entity other, int value)
+    {
+        if (m_readers == 0)
+            return;
+
+        GameEvent& event = m_events[m_written++ % CAPACITY];
+        event.tick = m_tick;
+        event.type = type;
+        event.entity = entity;
+        event.other = other;
+        event.value = value;
+    }
+
+    /// <summary>
+    ///     Start consuming events from now on.
+    /// </summary>
+    /// <returns>Cursor to read with.</returns>
+    EventCursor subscribe(void)
+    {
+        EventCursor cursor = { m_written, 0 };
+        m_readers++;
+        return cursor;
+    }
+
+    /// <summary>
+    ///     Stop consuming, so pushing is free again once nobody is left.
+    /// </summary>
+    void unsubscribe(void)
+    {
+        if (m_readers > 0)
+            m_readers--;
+    }
+
+    /// <summary>
+    ///     Read the next event of a consumer, skipping any overwritten.
+    /// </summary>
+    /// <param name="cursor">Consumer's cursor, advanced past the event.</param>
+    /// <returns>The event, or nullptr if the consumer is up to date.</returns>
+    const GameEvent* next(EventCursor& cursor) const
+    {
+        if (cursor.next == m_written)
+            return nullptr;
+        if (m_written - cursor.next > CAPACITY)
+        {
+            cursor.lost += m_written - cursor.next - CAPACITY;
+            cursor.next = m_written - CAPACITY;
+        }
+        return &m_events[cursor.next++ % CAPACITY];
+    }
+};
+
+#endif
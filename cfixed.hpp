@@ -0,0 +1,162 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CFIXED_HPP
+#define WINTEN_CFIXED_HPP
+
+// Include external header files
+#include <cstdint>
+
+/// <summary>
+///     Q16.16 fixed-point number: a signed 32-bit integer counting 1/65536ths.
+///     Arithmetic is integer only, products and quotients truncating towards
+///     zero, so results are identical on every compiler, flag and processor,
+///     and negation commutes with multiplication as mirrored motion requires.
+///     The range is about +/-32768, ample for field coordinates. Conversion
+///     from floating point rounds to nearest and is exact in double for any
+///     float, so even that is repeatable.
+/// </summary>
+class CFixed
+{
+private:
+    std::int32_t m_raw;
+
+public:
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr std::int32_t ONE = 1 << FRACTION_BITS;
+
+    /// <summary>
+    ///     Construct zero.
+    /// </summary>
+    constexpr CFixed(void)
+        : m_raw(0)
+    {
+    }
+
+    /// <summary>
+    ///     Convert a whole number.
+    /// </summary>
+    explicit constexpr CFixed(int value)
+        : m_raw(value * ONE)
+    {
+    }
+
+    /// <summary>
+    ///     Convert from floating point, rounding half away from zero.
+    /// </summary>
+    explicit constexpr CFixed(double value)
+        : m_raw(static_cast<std::int32_t>(value * ONE + (value < 0.0 ? -0.5 : 0.5)))
+    {
+    }
+
+    /// <summary>
+    ///     Construct from a count of 1/65536ths.
+    /// </summary>
+    static constexpr CFixed fromRaw(std::int32_t raw)
+    {
+        CFixed result;
+        result.m_raw = raw;
+        return result;
+    }
+
+    constexpr std::int32_t raw(void) const
+    {
+        return m_raw;
+    }
+
+    explicit constexpr operator float(void) const
+    {
+        return static_cast<float>(m_raw) * (1.0f / ONE);
+    }
+
+    constexpr CFixed operator -(void) const
+    {
+        return fromRaw(-m_raw);
+    }
+
+    constexpr CFixed operator +(CFixed other) const
+    {
+        return fromRaw(m_raw + other.m_raw);
+    }
+
+    constexpr CFixed operator -(CFixed other) const
+    {
+        return fromRaw(m_raw - other.m_raw);
+    }
+
+    constexpr CFixed operator *(CFixed other) const
+    {
+        return fromRaw(static_cast<std::int32_t>(static_cast<std::int64_t>(m_raw) * other.m_raw / ONE));
+    }
+
+    constexpr CFixed operator /(CFixed other) const
+    {
+        return fromRaw(static_cast<std::int32_t>(static_cast<std::int64_t>(m_raw) * ONE / other.m_raw));
+    }
+
+    CFixed& operator +=(CFixed other)
+    {
+        m_raw += other.m_raw;
+        return *this;
+    }
+
+    CFixed& operator -=(CFixed other)
+    {
+        m_raw -= other.m_raw;
+        return *this;
+    }
+
+    CFixed& operator *=(CFixed other)
+    {
+        return *this = *this * other;
+    }
+
+    CFixed& operator /=(CFixed other)
+    {
+        return *this = *this / other;
+    }
+
+    constexpr bool operator ==(CFixed other) const
+    {
+        return m_raw == other.m_raw;
+    }
+
+    constexpr bool operator !=(CFixed other) const
+    {
+        return m_raw != other.m_raw;
+    }
+
+    constexpr bool operator <(CFixed other) const
+    {
+        return m_raw < other.m_raw;
+    }
+
+    constexpr bool operator >(CFixed other) const
+    {
+        return m_raw > other.m_raw;
+    }
+
+    constexpr bool operator <=(CFixed other) const
+    {
+        return m_raw <= other.m_raw;
+    }
+
+    constexpr bool operator >=(CFixed other) const
+    {
+        return m_raw >= other.m_raw;
+    }
+};
+
+#endif
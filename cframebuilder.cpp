@@ -0,0 +1,171 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <cstdio>
+
+// Include project header files
+#include "cframebuilder.hpp"
+#include "systems.hpp"
+#include "tracing.hpp"
+#include "winten_constants.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+CFrameBuilder::CFrameBuilder(void)
+    : m_list()
+    , m_previousCommands()
+    , m_previousRevisions()
+    , m_changed(true)
+    , m_invalid(true)
+    , m_snapshot()
+    , m_hasSnapshot(false)
+    , m_statsText(true)
+    , m_statsAge(winten_constants::STATS_REFRESH)
+{
+    // Populate the string table so every fixed text id is valid
+    for (int textId = 0; textId < TEXT_ENTITIES; textId++)
+        m_list.setString(textId, "");
+}
+
+/// <summary>
+///     Record where a state's entities are before it is updated, to draw
+///     frames between that update and the next.
+/// </summary>
+/// <param name="state">State about to be updated.</param>
+void CFrameBuilder::snapshot(const IState* state)
+{
+    systems::snapshot(state->world, m_snapshot);
+    m_hasSnapshot = true;
+}
+
+/// <summary>
+///     Draw without interpolation until the next snapshot, e.g. after a
+///     change of state whose entities are unrelated to the last.
+/// </summary>
+void CFrameBuilder::forgetSnapshot(void)
+{
+    m_hasSnapshot = false;
+}
+
+/// <summary>
+///     Build the render list for a state.
+/// </summary>
+/// <param name="state">State to draw.</param>
+/// <param name="fps">Frames per second for display.</param>
+/// <param name="latency">Latency in seconds for display.</param>
+/// <param name="alpha">Fraction of the last tick elapsed, 1 to draw the state as it is.</param>
+/// <returns>The frame's render list, valid until the next build.</returns>
+const CRenderList& CFrameBuilder::build(IState* state, float fps, float latency, float alpha)
+{
+    WINTEN_TRACE_ZONE("CFrameBuilder::build");
+    char text[32];
+
+    // Keep the previous frame for comparison
+    m_previousCommands.assign(m_list.commands().begin(), m_list.commands().end());
+    m_previousRevisions.resize(m_list.stringCount());
+    for (int textId = 0; textId < m_list.stringCount(); textId++)
+        m_previousRevisions[textId] = m_list.revision(textId);
+    m_list.clear();
+
+    // Paddles, balls, scores and messages
+    systems::draw(state->world, m_list, TEXT_ENTITIES, m_hasSnapshot ? &m_snapshot : nullptr, alpha);
+
+    // Text only changes its string table entry when the value changes, so
+    // whole numbers refreshed a few times a second leave most frames unchanged
+    if (m_statsText)
+    {
+        if (fps > 0.0f)
+            m_statsAge += 1.0f / fps;
+        if (m_statsAge >= winten_constants::STATS_REFRESH)
+        {
+            m_statsAge = 0.0f;
+            std::snprintf(text, sizeof(text), "FPS: %.0f", fps);
+            m_list.setString(TEXT_FPS, text);
+            std::snprintf(text, sizeof(text), "LAT: %.0f ms", latency * 1000.0f);
+            m_list.setString(TEXT_LATENCY, text);
+        }
+
+        m_list.text(
+            TEXT_FPS,
+            winten_constants::SCORE_TEXT_NPC,
+            2.0f * winten_constants::SCORE_TEXT_Y,
+            winten_constants::TEXT_SIZE,
+            winten_constants::COLOUR_FOREGROUND);
+        m_list.text(
+            TEXT_LATENCY,
+            winten_constants::SCORE_TEXT_NPC,
+            3.0f * winten_constants::SCORE_TEXT_Y,
+            winten_constants::TEXT_SIZE,
+            winten_constants::COLOUR_FOREGROUND);
+    }
+
+    // Compare against the previous frame
+    m_changed = m_invalid || m_list.commands() != m_previousCommands;
+    for (int textId = 0; textId < m_list.stringCount() && !m_changed; textId++)
+        m_changed = textId >= static_cast<int>(m_previousRevisions.size())
+            || m_list.revision(textId) != m_previousRevisions[textId];
+    m_invalid = false;
+
+    return m_list;
+}
+
+/// <summary>
+///     Whether the last built frame differs from the one before it.
+/// </summary>
+/// <returns>True if the frame needs drawing.</returns>
+bool CFrameBuilder::changed(void) const
+{
+    return m_changed;
+}
+
+/// <summary>
+///     Force the next frame to be reported as changed, e.g. after a resize.
+/// </summary>
+void CFrameBuilder::invalidate(void)
+{
+    m_invalid = true;
+}
+
+/// <summary>
+///     Show or hide the frame rate and latency, from the next frame.
+/// </summary>
+/// <param name="shown">True to show them.</param>
+void CFrameBuilder::setStatsText(bool shown)
+{
+    m_statsText = shown;
+    m_statsAge = winten_constants::STATS_REFRESH;
+}
+
+/// <summary>
+///     Build the static court drawn behind every frame.
+/// </summary>
+/// <param name="list">List to append the court to.</param>
+void CFrameBuilder::buildCourt(CRenderList& list)
+{
+    list.fillRect(
+        0.0f,
+        0.0f,
+        winten_constants::W,
+        winten_constants::H,
+        winten_constants::COLOUR_FOREGROUND);
+    list.fillRect(
+        winten_constants::FIELD_BORDER,
+        winten_constants::FIELD_BORDER,
+        winten_constants::W - 2.0f * winten_constants::FIELD_BORDER,
+        winten_constants::H - 2.0f * winten_constants::FIELD_BORDER,
+        winten_constants::COLOUR_BACKGROUND);
+}
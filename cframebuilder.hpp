@@ -0,0 +1,72 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CFRAMEBUILDER_HPP
+#define WINTEN_CFRAMEBUILDER_HPP
+
+// Include external header files
+#include <cstdint>
+#include <vector>
+
+// Include project header files
+#include "istate.hpp"
+#include "renderlist.hpp"
+#include "systems.hpp"
+
+/// <summary>
+///     String table entries used by the frame builder.
+/// </summary>
+enum FrameText
+{
+    TEXT_FPS,
+    TEXT_LATENCY,
+    // First entry of the state's text elements
+    TEXT_ENTITIES
+};
+
+/// <summary>
+///     Lays out a state as a render list once per frame, so that views only
+///     scale and rasterize commands, and tracks whether the frame changed.
+///     Frames drawn between simulation ticks place moving shapes part way
+///     from a snapshot taken before the last tick.
+/// </summary>
+class CFrameBuilder
+{
+private:
+    CRenderList m_list;
+    // Previous frame for change detection
+    std::vector<RenderCommand> m_previousCommands;
+    std::vector<std::uint32_t> m_previousRevisions;
+    bool m_changed;
+    bool m_invalid;
+    systems::Snapshot<float> m_snapshot;
+    bool m_hasSnapshot;
+    // Whether the frame rate and latency are shown
+    bool m_statsText;
+    // Seconds since the shown frame rate and latency were refreshed
+    float m_statsAge;
+
+public:
+    CFrameBuilder(void);
+    void snapshot(const IState* state);
+    void forgetSnapshot(void);
+    const CRenderList& build(IState* state, float fps, float latency, float alpha);
+    bool changed(void) const;
+    void invalidate(void);
+    void setStatsText(bool shown);
+    static void buildCourt(CRenderList& list);
+};
+
+#endif
@@ -0,0 +1,276 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cstring>
+
+// Include project header files
+#include "cframecapture.hpp"
+#include "tracing.hpp"
+
+/// <summary>
+///     Class constructor, writes the stream header and starts the threads.
+/// </summary>
+/// <param name="file">Open file the stream is written to, not closed by the capture.</param>
+/// <param name="width">Frame width in pixels, must be even.</param>
+/// <param name="height">Frame height in pixels, must be even.</param>
+/// <param name="rateNumerator">Frame rate numerator.</param>
+/// <param name="rateDenominator">Frame rate denominator.</param>
+/// <param name="buffers">Number of frames in flight.</param>
+/// <param name="workers">Number of conversion threads.</param>
+CFrameCapture::CFrameCapture(
+    std::FILE* file,
+    int width,
+    int height,
+    int rateNumerator,
+    int rateDenominator,
+    int buffers,
+    int workers)
+    : m_file(file)
+    , m_width(width)
+    , m_height(height)
+    , m_slots(std::max(buffers, 2))
+    , m_nextSubmit(0)
+    , m_nextConvert(0)
+    , m_nextWrite(0)
+    , m_closing(false)
+    , m_failed(false)
+    , m_stats()
+{
+    std::size_t pixels = static_cast<std::size_t>(m_width) * m_height;
+
+    // Allocate every buffer up front
+    for (Slot& slot : m_slots)
+    {
+        slot.rgb.resize(pixels);
+        slot.yuv.resize(pixels + pixels / 2);
+        slot.state = SLOT_FREE;
+    }
+
+    if (std::fprintf(
+        m_file,
+        "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n",
+        m_width,
+        m_height,
+        rateNumerator,
+        rateDenominator) < 0)
+        m_failed = true;
+
+    for (int index = 0; index < std::max(workers, 1); index++)
+        m_workers.emplace_back(&CFrameCapture::workerLoop, this);
+    m_writer = std::thread(&CFrameCapture::writerLoop, this);
+}
+
+/// <summary>
+///     Class destructor.
+/// </summary>
+CFrameCapture::~CFrameCapture()
+{
+    close();
+}
+
+/// <summary>
+///     Queue a frame for capture. Frames must be submitted from one thread.
+/// </summary>
+/// <param name="pixels">XRGB pixels of the capture's size.</param>
+/// <param name="stride">Pixels per source row.</param>
+/// <param name="blocking">True to wait for a free buffer, false to drop the frame.</param>
+/// <returns>True if the frame was queued.</returns>
+bool CFrameCapture::submit(const std::uint32_t* pixels, int stride, bool blocking)
+{
+    WINTEN_TRACE_ZONE("CFrameCapture::submit");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Slot* slot = &m_slots[m_nextSubmit % m_slots.size()];
+
+    if (m_closing || m_failed)
+        return false;
+
+    // Back-pressure when the ring is full
+    if (slot->state != SLOT_FREE)
+    {
+        if (!blocking)
+        {
+            m_stats.dropped++;
+            return false;
+        }
+        m_stats.stalled++;
+        m_slotFreed.wait(lock, [this, slot] { return m_closing || m_failed || slot->state == SLOT_FREE; });
+        if (m_closing || m_failed)
+            return false;
+    }
+
+    // Copy outside the lock, the slot is owned by this thread until filled
+    lock.unlock();
+    for (int row = 0; row < m_height; row++)
+        std::memcpy(
+            &slot->rgb[static_cast<std::size_t>(row) * m_width],
+            pixels + static_cast<std::size_t>(row) * stride,
+            m_width * sizeof(std::uint32_t));
+    lock.lock();
+
+    slot->state = SLOT_FILLED;
+    m_nextSubmit++;
+    m_stats.submitted++;
+    m_slotFilled.notify_one();
+
+    return true;
+}
+
+/// <summary>
+///     Convert a slot's XRGB pixels to planar full-range YUV 4:2:0.
+/// </summary>
+/// <param name="slot">Slot to convert.</param>
+void CFrameCapture::convert(Slot& slot)
+{
+    WINTEN_TRACE_ZONE("CFrameCapture::convert");
+    std::uint8_t* lumaPlane = slot.yuv.data();
+    std::uint8_t* uPlane = lumaPlane + static_cast<std::size_t>(m_width) * m_height;
+    std::uint8_t* vPlane = uPlane + static_cast<std::size_t>(m_width / 2) * (m_height / 2);
+
+    for (int y = 0; y < m_height; y += 2)
+    {
+        const std::uint32_t* row0 = &slot.rgb[static_cast<std::size_t>(y) * m_width];
+        const std::uint32_t* row1 = row0 + m_width;
+        std::uint8_t* luma0 = lumaPlane + static_cast<std::size_t>(y) * m_width;
+        std::uint8_t* luma1 = luma0 + m_width;
+
+        for (int x = 0; x < m_width; x += 2)
+        {
+            int sumR = 0;
+            int sumG = 0;
+            int sumB = 0;
+            const std::uint32_t quad[4] = { row0[x], row0[x + 1], row1[x], row1[x + 1] };
+            std::uint8_t* luma[4] = { &luma0[x], &luma0[x + 1], &luma1[x], &luma1[x + 1] };
+
+            // BT.601 full range luma per pixel, chroma from the 2x2 average
+            for (int index = 0; index < 4; index++)
+            {
+                int r = (quad[index] >> 16) & 0xFF;
+                int g = (quad[index] >> 8) & 0xFF;
+                int b = quad[index] & 0xFF;
+                *luma[index] = static_cast<std::uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+                sumR += r;
+                sumG += g;
+                sumB += b;
+            }
+            std::size_t chroma = static_cast<std::size_t>(y / 2) * (m_width / 2) + x / 2;
+            uPlane[chroma] = static_cast<std::uint8_t>(((-43 * sumR - 85 * sumG + 128 * sumB + 512) >> 10) + 128);
+            vPlane[chroma] = static_cast<std::uint8_t>(((128 * sumR - 107 * sumG - 21 * sumB + 512) >> 10) + 128);
+        }
+    }
+}
+
+/// <summary>
+///     Conversion thread, takes filled slots in submission order and
+///     converts them concurrently with the other workers.
+/// </summary>
+void CFrameCapture::workerLoop(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_slotFilled.wait(lock, [this] { return m_closing || m_nextConvert != m_nextSubmit; });
+        if (m_nextConvert == m_nextSubmit)
+            return;
+
+        Slot& slot = m_slots[m_nextConvert % m_slots.size()];
+        m_nextConvert++;
+
+        lock.unlock();
+        convert(slot);
+        lock.lock();
+
+        slot.state = SLOT_CONVERTED;
+        m_slotConverted.notify_all();
+    }
+}
+
+/// <summary>
+///     Writer thread, writes converted slots in submission order. After a
+///     write fails the rest are freed unwritten and counted as failed.
+/// </summary>
+void CFrameCapture::writerLoop(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        Slot& slot = m_slots[m_nextWrite % m_slots.size()];
+        m_slotConverted.wait(lock, [this, &slot] {
+            return slot.state == SLOT_CONVERTED || (m_closing && m_nextWrite == m_nextSubmit);
+        });
+        if (slot.state != SLOT_CONVERTED)
+            return;
+
+        bool failed = m_failed;
+        if (!failed)
+        {
+            lock.unlock();
+            failed = std::fputs("FRAME\n", m_file) == EOF
+                || std::fwrite(slot.yuv.data(), 1, slot.yuv.size(), m_file) != slot.yuv.size()
+                || std::ferror(m_file) != 0;
+            lock.lock();
+        }
+
+        slot.state = SLOT_FREE;
+        m_nextWrite++;
+        if (failed)
+        {
+            m_failed = true;
+            m_stats.failed++;
+        }
+        else
+            m_stats.written++;
+        m_slotFreed.notify_all();
+    }
+}
+
+/// <summary>
+///     Write all queued frames and stop the threads.
+/// </summary>
+/// <returns>False if any frame or the final flush could not be written.</returns>
+bool CFrameCapture::close(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closing)
+            return !m_failed;
+        m_closing = true;
+    }
+    m_slotFilled.notify_all();
+    m_slotConverted.notify_all();
+    m_slotFreed.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_writer.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (std::fflush(m_file) != 0 || std::ferror(m_file) != 0)
+        m_failed = true;
+    return !m_failed;
+}
+
+/// <summary>
+///     Get a snapshot of the capture counters.
+/// </summary>
+/// <returns>The counters.</returns>
+CaptureStats CFrameCapture::getStats(void)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,105 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CFRAMECAPTURE_HPP
+#define WINTEN_CFRAMECAPTURE_HPP
+
+// Include external header files
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+///     Capture progress counters.
+/// </summary>
+struct CaptureStats
+{
+    std::uint64_t submitted;
+    std::uint64_t written;
+    // Frames rejected by a non-blocking submit because every buffer was busy
+    std::uint64_t dropped;
+    // Blocking submits which had to wait for a free buffer
+    std::uint64_t stalled;
+    // Frames lost to a write error, from the first failed write on
+    std::uint64_t failed;
+};
+
+/// <summary>
+///     Streams framebuffer frames to a Y4M (YUV 4:2:0) file. Frames are
+///     copied into a fixed ring of reusable buffers, converted to YUV on a
+///     pool of worker threads and written in order by a writer thread. When
+///     the ring is full a submit either waits or drops the frame; it never
+///     allocates.
+/// </summary>
+class CFrameCapture
+{
+private:
+    enum SlotState
+    {
+        SLOT_FREE,
+        SLOT_FILLED,
+        SLOT_CONVERTED
+    };
+
+    struct Slot
+    {
+        std::vector<std::uint32_t> rgb;
+        std::vector<std::uint8_t> yuv;
+        SlotState state;
+    };
+
+    std::FILE* m_file;
+    int m_width;
+    int m_height;
+    std::vector<Slot> m_slots;
+    // Sequence numbers of the next frame to fill, convert and write, the
+    // slots in between holding frames filled or converted in ring order
+    std::uint64_t m_nextSubmit;
+    std::uint64_t m_nextConvert;
+    std::uint64_t m_nextWrite;
+    bool m_closing;
+    // Set by the first failed write, after which nothing more is written
+    bool m_failed;
+    CaptureStats m_stats;
+    std::mutex m_mutex;
+    std::condition_variable m_slotFreed;
+    std::condition_variable m_slotFilled;
+    std::condition_variable m_slotConverted;
+    std::vector<std::thread> m_workers;
+    std::thread m_writer;
+
+    void convert(Slot& slot);
+    void workerLoop(void);
+    void writerLoop(void);
+
+public:
+    CFrameCapture(
+        std::FILE* file,
+        int width,
+        int height,
+        int rateNumerator,
+        int rateDenominator,
+        int buffers,
+        int workers);
+    ~CFrameCapture();
+    bool submit(const std::uint32_t* pixels, int stride, bool blocking);
+    bool close(void);
+    CaptureStats getStats(void);
+};
+
+#endif
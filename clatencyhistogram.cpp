@@ -0,0 +1,183 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+
+// Include project header files
+#include "clatencyhistogram.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+CLatencyHistogram::CLatencyHistogram(void)
+    : m_buckets(static_cast<std::size_t>(SUB_BUCKETS * (64 - SUB_BUCKET_BITS + 1)), 0)
+    , m_count(0)
+    , m_min(0)
+    , m_max(0)
+    , m_total(0)
+{
+}
+
+/// <summary>
+///     Get the bucket holding a value.
+/// </summary>
+/// <param name="value">Non-negative value.</param>
+/// <returns>Bucket index.</returns>
+int CLatencyHistogram::bucket(std::int64_t value)
+{
+    std::uint64_t bits = static_cast<std::uint64_t>(value);
+    int exponent = 0;
+
+    if (bits < SUB_BUCKETS)
+        return static_cast<int>(bits);
+
+    // Position of the highest set bit, at least SUB_BUCKET_BITS here
+    while ((bits >> exponent) > 1)
+        exponent++;
+    int shift = exponent - SUB_BUCKET_BITS;
+    return SUB_BUCKETS * (shift + 1) + static_cast<int>((bits >> shift) & (SUB_BUCKETS - 1));
+}
+
+/// <summary>
+///     Get the largest value held by a bucket.
+/// </summary>
+/// <param name="index">Bucket index.</param>
+/// <returns>Inclusive upper bound.</returns>
+std::int64_t CLatencyHistogram::bucketUpper(int index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+
+    int shift = index / SUB_BUCKETS - 1;
+    std::uint64_t lower = static_cast<std::uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return static_cast<std::int64_t>(lower + (std::uint64_t(1) << shift) - 1);
+}
+
+/// <summary>
+///     Record one duration. Negative durations are recorded as zero.
+/// </summary>
+/// <param name="value">Duration in ticks.</param>
+void CLatencyHistogram::record(std::int64_t value)
+{
+    value = std::max<std::int64_t>(value, 0);
+    m_buckets[bucket(value)]++;
+    m_min = m_count == 0 ? value : std::min(m_min, value);
+    m_max = m_count == 0 ? value : std::max(m_max, value);
+    m_total += static_cast<double>(value);
+    m_count++;
+}
+
+/// <summary>
+///     Add every value recorded by another histogram.
+/// </summary>
+/// <param name="other">Histogram to add.</param>
+void CLatencyHistogram::merge(const CLatencyHistogram& other)
+{
+    if (other.m_count == 0)
+        return;
+    for (std::size_t index = 0; index < m_buckets.size(); index++)
+        m_buckets[index] += other.m_buckets[index];
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = m_count == 0 ? other.m_max : std::max(m_max, other.m_max);
+    m_total += other.m_total;
+    m_count += other.m_count;
+}
+
+/// <summary>
+///     Forget every recorded value.
+/// </summary>
+void CLatencyHistogram::clear(void)
+{
+    std::fill(m_buckets.begin(), m_buckets.end(), 0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_total = 0;
+}
+
+/// <summary>
+///     Number of values recorded.
+/// </summary>
+std::uint64_t CLatencyHistogram::count(void) const
+{
+    return m_count;
+}
+
+/// <summary>
+///     Smallest value recorded, or zero if empty.
+/// </summary>
+std::int64_t CLatencyHistogram::minimum(void) const
+{
+    return m_min;
+}
+
+/// <summary>
+///     Largest value recorded, or zero if empty.
+/// </summary>
+std::int64_t CLatencyHistogram::maximum(void) const
+{
+    return m_max;
+}
+
+/// <summary>
+///     Exact mean of the values recorded, or zero if empty.
+/// </summary>
+double CLatencyHistogram::mean(void) const
+{
+    return m_count > 0 ? m_total / static_cast<double>(m_count) : 0.0;
+}
+
+/// <summary>
+///     Get the value below or at which a fraction of the recorded values lie,
+///     rounded up to the end of its bucket.
+/// </summary>
+/// <param name="fraction">Fraction from 0 to 1, e.g. 0.99.</param>
+/// <returns>Value in ticks, or zero if empty.</returns>
+std::int64_t CLatencyHistogram::percentile(double fraction) const
+{
+    std::uint64_t rank;
+    std::uint64_t seen = 0;
+
+    if (m_count == 0)
+        return 0;
+
+    // Rank of the value sought, counting from one
+    rank = static_cast<std::uint64_t>(std::max(fraction, 0.0) * static_cast<double>(m_count) + 0.5);
+    rank = std::min(std::max<std::uint64_t>(rank, 1), m_count);
+    for (std::size_t index = 0; index < m_buckets.size(); index++)
+    {
+        seen += m_buckets[index];
+        if (seen >= rank)
+            return std::min(std::max(bucketUpper(static_cast<int>(index)), m_min), m_max);
+    }
+    return m_max;
+}
+
+/// <summary>
+///     Number of recorded values in buckets wholly below a value.
+/// </summary>
+/// <param name="value">Value in ticks.</param>
+/// <returns>Count of values.</returns>
+std::uint64_t CLatencyHistogram::countBelow(std::int64_t value) const
+{
+    std::uint64_t result = 0;
+
+    if (value <= 0)
+        return 0;
+    for (int index = 0; index < bucket(value); index++)
+        result += m_buckets[index];
+    return result;
+}
@@ -0,0 +1,57 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CLATENCYHISTOGRAM_HPP
+#define WINTEN_CLATENCYHISTOGRAM_HPP
+
+// Include external header files
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+///     Histogram of non-negative durations in clock ticks. Buckets are exact
+///     below 16 ticks and then split each power of two into 16 linear steps,
+///     so any recorded value is known to within 1/16 of itself and the memory
+///     used is fixed regardless of the range recorded.
+/// </summary>
+class CLatencyHistogram
+{
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    std::vector<std::uint64_t> m_buckets;
+    std::uint64_t m_count;
+    std::int64_t m_min;
+    std::int64_t m_max;
+    double m_total;
+
+    static int bucket(std::int64_t value);
+    static std::int64_t bucketUpper(int index);
+
+public:
+    CLatencyHistogram(void);
+    void record(std::int64_t value);
+    void merge(const CLatencyHistogram& other);
+    void clear(void);
+    std::uint64_t count(void) const;
+    std::int64_t minimum(void) const;
+    std::int64_t maximum(void) const;
+    double mean(void) const;
+    std::int64_t percentile(double fraction) const;
+    std::uint64_t countBelow(std::int64_t value) const;
+};
+
+#endif
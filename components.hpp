@@ -0,0 +1,161 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_COMPONENTS_HPP
+#define WINTEN_COMPONENTS_HPP
+
+// Include external header files
+#include <cstdint>
+#include <string>
+
+// Include project header files
+#include "cfixed.hpp"
+#include "ipolicy.hpp"
+
+/// <summary>
+///     Entity identifier, an index into each component array's sparse map.
+/// </summary>
+typedef std::uint32_t Entity;
+
+/// <summary>
+///     Sides of the court, each with a score.
+/// </summary>
+enum Side
+{
+    SIDE_LEFT,
+    SIDE_RIGHT,
+    SIDE_COUNT
+};
+
+/// <summary>
+///     Centre of a shape, or top left of text, in field coordinates.
+/// </summary>
+template <typename T>
+struct BasicPosition
+{
+    T x;
+    T y;
+};
+
+/// <summary>
+///     Velocity as a speed along a heading. The heading is the angle from
+///     horizontal, turned through half a revolution when travelling left.
+///     The angle is a step of the quantized grid in angletable.hpp.
+/// </summary>
+template <typename T>
+struct BasicVelocity
+{
+    T speed;
+    int angle;
+    bool left;
+};
+
+/// <summary>
+///     Shapes which collide.
+/// </summary>
+enum ColliderShape : std::uint8_t
+{
+    // Paddles and obstacles, which balls bounce off
+    COLLIDER_BOX,
+    // Balls, which bounce off boxes and the field edges
+    COLLIDER_BALL
+};
+
+/// <summary>
+///     Axis aligned extent about the entity's position.
+/// </summary>
+template <typename T>
+struct BasicCollider
+{
+    ColliderShape shape;
+    T width;
+    T height;
+};
+
+/// <summary>
+///     What moves a paddle.
+/// </summary>
+enum ControllerKind : std::uint8_t
+{
+    // Up and down keys
+    CONTROLLER_KEYBOARD,
+    // Follows the nearest ball within a horizontal distance
+    CONTROLLER_TRACKING,
+    // Moved by the registry's learned policy
+    CONTROLLER_POLICY
+};
+
+/// <summary>
+///     Vertical paddle movement.
+/// </summary>
+template <typename T>
+struct BasicController
+{
+    ControllerKind kind;
+    T speed;
+    // Horizontal distance a tracking controller sees the ball from
+    T horizon;
+    // Move of a policy controller chosen ahead of the next control step
+    // by systems::decide, together with other matches
+    bool decided;
+    PolicyAction decision;
+};
+
+/// <summary>
+///     Shapes drawn for an entity.
+/// </summary>
+enum RenderShape : std::uint8_t
+{
+    RENDER_SHAPE_RECT,
+    RENDER_SHAPE_ELLIPSE
+};
+
+/// <summary>
+///     Filled shape centred on the entity's position.
+/// </summary>
+struct Render
+{
+    RenderShape shape;
+    // Colour as 0xAARRGGBB
+    std::uint32_t colour;
+    float width;
+    float height;
+};
+
+/// <summary>
+///     Text drawn at the entity's position, either fixed or showing a score.
+/// </summary>
+struct Text
+{
+    std::string text;
+    // Side whose score is shown, or -1 for the fixed text
+    int scoreSide;
+    float size;
+    std::uint32_t colour;
+};
+
+// Components of the floating-point match core, used for play and drawing
+typedef BasicPosition<float> Position;
+typedef BasicVelocity<float> Velocity;
+typedef BasicCollider<float> Collider;
+typedef BasicController<float> Controller;
+
+// Components of the fixed-point match core, bit-identical on every build
+typedef BasicPosition<CFixed> FixedPosition;
+typedef BasicVelocity<CFixed> FixedVelocity;
+typedef BasicCollider<CFixed> FixedCollider;
+typedef BasicController<CFixed> FixedController;
+
+#endif
@@ -14,8 +14,57 @@
 * this program. If not, see <https://www.gnu.org/licenses/>.
 */
 
+// Include external header files
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 // Include project header files
+#include "cclocksteady.hpp"
 #include "contextcontroller.hpp"
+#include "tracing.hpp"
+#include "winten_constants.hpp"
+
+namespace
+{
+	// Smallest time scale divided by, and longest idle wait in seconds
+	const double MIN_TIME_SCALE = 1.0e-6;
+	const double MAX_IDLE_WAIT = 60.0;
+
+	/// <summary>
+	///		CPU time used by the calling thread in clock ticks.
+	/// </summary>
+	std::int64_t threadCpuTime(void)
+	{
+#ifdef _WIN32
+		FILETIME creation;
+		FILETIME exit;
+		FILETIME kernel;
+		FILETIME user;
+		if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+			return 0;
+		// Kernel and user time in 100 ns units
+		std::uint64_t units =
+			((static_cast<std::uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+			((static_cast<std::uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+		return static_cast<std::int64_t>(static_cast<double>(units) * winten_constants::TICKS_PER_SECOND / 1.0e7);
+#else
+		timespec time;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+			return 0;
+		return static_cast<std::int64_t>(
+			(static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1.0e9) * winten_constants::TICKS_PER_SECOND);
+#endif
+	}
+}
 
 /// <summary>
 ///		Class constructor.
@@ -24,13 +73,49 @@
 ContextController::ContextController(void)
 	: m_state()
 	, m_view()
+	, m_clock(new CClockSteady())
+	, m_frameBuilder()
+	, m_redraw(true)
+	, m_quality()
+	, m_tickPeriod(0)
+	, m_accumulator(0)
+	, m_timeScale(1.0)
+	, m_unthrottled(false)
+	, m_drawInterval(1)
+	, m_wallClock()
+	, m_wallStart(0)
+	, m_simulated(0)
+	, m_updates(0)
+	, m_frames(0)
+	, m_wakeups(0)
+	, m_idleWaits(0)
+	, m_idleTime(0)
+	, m_cpuTime(0)
 	, m_lastTime(0)
+	, m_started(false)
 	, m_latency(0)
+	, m_inputMutex()
 	, m_keyUp(false)
 	, m_keyDown(false)
 	, m_keyEscape(false)
 	, m_keyPressed(false)
+	, m_frame(0)
+	, m_inputs()
+	, m_visible(true)
+	, m_wakeup()
+	, m_resumed(false)
+	, m_applied()
+	, m_latencyMutex()
+	, m_latencyStats()
+	, m_countEvents(false)
+	, m_subscribed(false)
+	, m_eventCursor()
+	, m_eventMutex()
+	, m_eventStats()
+	, m_stop(false)
 {
+	setTickRate(winten_constants::TICK_RATE);
+	resetTimeStats();
 }
 
 /// <summary>
@@ -40,6 +125,76 @@ void ContextController::setView(std::unique_ptr<IView> view)
 {
 	// Replace view
 	this->m_view = std::move(view);
+	if (m_view)
+		m_view->setQuality(m_quality.level());
+}
+
+/// <summary>
+///		Set the clock driving state updates.
+/// </summary>
+/// <param name="clock">Real-time or simulated clock.</param>
+void ContextController::setClock(std::unique_ptr<IClock> clock)
+{
+	m_clock = std::move(clock);
+	m_started = false;
+	m_accumulator = 0;
+}
+
+/// <summary>
+///		Set the simulation rate, independent of the rate frames are drawn.
+/// </summary>
+/// <param name="rate">Ticks per second.</param>
+void ContextController::setTickRate(float rate)
+{
+	m_tickPeriod = static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / static_cast<double>(rate) + 0.5);
+}
+
+/// <summary>
+///		Set how fast simulated time passes relative to the clock, above one to
+///		fast-forward or below for slow motion. Slow motion stays smooth as
+///		frames are drawn between ticks. Scales which are not positive and
+///		finite would run time backwards or stop it, so are ignored.
+/// </summary>
+/// <param name="scale">Simulated seconds per clock second.</param>
+void ContextController::setTimeScale(float scale)
+{
+	if (scale > 0.0f && std::isfinite(scale))
+		m_timeScale = static_cast<double>(scale);
+}
+
+/// <summary>
+///		Run ticks back to back as fast as possible, ignoring the clock and the
+///		scheduler, or return to running on the clock.
+/// </summary>
+/// <param name="unthrottled">True to run unthrottled.</param>
+/// <param name="drawInterval">Draw one frame every this many ticks, or none if zero.</param>
+void ContextController::setUnthrottled(bool unthrottled, int drawInterval)
+{
+	m_drawInterval = drawInterval;
+	m_unthrottled = unthrottled;
+}
+
+/// <summary>
+///		Set the time each frame may take to update and draw, usually the frame
+///		period, stepping rendering quality down to hold it under load and back
+///		up as load eases. Zero keeps full quality.
+/// </summary>
+/// <param name="budget">Budget in clock ticks.</param>
+void ContextController::setFrameBudget(std::int64_t budget)
+{
+	m_quality.setBudget(budget);
+}
+
+/// <summary>
+///		Apply a quality level to the frame layout and the view.
+/// </summary>
+/// <param name="quality">Quality level.</param>
+void ContextController::applyQuality(RenderQuality quality)
+{
+	m_frameBuilder.setStatsText(quality < QUALITY_NO_STATS);
+	m_frameBuilder.invalidate();
+	if (m_view)
+		m_view->setQuality(quality);
 }
 
 /// <summary>
@@ -49,44 +204,239 @@ void ContextController::setView(std::unique_ptr<IView> view)
 void ContextController::transitionTo(std::unique_ptr<IState> state)
 {
 	m_state = std::move(state);
+	// The new state's entities have no past to draw between
+	m_frameBuilder.forgetSnapshot();
+
+	// Count the new state's events from its first tick
+	m_subscribed = m_countEvents && m_state;
+	if (m_subscribed)
+		m_eventCursor = m_state->world.events.subscribe();
 }
 
 /// <summary>
-///		Update the current state.
+///		Count the events the current state pushed since the last call, and
+///		subscribe to or leave its events as counting is turned on or off. The
+///		state's events cost nothing to push while not counted.
 /// </summary>
-/// <param name="thisTime">Current timestamp in seconds.</param>
-void ContextController::update(long double thisTime)
+void ContextController::countEvents(void)
 {
+	CEventRing& events = m_state->world.events;
+	bool enabled = m_countEvents;
+
+	if (m_subscribed)
+	{
+		std::lock_guard<std::mutex> lock(m_eventMutex);
+		std::uint64_t lost = m_eventCursor.lost;
+		while (const GameEvent* event = events.next(m_eventCursor))
+			m_eventStats.counts[event->type]++;
+		m_eventStats.lost += m_eventCursor.lost - lost;
+		m_eventCursor.lost = 0;
+	}
+	if (m_subscribed && !enabled)
+		events.unsubscribe();
+	else if (!m_subscribed && enabled)
+		m_eventCursor = events.subscribe();
+	m_subscribed = enabled;
+}
+
+/// <summary>
+///		Advance the current state to the clock's current time in whole ticks
+///		of the simulation rate, then draw. The simulation runs up to a tick
+///		ahead of the clock, and the frame is drawn the matching fraction of
+///		the way from the snapshot before the last tick, so motion is smooth at
+///		any frame rate and exact when frames and ticks coincide.
+/// </summary>
+void ContextController::update(void)
+{
+	WINTEN_TRACE_ZONE("ContextController::update");
 	std::unique_ptr<IState> nextState;
+	std::int64_t thisTime = m_clock->now();
+	bool keyUp;
+	bool keyDown;
+	bool keyEscape;
+	bool keyPressed;
+	bool unthrottled = m_unthrottled;
+	bool draw;
+	int ticks = 0;
+	std::int64_t firstTick = m_tickPeriod;
+	std::int64_t updateStart;
+	std::int64_t drawStart;
 
 	// Time difference
-	float deltaT = static_cast<float>(thisTime - m_lastTime);
+	std::int64_t deltaT = thisTime - m_lastTime;
+
+	// Ticks needed to reach this frame's scaled time, or exactly one when
+	// unthrottled. Fast-forwarding raises the cap on ticks per frame.
+	if (unthrottled)
+	{
+		m_accumulator = 0;
+		ticks = 1;
+	}
+	// One tick covers an idle wait, the state having had nothing to do
+	else if (m_resumed && m_started)
+	{
+		m_accumulator = 0;
+		ticks = 1;
+		firstTick = static_cast<std::int64_t>(std::llround(static_cast<double>(deltaT) * m_timeScale));
+	}
+	else if (m_started)
+	{
+		std::int64_t limit = static_cast<std::int64_t>(
+			std::ceil(std::max(m_timeScale, 1.0) * winten_constants::MAX_TICKS_PER_FRAME)) * m_tickPeriod;
+
+		m_accumulator += static_cast<std::int64_t>(std::llround(static_cast<double>(deltaT) * m_timeScale));
+		if (m_accumulator > limit)
+			m_accumulator = limit;
+		while (m_accumulator > 0)
+		{
+			m_accumulator -= m_tickPeriod;
+			ticks++;
+		}
+	}
+
+	// Take the key state, and the inputs the ticks of this frame are the first
+	// to reflect. A frame with no tick leaves key presses for the next.
+	{
+		std::lock_guard<std::mutex> lock(m_inputMutex);
+		keyUp = m_keyUp;
+		keyDown = m_keyDown;
+		keyEscape = m_keyEscape;
+		keyPressed = m_keyPressed;
+		m_frame++;
+
+		if (ticks > 0)
+		{
+			std::lock_guard<std::mutex> statsLock(m_latencyMutex);
+			m_keyPressed = false;
+			for (InputEvent& input : m_inputs)
+			{
+				input.frame = m_frame;
+				input.applied = thisTime;
+				m_latencyStats.queued.record(thisTime - input.time);
+			}
+			m_applied.insert(m_applied.end(), m_inputs.begin(), m_inputs.end());
+			m_inputs.clear();
+		}
+	}
 
-	// Update the current state
-	if (m_lastTime != 0)
+	// Unthrottled frames are exactly on a tick, so only a decimated few are
+	// drawn and none need a snapshot to draw between
+	if (unthrottled)
 	{
+		int interval = m_drawInterval;
+		draw = interval > 0 && m_updates % static_cast<std::uint64_t>(interval) == 0;
+	}
+	else
+		draw = true;
+
+	// Update the current state, counting each tick's events before any
+	// transition discards them
+	updateStart = m_wallClock.now();
+	if (ticks > 0)
+		countEvents();
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		WINTEN_TRACE_ZONE("IState::update");
+		if (m_view && !unthrottled)
+			m_frameBuilder.snapshot(m_state.get());
 		nextState = std::move(
 			m_state->update(
-				deltaT,
-				m_keyUp,
-				m_keyDown,
-				m_keyEscape,
-				m_keyPressed
+				tick == 0 ? firstTick : m_tickPeriod,
+				keyUp,
+				keyDown,
+				keyEscape,
+				keyPressed && tick == 0
 			)
 		);
+		if (m_subscribed)
+			countEvents();
 
 		if (nextState.get() != nullptr)
 			this->transitionTo(std::move(nextState));
 	}
+	if (ticks > 0)
+		m_simulated += firstTick + (ticks - 1) * m_tickPeriod;
+	m_updates++;
+	m_resumed = false;
+
+	// Lay out and render the current state, skipping frames identical to the last
+	drawStart = m_wallClock.now();
+	DrawResult result = DRAW_PRESENTED;
+	if (m_view && draw)
+	{
+		if (m_redraw.exchange(false))
+			m_frameBuilder.invalidate();
+		const CRenderList& list = m_frameBuilder.build(
+			m_state.get(),
+			deltaT > 0 ? winten_constants::TICKS_PER_SECOND / static_cast<float>(deltaT) : 0.0f,
+			m_latency,
+			1.0f + static_cast<float>(m_accumulator) / static_cast<float>(m_tickPeriod));
+		if (m_frameBuilder.changed() || m_view->drawsEveryFrame())
+		{
+			{
+				WINTEN_TRACE_ZONE("IView::DrawAll");
+				result = m_view->DrawAll(list);
+			}
+			// A frame the view did not show is drawn again next time, and
+			// its inputs wait for a frame which is presented
+			if (result != DRAW_PRESENTED)
+				m_frameBuilder.invalidate();
+			else
+			{
+				m_frames++;
+				recordPresent(m_clock->now());
+			}
+		}
+	}
+	else if (!m_view)
+		m_applied.clear();
 
-	// Render the current state
-	m_view->DrawAll(m_state.get(), 1.0f / deltaT, m_latency);
+	// Hold the real time spent on this frame to the budget, leaving out
+	// frames the view could not draw while it is resized
+	if (m_view && !unthrottled && result != DRAW_SKIPPED)
+	{
+		std::int64_t drawEnd = m_wallClock.now();
+		if (m_quality.record(drawEnd, drawStart - updateStart, drawEnd - drawStart, result == DRAW_DROPPED))
+			applyQuality(m_quality.level());
+	}
 
 	// Save time for future update
 	m_lastTime = thisTime;
+	m_started = true;
+}
 
-	// Reset key press
-	m_keyPressed = false;
+/// <summary>
+///		Record an input event at the current time. The caller holds the input
+///		mutex.
+/// </summary>
+void ContextController::recordInput(void)
+{
+	InputEvent input = { m_clock->now(), m_frame + 1, 0 };
+	m_inputs.push_back(input);
+}
+
+/// <summary>
+///		Record the latency of every applied input reflected by the frame just
+///		presented. Inputs stay pending while unchanged frames are skipped.
+/// </summary>
+/// <param name="presentTime">Time the view finished drawing.</param>
+void ContextController::recordPresent(std::int64_t presentTime)
+{
+	std::lock_guard<std::mutex> lock(m_latencyMutex);
+	std::size_t kept = 0;
+
+	for (const InputEvent& input : m_applied)
+	{
+		if (input.frame > m_frame)
+		{
+			m_applied[kept++] = input;
+			continue;
+		}
+		m_latencyStats.rendered.record(presentTime - input.applied);
+		m_latencyStats.total.record(presentTime - input.time);
+		m_latency = static_cast<float>(presentTime - input.time) * winten_constants::SECONDS_PER_TICK;
+	}
+	m_applied.resize(kept);
 }
 
 /// <summary>
@@ -95,7 +445,11 @@ void ContextController::update(long double thisTime)
 /// <param name="state">State of the key.</param>
 void ContextController::keyDown(bool state)
 {
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	if (state != m_keyDown)
+		recordInput();
 	m_keyDown = state;
+	m_wakeup.notify_one();
 }
 
 /// <summary>
@@ -104,7 +458,11 @@ void ContextController::keyDown(bool state)
 /// <param name="state">State of the key.</param>
 void ContextController::keyUp(bool state)
 {
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	if (state != m_keyUp)
+		recordInput();
 	m_keyUp = state;
+	m_wakeup.notify_one();
 }
 
 /// <summary>
@@ -113,7 +471,11 @@ void ContextController::keyUp(bool state)
 /// <param name="state">State of the key.</param>
 void ContextController::keyEscape(bool state)
 {
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	if (state != m_keyEscape)
+		recordInput();
 	m_keyEscape = state;
+	m_wakeup.notify_one();
 }
 
 /// <summary>
@@ -122,16 +484,127 @@ void ContextController::keyEscape(bool state)
 /// <param name="">True if any key has been pressed.</param>
 void ContextController::keyPressed(void)
 {
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	// A key which also changed a key state was recorded by that change
+	if (!m_keyPressed && m_inputs.empty())
+		recordInput();
 	m_keyPressed = true;
+	m_wakeup.notify_one();
+}
+
+/// <summary>
+///		Forces the next frame to be drawn even if unchanged.
+/// </summary>
+void ContextController::invalidate(void)
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	m_redraw = true;
+	m_wakeup.notify_one();
+}
+
+/// <summary>
+///		Show or hide the view, such as when the window is minimized. A hidden
+///		view pauses the game loop until shown again.
+/// </summary>
+/// <param name="visible">True if the view can be seen.</param>
+void ContextController::setVisible(bool visible)
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	m_visible = visible;
+	m_wakeup.notify_one();
+}
+
+/// <summary>
+///		Get a snapshot of the input latency histograms.
+/// </summary>
+/// <returns>The histograms.</returns>
+LatencyStats ContextController::getLatencyStats(void) const
+{
+	std::lock_guard<std::mutex> lock(m_latencyMutex);
+	return m_latencyStats;
+}
+
+/// <summary>
+///		Forget the input latencies recorded so far.
+/// </summary>
+void ContextController::resetLatencyStats(void)
+{
+	std::lock_guard<std::mutex> lock(m_latencyMutex);
+	m_latencyStats.queued.clear();
+	m_latencyStats.rendered.clear();
+	m_latencyStats.total.clear();
+}
+
+/// <summary>
+///		Get the simulated and real time covered since the last reset.
+/// </summary>
+/// <returns>The time statistics.</returns>
+TimeStats ContextController::getTimeStats(void) const
+{
+	TimeStats stats;
+
+	stats.simulated = m_simulated;
+	stats.wall = m_wallClock.now() - m_wallStart;
+	stats.updates = m_updates;
+	stats.frames = m_frames;
+	stats.wakeups = m_wakeups;
+	stats.idleWaits = m_idleWaits;
+	stats.idle = m_idleTime;
+	stats.cpu = m_cpuTime;
+	return stats;
+}
+
+/// <summary>
+///		Restart the time statistics from now.
+/// </summary>
+void ContextController::resetTimeStats(void)
+{
+	m_wallStart = m_wallClock.now();
+	m_simulated = 0;
+	m_updates = 0;
+	m_frames = 0;
+	m_wakeups = 0;
+	m_idleWaits = 0;
+	m_idleTime = 0;
+	m_cpuTime = 0;
+}
+
+/// <summary>
+///		Turn counting the states' events on or off, from the next update.
+/// </summary>
+/// <param name="enabled">True to count events.</param>
+void ContextController::setEventStats(bool enabled)
+{
+	m_countEvents = enabled;
 }
 
 /// <summary>
-///		Stores the timestamp after update for performance monitoring.
+///		Get the counts of events seen.
 /// </summary>
-/// <param name="timeAfterUpdate">Timestamp in seconds after update.</param>
-void ContextController::setAfterUpdateTime(long double timeAfterUpdate)
+/// <returns>The statistics.</returns>
+EventStats ContextController::getEventStats(void) const
 {
-	m_latency = static_cast<float>(timeAfterUpdate - m_lastTime);
+	std::lock_guard<std::mutex> lock(m_eventMutex);
+	return m_eventStats;
+}
+
+/// <summary>
+///		Get the frame costs against the budget and the quality transitions
+///		made to hold it.
+/// </summary>
+/// <returns>The statistics.</returns>
+QualityStats ContextController::getQualityStats(void) const
+{
+	return m_quality.getStats();
+}
+
+/// <summary>
+///		Get the current state, for inspection between updates.
+/// </summary>
+/// <returns>The state, or nullptr before the first transition.</returns>
+const IState* ContextController::getState(void) const
+{
+	return m_state.get();
 }
 
 /// <summary>
@@ -147,7 +620,9 @@ void ContextController::initialize(
 	int newWidth,
 	int newHeight)
 {
+	WINTEN_TRACE_ZONE("IView::initialize");
 	m_view->initialize(newXOffset, newYOffset, newWidth, newHeight);
+	invalidate();
 }
 
 /// <summary>
@@ -155,5 +630,108 @@ void ContextController::initialize(
 /// </summary>
 void ContextController::shutdown(void)
 {
+	WINTEN_TRACE_ZONE("IView::shutdown");
 	m_view->shutdown();
+}
+
+/// <summary>
+///		Wait for an event instead of the next deadline while nothing would
+///		change: the state has nothing to do until a timeout further off than a
+///		tick, or the view is hidden. Input, redraws, visibility changes and
+///		stopping end the wait, as does the state's timeout while visible.
+/// </summary>
+/// <returns>True if the loop waited, false if the state needs the next tick.</returns>
+bool ContextController::waitIdle(void)
+{
+	std::unique_lock<std::mutex> lock(m_inputMutex);
+	bool visible = m_visible;
+	std::int64_t timeout = m_state ? m_state->timeout() : 0;
+	std::int64_t start = m_wallClock.now();
+
+	if (!m_view || (visible && (!m_started || timeout <= m_tickPeriod)))
+		return false;
+
+	if (visible)
+	{
+		// The state's timeout runs from its last tick, in simulated time. A
+		// wait cut short by the limit just resumes for one tick.
+		double remaining = static_cast<double>(m_lastTime - m_clock->now()) +
+			static_cast<double>(timeout) / std::max(m_timeScale, MIN_TIME_SCALE);
+		remaining = std::min(std::max(remaining, 0.0), MAX_IDLE_WAIT * winten_constants::TICKS_PER_SECOND);
+		m_wakeup.wait_for(
+			lock,
+			std::chrono::duration<double>(remaining / winten_constants::TICKS_PER_SECOND),
+			[this]() { return m_stop || m_keyPressed || !m_inputs.empty() || m_redraw || !m_visible; });
+		m_resumed = true;
+	}
+	else
+	{
+		// Paused while hidden, keys waiting until shown, then restarting
+		// the clock rather than catching up
+		m_wakeup.wait(lock, [this]() { return m_stop || m_visible; });
+		m_started = false;
+		m_accumulator = 0;
+	}
+
+	m_idleWaits++;
+	m_idleTime += m_wallClock.now() - start;
+	return true;
+}
+
+/// <summary>
+///		Runs the game loop, updating once per scheduler deadline, or back to
+///		back while unthrottled, until stopped. While nothing would change the
+///		loop sleeps until an event instead.
+/// </summary>
+/// <param name="scheduler">Scheduler pacing the loop.</param>
+void ContextController::run(IScheduler* scheduler)
+{
+	bool waiting = true;
+	std::int64_t cpuTime = threadCpuTime();
+
+	scheduler->reset();
+	while (!m_stop)
+	{
+		// Unthrottled updates run back to back, restarting the deadlines
+		// when the scheduler paces the loop again
+		if (m_unthrottled)
+			waiting = false;
+		else if (!waiting)
+		{
+			scheduler->reset();
+			waiting = true;
+		}
+
+		// Update the world and render, the deadlines restarting after an
+		// idle wait
+		if (waiting)
+		{
+			if (waitIdle())
+				scheduler->reset();
+			else
+				scheduler->wait();
+		}
+		if (m_stop)
+			break;
+		update();
+		m_wakeups++;
+
+		// Sample the loop's CPU time, sparingly while unthrottled
+		if (waiting || m_wakeups % 1024 == 0)
+		{
+			std::int64_t now = threadCpuTime();
+			m_cpuTime += now - cpuTime;
+			cpuTime = now;
+		}
+	}
+}
+
+/// <summary>
+///		Requests the game loop to exit after the current frame.
+/// </summary>
+void ContextController::stop(void)
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	m_stop = true;
+	m_wakeup.notify_one();
 }
\ No newline at end of file
@@ -17,11 +17,107 @@
 #define WINTEN_CONTEXTCONTROLLER_HPP
 
 // Include external header files
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 // Include project header files
+#include "cclocksteady.hpp"
+#include "ceventring.hpp"
+#include "cframebuilder.hpp"
+#include "clatencyhistogram.hpp"
+#include "cqualitycontroller.hpp"
+#include "iclock.hpp"
+#include "ischeduler.hpp"
 #include "istate.hpp"
 #include "iview.hpp"
+#include "winten_constants.hpp"
+
+/// <summary>
+///		Input latency histograms in clock ticks. Each input is timed from the
+///		key event to the return of the view's draw call for the first frame
+///		which reflects it, split at the update which applies it.
+/// </summary>
+struct LatencyStats
+{
+	// Key event to the start of the update applying it
+	CLatencyHistogram queued;
+	// Start of that update to the frame being presented
+	CLatencyHistogram rendered;
+	// Key event to the frame being presented
+	CLatencyHistogram total;
+};
+
+/// <summary>
+///		Simulated time covered against real time elapsed, for measuring how
+///		far faster than real time an unthrottled run goes.
+/// </summary>
+struct TimeStats
+{
+	// Simulated ticks run and real time elapsed in clock ticks
+	std::int64_t simulated;
+	std::int64_t wall;
+	// Simulation updates and frames drawn
+	std::uint64_t updates;
+	std::uint64_t frames;
+	// Game loop wakeups, how many ended an idle wait and the time spent in
+	// them, and the CPU time of the game loop's thread, in clock ticks
+	std::uint64_t wakeups;
+	std::uint64_t idleWaits;
+	std::int64_t idle;
+	std::int64_t cpu;
+
+	TimeStats(void)
+		: simulated(0)
+		, wall(0)
+		, updates(0)
+		, frames(0)
+		, wakeups(0)
+		, idleWaits(0)
+		, idle(0)
+		, cpu(0) {}
+
+	/// <summary>
+	///		Simulated seconds per real second.
+	/// </summary>
+	double speed(void) const
+	{
+		return wall > 0 ? static_cast<double>(simulated) / static_cast<double>(wall) : 0.0;
+	}
+
+	/// <summary>
+	///		Game loop wakeups per real second.
+	/// </summary>
+	double wakeupRate(void) const
+	{
+		return wall > 0 ? static_cast<double>(wakeups) * winten_constants::TICKS_PER_SECOND / static_cast<double>(wall) : 0.0;
+	}
+
+	/// <summary>
+	///		Share of one core used by the game loop.
+	/// </summary>
+	double cpuUsage(void) const
+	{
+		return wall > 0 ? static_cast<double>(cpu) / static_cast<double>(wall) : 0.0;
+	}
+};
+
+/// <summary>
+///		Game events seen by the controller, counted by type.
+/// </summary>
+struct EventStats
+{
+	std::uint64_t counts[EVENT_TYPE_COUNT];
+	// Events overwritten before they were counted
+	std::uint64_t lost;
+
+	EventStats(void)
+		: counts()
+		, lost(0) {}
+};
 
 /// <summary>
 ///		The context for the state pattern which responds to controller actions.
@@ -32,31 +128,110 @@ private:
 	// Smart pointer to current state
 	std::unique_ptr<IState> m_state;
 	std::unique_ptr<IView> m_view;
+	std::unique_ptr<IClock> m_clock;
+	// Layout of each frame shared by all views
+	CFrameBuilder m_frameBuilder;
+	std::atomic<bool> m_redraw;
+	// Rendering quality held to the frame budget
+	CQualityController m_quality;
+	// Input event with the first frame able to reflect it
+	struct InputEvent
+	{
+		std::int64_t time;
+		std::uint64_t frame;
+		// Start of the update which applied it
+		std::int64_t applied;
+	};
+
+	// Simulation tick length, and how far the frame time is ahead of the
+	// simulation, zero or less after each update
+	std::int64_t m_tickPeriod;
+	std::int64_t m_accumulator;
+	// Simulated time per clock time, and whether ticks run back to back
+	// drawing one in every m_drawInterval, or none if zero
+	double m_timeScale;
+	std::atomic<bool> m_unthrottled;
+	std::atomic<int> m_drawInterval;
+	// Simulated and real time covered, real time from its own steady clock
+	mutable CClockSteady m_wallClock;
+	std::int64_t m_wallStart;
+	std::atomic<std::int64_t> m_simulated;
+	std::atomic<std::uint64_t> m_updates;
+	std::atomic<std::uint64_t> m_frames;
+	std::atomic<std::uint64_t> m_wakeups;
+	std::atomic<std::uint64_t> m_idleWaits;
+	std::atomic<std::int64_t> m_idleTime;
+	std::atomic<std::int64_t> m_cpuTime;
 	// Timing and performance monitoring
-	long double m_lastTime;
+	std::int64_t m_lastTime;
+	bool m_started;
 	float m_latency;
-	// Key state
+	// Key state and inputs not yet applied, set from the window thread
+	std::mutex m_inputMutex;
 	bool m_keyUp;
 	bool m_keyDown;
 	bool m_keyEscape;
 	bool m_keyPressed;
+	std::uint64_t m_frame;
+	std::vector<InputEvent> m_inputs;
+	// Whether the view can be seen, and the idle wait of the game loop which
+	// input, redraws, visibility changes and stopping wake. The update after
+	// a visible idle wait covers it in one tick.
+	bool m_visible;
+	std::condition_variable m_wakeup;
+	bool m_resumed;
+	// Inputs applied by an update and waiting for a frame to be presented
+	std::vector<InputEvent> m_applied;
+	mutable std::mutex m_latencyMutex;
+	LatencyStats m_latencyStats;
+	// Whether to count the events of each state, and the cursor reading the
+	// current state's while subscribed to it
+	std::atomic<bool> m_countEvents;
+	bool m_subscribed;
+	EventCursor m_eventCursor;
+	mutable std::mutex m_eventMutex;
+	EventStats m_eventStats;
+
+	void recordInput(void);
+	void countEvents(void);
+	void recordPresent(std::int64_t presentTime);
+	bool waitIdle(void);
+	void applyQuality(RenderQuality quality);
+	// Set to end the game loop
+	std::atomic<bool> m_stop;
 
 public:
 	ContextController(void);
 	void setView(std::unique_ptr<IView> view);
+	void setClock(std::unique_ptr<IClock> clock);
+	void setTickRate(float rate);
+	void setTimeScale(float scale);
+	void setUnthrottled(bool unthrottled, int drawInterval);
+	void setFrameBudget(std::int64_t budget);
 	void transitionTo(std::unique_ptr<IState> state);
-	void update(long double thisTime);
+	void update(void);
 	void keyDown(bool state);
 	void keyUp(bool state);
 	void keyEscape(bool state);
 	void keyPressed(void);
-	void setAfterUpdateTime(long double timeAfterUpdate);
+	void invalidate(void);
+	void setVisible(bool visible);
+	LatencyStats getLatencyStats(void) const;
+	void resetLatencyStats(void);
+	TimeStats getTimeStats(void) const;
+	void resetTimeStats(void);
+	void setEventStats(bool enabled);
+	EventStats getEventStats(void) const;
+	QualityStats getQualityStats(void) const;
+	const IState* getState(void) const;
 	void initialize(
 		int newXOffset,
 		int newYOffset,
 		int newWidth,
 		int newHeight);
 	void shutdown(void);
+	void run(IScheduler* scheduler);
+	void stop(void);
 };
 
 #endif
\ No newline at end of file
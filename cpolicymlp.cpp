@@ -0,0 +1,524 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Include project header files
+#include "cpolicymlp.hpp"
+#include "rasterkernels.hpp"
+#include "winten_constants.hpp"
+
+#if WINTEN_RASTER_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const int LANES = CPolicyMLP::LANES;
+
+    // File signature and layout version
+    const char MAGIC[4] = { 'W', 'T', 'M', '1' };
+
+    void denseScalar(
+        const float* weights,
+        const float* bias,
+        const float* input,
+        float* output,
+        int inputs,
+        int outputs,
+        bool rectify)
+    {
+        for (int row = 0; row < outputs; row++)
+        {
+            float sum[LANES];
+
+            for (int lane = 0; lane < LANES; lane++)
+                sum[lane] = bias[row];
+            for (int column = 0; column < inputs; column++)
+            {
+                float weight = weights[row * inputs + column];
+                for (int lane = 0; lane < LANES; lane++)
+                    sum[lane] += weight * input[column * LANES + lane];
+            }
+            for (int lane = 0; lane < LANES; lane++)
+                output[row * LANES + lane] = rectify && sum[lane] < 0.0f ? 0.0f : sum[lane];
+        }
+    }
+
+#if WINTEN_RASTER_X86
+    // Rows of a layer accumulated together, so their additions overlap
+    // rather than each waiting on the one before
+    const int ROWS = 4;
+
+    WINTEN_TARGET_SSE2 void denseSSE2(
+        const float* weights,
+        const float* bias,
+        const float* input,
+        float* output,
+        int inputs,
+        int outputs,
+        bool rectify)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 floor = rectify ? zero : _mm_set1_ps(-HUGE_VALF);
+        int first = 0;
+
+        for (; first + ROWS / 2 <= outputs; first += ROWS / 2)
+        {
+            const float* upper = weights + first * inputs;
+            const float* lower = upper + inputs;
+            __m128 upperLow = _mm_set1_ps(bias[first]);
+            __m128 upperHigh = upperLow;
+            __m128 lowerLow = _mm_set1_ps(bias[first + 1]);
+            __m128 lowerHigh = lowerLow;
+
+            for (int column = 0; column < inputs; column++)
+            {
+                __m128 left = _mm_loadu_ps(input + column * LANES);
+                __m128 right = _mm_loadu_ps(input + column * LANES + 4);
+                __m128 weight = _mm_set1_ps(upper[column]);
+                upperLow = _mm_add_ps(upperLow, _mm_mul_ps(weight, left));
+                upperHigh = _mm_add_ps(upperHigh, _mm_mul_ps(weight, right));
+                weight = _mm_set1_ps(lower[column]);
+                lowerLow = _mm_add_ps(lowerLow, _mm_mul_ps(weight, left));
+                lowerHigh = _mm_add_ps(lowerHigh, _mm_mul_ps(weight, right));
+            }
+            _mm_storeu_ps(output + first * LANES, _mm_max_ps(upperLow, floor));
+            _mm_storeu_ps(output + first * LANES + 4, _mm_max_ps(upperHigh, floor));
+            _mm_storeu_ps(output + (first + 1) * LANES, _mm_max_ps(lowerLow, floor));
+            _mm_storeu_ps(output + (first + 1) * LANES + 4, _mm_max_ps(lowerHigh, floor));
+        }
+        for (; first < outputs; first++)
+        {
+            __m128 low = _mm_set1_ps(bias[first]);
+            __m128 high = low;
+
+            for (int column = 0; column < inputs; column++)
+            {
+                __m128 weight = _mm_set1_ps(weights[first * inputs + column]);
+                low = _mm_add_ps(low, _mm_mul_ps(weight, _mm_loadu_ps(input + column * LANES)));
+                high = _mm_add_ps(high, _mm_mul_ps(weight, _mm_loadu_ps(input + column * LANES + 4)));
+            }
+            _mm_storeu_ps(output + first * LANES, _mm_max_ps(low, floor));
+            _mm_storeu_ps(output + first * LANES + 4, _mm_max_ps(high, floor));
+        }
+    }
+
+    WINTEN_TARGET_AVX2 void denseAVX2(
+        const float* weights,
+        const float* bias,
+        const float* input,
+        float* output,
+        int inputs,
+        int outputs,
+        bool rectify)
+    {
+        const __m256 floor = rectify ? _mm256_setzero_ps() : _mm256_set1_ps(-HUGE_VALF);
+        int first = 0;
+
+        for (; first + ROWS <= outputs; first += ROWS)
+        {
+            const float* row = weights + first * inputs;
+            __m256 sum0 = _mm256_set1_ps(bias[first]);
+            __m256 sum1 = _mm256_set1_ps(bias[first + 1]);
+            __m256 sum2 = _mm256_set1_ps(bias[first + 2]);
+            __m256 sum3 = _mm256_set1_ps(bias[first + 3]);
+
+            for (int column = 0; column < inputs; column++)
+            {
+                __m256 value = _mm256_loadu_ps(input + column * LANES);
+                sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_set1_ps(row[column]), value));
+                sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_set1_ps(row[inputs + column]), value));
+                sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(_mm256_set1_ps(row[2 * inputs + column]), value));
+                sum3 = _mm256_add_ps(sum3, _mm256_mul_ps(_mm256_set1_ps(row[3 * inputs + column]), value));
+            }
+            _mm256_storeu_ps(output + first * LANES, _mm256_max_ps(sum0, floor));
+            _mm256_storeu_ps(output + (first + 1) * LANES, _mm256_max_ps(sum1, floor));
+            _mm256_storeu_ps(output + (first + 2) * LANES, _mm256_max_ps(sum2, floor));
+            _mm256_storeu_ps(output + (first + 3) * LANES, _mm256_max_ps(sum3, floor));
+        }
+        for (; first < outputs; first++)
+        {
+            __m256 sum = _mm256_set1_ps(bias[first]);
+
+            for (int column = 0; column < inputs; column++)
+                sum = _mm256_add_ps(
+                    sum,
+                    _mm256_mul_ps(_mm256_set1_ps(weights[first * inputs + column]), _mm256_loadu_ps(input + column * LANES)));
+            _mm256_storeu_ps(output + first * LANES, _mm256_max_ps(sum, floor));
+        }
+    }
+#endif
+
+    const CPolicyMLP::Kernel SCALAR = { "scalar", denseScalar };
+#if WINTEN_RASTER_X86
+    const CPolicyMLP::Kernel SSE2 = { "sse2", denseSSE2 };
+    const CPolicyMLP::Kernel AVX2 = { "avx2", denseAVX2 };
+#endif
+
+    /// <summary>
+    ///     Triangular basis function, 1 at the centre falling to 0 a width away.
+    /// </summary>
+    float hat(float value, float centre, float width)
+    {
+        return std::max(0.0f, 1.0f - std::fabs(value - centre) / width);
+    }
+
+    /// <summary>
+    ///     Highest scoring action of one lane of an output block, staying on a tie.
+    /// </summary>
+    PolicyAction best(const float* outputs, int lane)
+    {
+        int result = ACTION_STAY;
+
+        for (int action = 0; action < ACTION_COUNT; action++)
+            if (outputs[action * LANES + lane] > outputs[result * LANES + lane])
+                result = action;
+        return static_cast<PolicyAction>(result);
+    }
+}
+
+const int CPolicyMLP::INPUTS;
+const int CPolicyMLP::HIDDEN;
+const int CPolicyMLP::OUTPUTS;
+const int CPolicyMLP::LANES;
+
+/// <summary>
+///     Construct a policy with zero weights, which always stays, using the
+///     fastest kernel the processor supports.
+/// </summary>
+CPolicyMLP::CPolicyMLP(void)
+    : m_hiddenWeights(static_cast<std::size_t>(HIDDEN * INPUTS), 0.0f)
+    , m_hiddenBias(static_cast<std::size_t>(HIDDEN), 0.0f)
+    , m_outputWeights(static_cast<std::size_t>(OUTPUTS * HIDDEN), 0.0f)
+    , m_outputBias(static_cast<std::size_t>(OUTPUTS), 0.0f)
+    , m_kernel(kernels().back())
+{
+}
+
+/// <summary>
+///     Derive the network inputs from an observation into one lane of a
+///     block of INPUTS * LANES values stored input by input.
+/// </summary>
+/// <param name="observation">What the paddle sees.</param>
+/// <param name="inputs">Block to write to.</param>
+/// <param name="lane">Lane of the block.</param>
+void CPolicyMLP::encode(const Observation& observation, float* inputs, int lane)
+{
+    float features[INPUTS];
+    int count = 0;
+
+    features[count++] = observation.distance;
+    features[count++] = observation.offset;
+    features[count++] = observation.vertical;
+    features[count++] = observation.approaching;
+    features[count++] = observation.height;
+
+    // Offset resolved to about a paddle height, coarse paddle height and
+    // whether the ball is close
+    for (int centre = -8; centre <= 8; centre++)
+        features[count++] = hat(observation.offset, 0.05f * centre, 0.05f);
+    for (int centre = 0; centre <= 3; centre++)
+        features[count++] = hat(observation.height, centre / 3.0f, 1.0f / 3.0f);
+    for (int centre = 0; centre <= 1; centre++)
+        features[count++] = hat(observation.distance, 0.25f * centre, 0.25f);
+
+    // An incoming ball, and its offset on reaching the paddle without bounces
+    float slope = observation.vertical / std::sqrt(std::max(1.0f - observation.vertical * observation.vertical, 0.25f));
+    features[count++] = observation.offset * observation.approaching;
+    features[count++] = observation.vertical * observation.approaching;
+    features[count++] = observation.distance * observation.approaching;
+    features[count++] = (observation.offset + observation.distance * slope * winten_constants::ASPECT_RATIO) * observation.approaching;
+
+    for (int index = 0; index < INPUTS; index++)
+        inputs[index * LANES + lane] = features[index];
+}
+
+/// <summary>
+///     Get every kernel variant the processor supports.
+/// </summary>
+/// <returns>Variants ordered slowest first.</returns>
+std::vector<const CPolicyMLP::Kernel*> CPolicyMLP::kernels(void)
+{
+    std::vector<const Kernel*> variants;
+
+    variants.push_back(&SCALAR);
+#if WINTEN_RASTER_X86
+    if (raster_kernels::cpuSupportsSSE2())
+        variants.push_back(&SSE2);
+    if (raster_kernels::cpuSupportsAVX2())
+        variants.push_back(&AVX2);
+#endif
+    return variants;
+}
+
+/// <summary>
+///     Choose the kernel variant, e.g. to compare them.
+/// </summary>
+/// <param name="kernel">A variant from kernels().</param>
+void CPolicyMLP::setKernel(const Kernel* kernel)
+{
+    m_kernel = kernel;
+}
+
+/// <summary>
+///     Get the kernel variant in use.
+/// </summary>
+const CPolicyMLP::Kernel& CPolicyMLP::kernel(void) const
+{
+    return *m_kernel;
+}
+
+/// <summary>
+///     Evaluate the network over a block.
+/// </summary>
+/// <param name="inputs">INPUTS * LANES inputs.</param>
+/// <param name="hidden">Scratch for HIDDEN * LANES values.</param>
+/// <param name="outputs">Receives OUTPUTS * LANES action scores.</param>
+void CPolicyMLP::forward(const float* inputs, float* hidden, float* outputs) const
+{
+    m_kernel->dense(m_hiddenWeights.data(), m_hiddenBias.data(), inputs, hidden, INPUTS, HIDDEN, true);
+    m_kernel->dense(m_outputWeights.data(), m_outputBias.data(), hidden, outputs, HIDDEN, OUTPUTS, false);
+}
+
+/// <summary>
+///     Choose the highest scoring action for one observation.
+/// </summary>
+/// <param name="observation">What the paddle sees.</param>
+/// <returns>The action.</returns>
+PolicyAction CPolicyMLP::act(const Observation& observation) const
+{
+    PolicyAction action;
+
+    actBatch(&observation, 1, &action);
+    return action;
+}
+
+/// <summary>
+///     Choose actions for many observations, a block of LANES at a time.
+/// </summary>
+/// <param name="observations">Observations.</param>
+/// <param name="count">Number of observations.</param>
+/// <param name="actions">Receives an action per observation.</param>
+void CPolicyMLP::actBatch(const Observation* observations, int count, PolicyAction* actions) const
+{
+    float inputs[INPUTS * LANES];
+    float hidden[HIDDEN * LANES];
+    float outputs[OUTPUTS * LANES];
+
+    for (int first = 0; first < count; first += LANES)
+    {
+        int lanes = std::min(count - first, LANES);
+
+        // Unused lanes of a partial block are zeroed rather than left undefined
+        if (lanes < LANES)
+            std::fill(inputs, inputs + INPUTS * LANES, 0.0f);
+        for (int lane = 0; lane < lanes; lane++)
+            encode(observations[first + lane], inputs, lane);
+        forward(inputs, hidden, outputs);
+        for (int lane = 0; lane < lanes; lane++)
+            actions[first + lane] = best(outputs, lane);
+    }
+}
+
+/// <summary>
+///     Train the network to imitate another policy by stochastic gradient
+///     descent on the softmax cross-entropy of the teacher's action. The last
+///     tenth of the samples is held out to measure the result.
+/// </summary>
+/// <param name="teacher">Policy to imitate.</param>
+/// <param name="samples">Observations to learn from.</param>
+/// <param name="epochs">Passes over the training samples.</param>
+/// <param name="learningRate">Step size.</param>
+/// <param name="seed">Seed for the initial weights and sample order.</param>
+/// <returns>Fraction of held out samples where the network agrees with the teacher.</returns>
+float CPolicyMLP::distill(
+    const IPolicy& teacher,
+    const std::vector<Observation>& samples,
+    int epochs,
+    float learningRate,
+    std::uint64_t seed)
+{
+    std::mt19937_64 random(seed);
+    std::size_t training = samples.size() - samples.size() / 10;
+    std::vector<float> inputs(samples.size() * INPUTS);
+    std::vector<int> labels(samples.size());
+    std::vector<std::size_t> order(training);
+    float block[INPUTS * LANES];
+
+    // Initial weights scaled to keep activations near unit variance
+    std::normal_distribution<float> hiddenInit(0.0f, std::sqrt(2.0f / INPUTS));
+    std::normal_distribution<float> outputInit(0.0f, std::sqrt(1.0f / HIDDEN));
+    for (float& weight : m_hiddenWeights)
+        weight = hiddenInit(random);
+    for (float& weight : m_outputWeights)
+        weight = outputInit(random);
+    std::fill(m_hiddenBias.begin(), m_hiddenBias.end(), 0.0f);
+    std::fill(m_outputBias.begin(), m_outputBias.end(), 0.0f);
+
+    // Encode every sample once and label it with the teacher's choice
+    for (std::size_t sample = 0; sample < samples.size(); sample++)
+    {
+        encode(samples[sample], block, 0);
+        for (int index = 0; index < INPUTS; index++)
+            inputs[sample * INPUTS + index] = block[index * LANES];
+        labels[sample] = teacher.act(samples[sample]);
+    }
+    for (std::size_t index = 0; index < training; index++)
+        order[index] = index;
+
+    for (int epoch = 0; epoch < epochs; epoch++)
+    {
+        std::shuffle(order.begin(), order.end(), random);
+        for (std::size_t sample : order)
+        {
+            const float* x = &inputs[sample * INPUTS];
+            float hidden[HIDDEN];
+            float scores[OUTPUTS];
+            float gradient[OUTPUTS];
+            float largest;
+            float total = 0.0f;
+
+            // Forward pass
+            for (int row = 0; row < HIDDEN; row++)
+            {
+                float sum = m_hiddenBias[row];
+                for (int column = 0; column < INPUTS; column++)
+                    sum += m_hiddenWeights[row * INPUTS + column] * x[column];
+                hidden[row] = std::max(sum, 0.0f);
+            }
+            for (int row = 0; row < OUTPUTS; row++)
+            {
+                scores[row] = m_outputBias[row];
+                for (int column = 0; column < HIDDEN; column++)
+                    scores[row] += m_outputWeights[row * HIDDEN + column] * hidden[column];
+            }
+
+            // Softmax less the one-hot label
+            largest = *std::max_element(scores, scores + OUTPUTS);
+            for (int row = 0; row < OUTPUTS; row++)
+            {
+                gradient[row] = std::exp(scores[row] - largest);
+                total += gradient[row];
+            }
+            for (int row = 0; row < OUTPUTS; row++)
+                gradient[row] = gradient[row] / total - (row == labels[sample] ? 1.0f : 0.0f);
+
+            // Back propagate through the hidden layer before updating the output layer
+            for (int column = 0; column < HIDDEN; column++)
+            {
+                if (hidden[column] <= 0.0f)
+                    continue;
+                float delta = 0.0f;
+                for (int row = 0; row < OUTPUTS; row++)
+                    delta += m_outputWeights[row * HIDDEN + column] * gradient[row];
+                delta *= learningRate;
+                for (int input = 0; input < INPUTS; input++)
+                    m_hiddenWeights[column * INPUTS + input] -= delta * x[input];
+                m_hiddenBias[column] -= delta;
+            }
+            for (int row = 0; row < OUTPUTS; row++)
+            {
+                for (int column = 0; column < HIDDEN; column++)
+                    m_outputWeights[row * HIDDEN + column] -= learningRate * gradient[row] * hidden[column];
+                m_outputBias[row] -= learningRate * gradient[row];
+            }
+        }
+    }
+
+    // Agreement on the held out samples
+    std::size_t agreed = 0;
+    for (std::size_t sample = training; sample < samples.size(); sample++)
+        if (act(samples[sample]) == labels[sample])
+            agreed++;
+    return samples.size() > training ? static_cast<float>(agreed) / (samples.size() - training) : 0.0f;
+}
+
+/// <summary>
+///     Write the weights to a file: a signature, the layer sizes, then the
+///     hidden weights and biases and the output weights and biases as
+///     native floats.
+/// </summary>
+/// <param name="path">File to write.</param>
+/// <returns>False if the file could not be written.</returns>
+bool CPolicyMLP::save(const char* path) const
+{
+    std::int32_t sizes[3] = { INPUTS, HIDDEN, OUTPUTS };
+    const std::vector<float>* layers[4] = { &m_hiddenWeights, &m_hiddenBias, &m_outputWeights, &m_outputBias };
+    std::FILE* file = std::fopen(path, "wb");
+    bool result;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    result = std::fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+        && std::fwrite(sizes, sizeof(sizes), 1, file) == 1;
+    for (const std::vector<float>* layer : layers)
+        result = result && std::fwrite(layer->data(), sizeof(float), layer->size(), file) == layer->size();
+    result = std::fclose(file) == 0 && result;
+    if (!result)
+        std::perror(path);
+    return result;
+}
+
+/// <summary>
+///     Read weights written by save. The policy is unchanged on failure.
+/// </summary>
+/// <param name="path">File to read.</param>
+/// <returns>False if the file could not be read or has other layer sizes.</returns>
+bool CPolicyMLP::load(const char* path)
+{
+    char magic[4];
+    std::int32_t sizes[3];
+    std::vector<float> hiddenWeights(m_hiddenWeights.size());
+    std::vector<float> hiddenBias(m_hiddenBias.size());
+    std::vector<float> outputWeights(m_outputWeights.size());
+    std::vector<float> outputBias(m_outputBias.size());
+    std::vector<float>* layers[4] = { &hiddenWeights, &hiddenBias, &outputWeights, &outputBias };
+    std::FILE* file = std::fopen(path, "rb");
+    bool result;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    result = std::fread(magic, sizeof(magic), 1, file) == 1
+        && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && std::fread(sizes, sizeof(sizes), 1, file) == 1
+        && sizes[0] == INPUTS
+        && sizes[1] == HIDDEN
+        && sizes[2] == OUTPUTS;
+    for (std::vector<float>* layer : layers)
+        result = result && std::fread(layer->data(), sizeof(float), layer->size(), file) == layer->size();
+    std::fclose(file);
+    if (!result)
+    {
+        std::fprintf(stderr, "%s: not a network of this layout\n", path);
+        return false;
+    }
+    m_hiddenWeights.swap(hiddenWeights);
+    m_hiddenBias.swap(hiddenBias);
+    m_outputWeights.swap(outputWeights);
+    m_outputBias.swap(outputBias);
+    return true;
+}
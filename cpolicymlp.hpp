@@ -0,0 +1,88 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CPOLICYMLP_HPP
+#define WINTEN_CPOLICYMLP_HPP
+
+// Include external header files
+#include <cstdint>
+#include <vector>
+
+// Include project header files
+#include "ipolicy.hpp"
+
+/// <summary>
+///     Paddle policy from a small multilayer perceptron: features derived from
+///     the observation, one rectified hidden layer and a score per action.
+///     Observations are evaluated in blocks of LANES with the inputs of a
+///     block stored feature by feature, so each weight is broadcast once and
+///     multiplied into every lane by the widest kernel the CPU supports.
+///     Evaluation allocates nothing and is safe from any number of threads.
+/// </summary>
+class CPolicyMLP : public IPolicy
+{
+public:
+    static const int INPUTS = 32;
+    static const int HIDDEN = 32;
+    static const int OUTPUTS = ACTION_COUNT;
+    // Observations per block, one per lane of the widest kernel
+    static const int LANES = 8;
+
+    /// <summary>
+    ///     Dense layer over a block: output[o][lane] = bias[o] + sum of
+    ///     weights[o][i] * input[i][lane], optionally rectified.
+    /// </summary>
+    struct Kernel
+    {
+        const char* name;
+        void (*dense)(
+            const float* weights,
+            const float* bias,
+            const float* input,
+            float* output,
+            int inputs,
+            int outputs,
+            bool rectify);
+    };
+
+private:
+    // Row-major weights, one row per output, and biases
+    std::vector<float> m_hiddenWeights;
+    std::vector<float> m_hiddenBias;
+    std::vector<float> m_outputWeights;
+    std::vector<float> m_outputBias;
+    const Kernel* m_kernel;
+
+    void forward(const float* inputs, float* hidden, float* outputs) const;
+
+public:
+    CPolicyMLP(void);
+    static void encode(const Observation& observation, float* inputs, int lane);
+    static std::vector<const Kernel*> kernels(void);
+    void setKernel(const Kernel* kernel);
+    const Kernel& kernel(void) const;
+    PolicyAction act(const Observation& observation) const override;
+    void actBatch(const Observation* observations, int count, PolicyAction* actions) const override;
+    float distill(
+        const IPolicy& teacher,
+        const std::vector<Observation>& samples,
+        int epochs,
+        float learningRate,
+        std::uint64_t seed);
+    bool save(const char* path) const;
+    bool load(const char* path);
+};
+
+#endif
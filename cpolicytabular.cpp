@@ -0,0 +1,164 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Include project header files
+#include "cpolicytabular.hpp"
+
+namespace
+{
+    // File signature and layout version
+    const char MAGIC[4] = { 'W', 'T', 'Q', '1' };
+
+    /// <summary>
+    ///     Bin of a feature, clamping values outside the range to the end bins.
+    /// </summary>
+    int bin(float value, float low, float high, int bins)
+    {
+        int index = static_cast<int>((value - low) / (high - low) * bins);
+        return std::min(std::max(index, 0), bins - 1);
+    }
+}
+
+/// <summary>
+///     Construct a policy with every action value zero, which always stays.
+/// </summary>
+CPolicyTabular::CPolicyTabular(void)
+    : m_values(static_cast<std::size_t>(STATES * ACTION_COUNT), 0.0f)
+{
+}
+
+/// <summary>
+///     Construct a policy from action values.
+/// </summary>
+/// <param name="values">STATES * ACTION_COUNT action values.</param>
+CPolicyTabular::CPolicyTabular(const std::vector<float>& values)
+    : m_values(values)
+{
+    m_values.resize(static_cast<std::size_t>(STATES * ACTION_COUNT), 0.0f);
+}
+
+/// <summary>
+///     Discretize an observation. Offsets are binned finest, about a paddle
+///     height per bin, as they decide whether the ball is returned.
+/// </summary>
+/// <param name="observation">Observation to discretize.</param>
+/// <returns>State index.</returns>
+int CPolicyTabular::state(const Observation& observation)
+{
+    int result = bin(observation.offset, -0.4f, 0.4f, OFFSET_BINS);
+    result = result * DISTANCE_BINS + bin(observation.distance, 0.0f, 1.0f, DISTANCE_BINS);
+    result = result * VERTICAL_BINS + bin(observation.vertical, -1.0f, 1.0f, VERTICAL_BINS);
+    result = result * APPROACHING_BINS + (observation.approaching > 0.5f ? 1 : 0);
+    return result * HEIGHT_BINS + bin(observation.height, 0.0f, 1.0f, HEIGHT_BINS);
+}
+
+/// <summary>
+///     Best action among a state's values, staying on a tie.
+/// </summary>
+/// <param name="values">ACTION_COUNT action values.</param>
+/// <returns>The action.</returns>
+PolicyAction CPolicyTabular::best(const float* values)
+{
+    int result = ACTION_STAY;
+
+    for (int action = 0; action < ACTION_COUNT; action++)
+        if (values[action] > values[result])
+            result = action;
+    return static_cast<PolicyAction>(result);
+}
+
+/// <summary>
+///     Choose the action with the highest value.
+/// </summary>
+/// <param name="observation">What the paddle sees.</param>
+/// <returns>The action.</returns>
+PolicyAction CPolicyTabular::act(const Observation& observation) const
+{
+    return best(&m_values[static_cast<std::size_t>(state(observation)) * ACTION_COUNT]);
+}
+
+/// <summary>
+///     Get the action values, ACTION_COUNT per state.
+/// </summary>
+const std::vector<float>& CPolicyTabular::values(void) const
+{
+    return m_values;
+}
+
+/// <summary>
+///     Write the table to a file: a signature, the state and action counts,
+///     then the values as native floats.
+/// </summary>
+/// <param name="path">File to write.</param>
+/// <returns>False if the file could not be written.</returns>
+bool CPolicyTabular::save(const char* path) const
+{
+    std::int32_t sizes[2] = { STATES, ACTION_COUNT };
+    std::FILE* file = std::fopen(path, "wb");
+    bool result;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    result = std::fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+        && std::fwrite(sizes, sizeof(sizes), 1, file) == 1
+        && std::fwrite(m_values.data(), sizeof(float), m_values.size(), file) == m_values.size();
+    result = std::fclose(file) == 0 && result;
+    if (!result)
+        std::perror(path);
+    return result;
+}
+
+/// <summary>
+///     Read a table written by save. The policy is unchanged on failure.
+/// </summary>
+/// <param name="path">File to read.</param>
+/// <returns>False if the file could not be read or has another layout.</returns>
+bool CPolicyTabular::load(const char* path)
+{
+    char magic[4];
+    std::int32_t sizes[2];
+    std::vector<float> values(m_values.size());
+    std::FILE* file = std::fopen(path, "rb");
+    bool result;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    result = std::fread(magic, sizeof(magic), 1, file) == 1
+        && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && std::fread(sizes, sizeof(sizes), 1, file) == 1
+        && sizes[0] == STATES
+        && sizes[1] == ACTION_COUNT
+        && std::fread(values.data(), sizeof(float), values.size(), file) == values.size();
+    std::fclose(file);
+    if (!result)
+    {
+        std::fprintf(stderr, "%s: not a policy table of this layout\n", path);
+        return false;
+    }
+    m_values.swap(values);
+    return true;
+}
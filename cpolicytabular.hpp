@@ -0,0 +1,55 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CPOLICYTABULAR_HPP
+#define WINTEN_CPOLICYTABULAR_HPP
+
+// Include external header files
+#include <vector>
+
+// Include project header files
+#include "ipolicy.hpp"
+
+/// <summary>
+///     Paddle policy from a table of action values over a discretized
+///     observation, as learned by CTrainer. Acts greedily.
+/// </summary>
+class CPolicyTabular : public IPolicy
+{
+public:
+    // Bins per observation feature
+    static const int OFFSET_BINS = 16;
+    static const int DISTANCE_BINS = 8;
+    static const int VERTICAL_BINS = 5;
+    static const int APPROACHING_BINS = 2;
+    static const int HEIGHT_BINS = 4;
+    static const int STATES = OFFSET_BINS * DISTANCE_BINS * VERTICAL_BINS * APPROACHING_BINS * HEIGHT_BINS;
+
+private:
+    // Action values, ACTION_COUNT per state
+    std::vector<float> m_values;
+
+public:
+    CPolicyTabular(void);
+    explicit CPolicyTabular(const std::vector<float>& values);
+    static int state(const Observation& observation);
+    static PolicyAction best(const float* values);
+    PolicyAction act(const Observation& observation) const override;
+    const std::vector<float>& values(void) const;
+    bool save(const char* path) const;
+    bool load(const char* path);
+};
+
+#endif
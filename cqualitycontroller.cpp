@@ -0,0 +1,151 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+
+// Include project header files
+#include "cqualitycontroller.hpp"
+
+/// <summary>
+///     Class constructor, disabled until given a budget.
+/// </summary>
+CQualityController::CQualityController(void)
+    : m_mutex()
+    , m_budget(0)
+    , m_level(QUALITY_FULL)
+    , m_cost(0.0)
+    , m_sinceChange(0)
+    , m_sinceUp(MAX_UP_FRAMES)
+    , m_calm(0)
+    , m_upFrames(UP_FRAMES)
+    , m_stats()
+    , m_log()
+{
+}
+
+/// <summary>
+///     Set the time each frame may take to update and draw, usually the frame
+///     period. Zero disables the controller, returning to full quality.
+/// </summary>
+/// <param name="budget">Budget in clock ticks.</param>
+void CQualityController::setBudget(std::int64_t budget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_budget = std::max<std::int64_t>(budget, 0);
+    m_cost = 0.0;
+    m_calm = 0;
+    m_upFrames = UP_FRAMES;
+}
+
+/// <summary>
+///     Record the cost of a frame and step the quality level if needed. A
+///     frame the view dropped as its output could not keep up counts as
+///     costing at least the whole budget. Frames the view could not draw
+///     at all, while resizing, say nothing of load and are not recorded.
+/// </summary>
+/// <param name="time">Clock time of the frame.</param>
+/// <param name="updateCost">Time spent updating the simulation.</param>
+/// <param name="drawCost">Time spent laying out and drawing.</param>
+/// <param name="dropped">True if the view dropped the frame.</param>
+/// <returns>True if the level changed.</returns>
+bool CQualityController::record(std::int64_t time, std::int64_t updateCost, std::int64_t drawCost, bool dropped)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::int64_t cost = updateCost + drawCost;
+    int level = m_level;
+
+    m_stats.frames++;
+    m_stats.levelFrames[m_level]++;
+    if (dropped)
+    {
+        m_stats.dropped++;
+        cost = std::max(cost, m_budget);
+    }
+    if (m_budget > 0 && (cost > m_budget || dropped))
+        m_stats.overBudget++;
+    m_cost += (static_cast<double>(cost) - m_cost) * SMOOTHING;
+    m_sinceChange++;
+    m_sinceUp = std::min(m_sinceUp + 1, MAX_UP_FRAMES);
+
+    if (m_budget <= 0)
+        level = QUALITY_FULL;
+    else if (m_cost > DOWN_THRESHOLD * static_cast<double>(m_budget))
+    {
+        m_calm = 0;
+        if (m_sinceChange >= SETTLE_FRAMES && level + 1 < QUALITY_LEVEL_COUNT)
+        {
+            // The last step up didn't hold, so wait longer before the next
+            m_upFrames = m_sinceUp < m_upFrames ? std::min(m_upFrames * 2, MAX_UP_FRAMES) : UP_FRAMES;
+            level++;
+        }
+    }
+    else if (m_cost < UP_THRESHOLD * static_cast<double>(m_budget))
+    {
+        if (++m_calm >= m_upFrames && level > QUALITY_FULL)
+        {
+            m_sinceUp = 0;
+            level--;
+        }
+    }
+    else
+        m_calm = 0;
+
+    if (level == m_level)
+        return false;
+
+    QualityTransition transition = {
+        time,
+        static_cast<std::int64_t>(m_cost),
+        m_level,
+        static_cast<RenderQuality>(level) };
+    if (m_log.size() == LOG_SIZE)
+        m_log.pop_front();
+    m_log.push_back(transition);
+    if (transition.to > transition.from)
+        m_stats.downs++;
+    else
+        m_stats.ups++;
+    m_level = transition.to;
+    m_sinceChange = 0;
+    m_calm = 0;
+    return true;
+}
+
+/// <summary>
+///     Current quality level.
+/// </summary>
+RenderQuality CQualityController::level(void) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_level;
+}
+
+/// <summary>
+///     Get a snapshot of the frame costs and transitions.
+/// </summary>
+/// <returns>The statistics.</returns>
+QualityStats CQualityController::getStats(void) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QualityStats stats = m_stats;
+
+    stats.level = m_level;
+    stats.budget = m_budget;
+    stats.cost = static_cast<std::int64_t>(m_cost);
+    stats.transitions.assign(m_log.begin(), m_log.end());
+    return stats;
+}
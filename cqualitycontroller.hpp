@@ -0,0 +1,118 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CQUALITYCONTROLLER_HPP
+#define WINTEN_CQUALITYCONTROLLER_HPP
+
+// Include external header files
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Include project header files
+#include "iview.hpp"
+
+/// <summary>
+///     A change of rendering quality.
+/// </summary>
+struct QualityTransition
+{
+    // Clock time of the change, and the smoothed frame cost which caused it
+    std::int64_t time;
+    std::int64_t cost;
+    RenderQuality from;
+    RenderQuality to;
+};
+
+/// <summary>
+///     Frame costs against the budget and the quality changes made to hold it,
+///     times in clock ticks.
+/// </summary>
+struct QualityStats
+{
+    RenderQuality level;
+    std::int64_t budget;
+    // Smoothed update and draw time per frame
+    std::int64_t cost;
+    std::uint64_t frames;
+    // Frames whose cost alone was over the budget, dropped ones included
+    std::uint64_t overBudget;
+    // Frames drawn but dropped as the view's output could not keep up
+    std::uint64_t dropped;
+    std::uint64_t downs;
+    std::uint64_t ups;
+    // Frames spent at each level
+    std::uint64_t levelFrames[QUALITY_LEVEL_COUNT];
+    // Most recent transitions, oldest first
+    std::vector<QualityTransition> transitions;
+
+    QualityStats(void)
+        : level(QUALITY_FULL)
+        , budget(0)
+        , cost(0)
+        , frames(0)
+        , overBudget(0)
+        , dropped(0)
+        , downs(0)
+        , ups(0)
+        , levelFrames()
+        , transitions() {}
+};
+
+/// <summary>
+///     Feedback controller holding the time to update and draw each frame
+///     within a budget. A smoothed cost near the budget steps quality down a
+///     level at a time, waiting for each step to show in the cost, and a
+///     sustained low cost steps it back up. Stepping down again soon after
+///     stepping up doubles the wait before the next try, so a load which
+///     only fits at a lower level settles there instead of oscillating.
+/// </summary>
+class CQualityController
+{
+private:
+    // Fractions of the budget the smoothed cost steps down above and up below
+    static constexpr double DOWN_THRESHOLD = 0.85;
+    static constexpr double UP_THRESHOLD = 0.65;
+    // Weight of each frame in the smoothed cost
+    static constexpr double SMOOTHING = 1.0 / 8.0;
+    // Frames after a change before stepping down again
+    static constexpr std::uint64_t SETTLE_FRAMES = 16;
+    // Frames of low cost before stepping up, doubling up to the maximum
+    static constexpr std::uint64_t UP_FRAMES = 120;
+    static constexpr std::uint64_t MAX_UP_FRAMES = UP_FRAMES << 5;
+    static constexpr std::size_t LOG_SIZE = 32;
+
+    mutable std::mutex m_mutex;
+    std::int64_t m_budget;
+    RenderQuality m_level;
+    double m_cost;
+    std::uint64_t m_sinceChange;
+    std::uint64_t m_sinceUp;
+    std::uint64_t m_calm;
+    std::uint64_t m_upFrames;
+    QualityStats m_stats;
+    std::deque<QualityTransition> m_log;
+
+public:
+    CQualityController(void);
+    void setBudget(std::int64_t budget);
+    bool record(std::int64_t time, std::int64_t updateCost, std::int64_t drawCost, bool dropped);
+    RenderQuality level(void) const;
+    QualityStats getStats(void) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <random>
+
+// Include project header files
+#include "cregistry.hpp"
+
+/// <summary>
+///     Class constructor, seeding the generator nondeterministically.
+/// </summary>
+template <typename T>
+CBasicRegistry<T>::CBasicRegistry(void)
+    : m_next(0)
+    , m_random(0)
+    , score()
+    , events()
+    , policy()
+{
+    std::random_device device;
+
+    seed((static_cast<std::uint64_t>(device()) << 32) | device());
+}
+
+/// <summary>
+///     Create an entity with no components.
+/// </summary>
+/// <returns>The new entity.</returns>
+template <typename T>
+Entity CBasicRegistry<T>::create(void)
+{
+    return m_next++;
+}
+
+/// <summary>
+///     Remove every component of an entity.
+/// </summary>
+/// <param name="entity">Entity to destroy.</param>
+template <typename T>
+void CBasicRegistry<T>::destroy(Entity entity)
+{
+    positions.remove(entity);
+    velocities.remove(entity);
+    colliders.remove(entity);
+    controllers.remove(entity);
+    renders.remove(entity);
+    texts.remove(entity);
+}
+
+/// <summary>
+///     Seed the random number generator.
+/// </summary>
+/// <param name="seed">Any value, equal seeds give equal sequences.</param>
+template <typename T>
+void CBasicRegistry<T>::seed(std::uint64_t seed)
+{
+    // Scramble the seed with splitmix64 so small seeds are not degenerate
+    seed += 0x9E3779B97F4A7C15ull;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+    m_random = (seed ^ (seed >> 31)) | 1;
+}
+
+/// <summary>
+///     Next 32 random bits from an xorshift64* generator.
+/// </summary>
+template <typename T>
+std::uint32_t CBasicRegistry<T>::random(void)
+{
+    m_random ^= m_random >> 12;
+    m_random ^= m_random << 25;
+    m_random ^= m_random >> 27;
+    return static_cast<std::uint32_t>((m_random * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+/// <summary>
+///     Next random value uniform in [0, 1).
+/// </summary>
+template <typename T>
+float CBasicRegistry<T>::uniform(void)
+{
+    return static_cast<float>(random() >> 8) * (1.0f / 16777216.0f);
+}
+
+template class CBasicRegistry<float>;
+template class CBasicRegistry<CFixed>;
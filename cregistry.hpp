@@ -0,0 +1,73 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CREGISTRY_HPP
+#define WINTEN_CREGISTRY_HPP
+
+// Include external header files
+#include <cstdint>
+#include <memory>
+
+// Include project header files
+#include "ccomponentarray.hpp"
+#include "ceventring.hpp"
+#include "components.hpp"
+#include "ipolicy.hpp"
+
+/// <summary>
+///     Entities of one match: a dense array per component type, the score,
+///     the events of recent ticks, the policy of any learned paddles, and a
+///     random number generator so that a seeded match is repeatable.
+///     Positions, speeds and extents are
+///     of scalar type T, float for play or CFixed where every build must
+///     agree bit for bit; shapes and text are drawn in float either way.
+/// </summary>
+template <typename T>
+class CBasicRegistry
+{
+private:
+    Entity m_next;
+    std::uint64_t m_random;
+
+public:
+    typedef T Scalar;
+    typedef BasicPosition<T> Position;
+    typedef BasicVelocity<T> Velocity;
+    typedef BasicCollider<T> Collider;
+    typedef BasicController<T> Controller;
+
+    CComponentArray<Position> positions;
+    CComponentArray<Velocity> velocities;
+    CComponentArray<Collider> colliders;
+    CComponentArray<Controller> controllers;
+    CComponentArray<Render> renders;
+    CComponentArray<Text> texts;
+    int score[SIDE_COUNT];
+    CEventRing events;
+    // Policy moving CONTROLLER_POLICY paddles, shared between matches
+    std::shared_ptr<const IPolicy> policy;
+
+    CBasicRegistry(void);
+    Entity create(void);
+    void destroy(Entity entity);
+    void seed(std::uint64_t seed);
+    std::uint32_t random(void);
+    float uniform(void);
+};
+
+typedef CBasicRegistry<float> CRegistry;
+typedef CBasicRegistry<CFixed> CFixedRegistry;
+
+#endif
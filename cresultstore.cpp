@@ -0,0 +1,112 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <cstddef>
+
+// Include project header files
+#include "cresultstore.hpp"
+
+const ColumnSpec CResultStore::MATCH_COLUMNS[] = {
+    { "seed", COLUMN_UINT64, offsetof(MatchRecord, seed) },
+    { "npcController", COLUMN_INT32, offsetof(MatchRecord, npcController) },
+    { "playerController", COLUMN_INT32, offsetof(MatchRecord, playerController) },
+    { "npcHorizon", COLUMN_FLOAT, offsetof(MatchRecord, npcHorizon) },
+    { "playerHorizon", COLUMN_FLOAT, offsetof(MatchRecord, playerHorizon) },
+    { "scoreNpc", COLUMN_INT32, offsetof(MatchRecord, scoreNpc) },
+    { "scorePlayer", COLUMN_INT32, offsetof(MatchRecord, scorePlayer) },
+    { "rallies", COLUMN_INT32, offsetof(MatchRecord, rallies) },
+    { "duration", COLUMN_FLOAT, offsetof(MatchRecord, duration) }
+};
+const int CResultStore::MATCH_COLUMN_COUNT = sizeof(MATCH_COLUMNS) / sizeof(MATCH_COLUMNS[0]);
+
+const ColumnSpec CResultStore::RALLY_COLUMNS[] = {
+    { "seed", COLUMN_UINT64, offsetof(RallyRecord, seed) },
+    { "rally", COLUMN_INT32, offsetof(RallyRecord, rally) },
+    { "hits", COLUMN_INT32, offsetof(RallyRecord, hits) },
+    { "winner", COLUMN_INT32, offsetof(RallyRecord, winner) },
+    { "duration", COLUMN_FLOAT, offsetof(RallyRecord, duration) },
+    { "meanAngle", COLUMN_FLOAT, offsetof(RallyRecord, meanAngle) },
+    { "maxAngle", COLUMN_FLOAT, offsetof(RallyRecord, maxAngle) }
+};
+const int CResultStore::RALLY_COLUMN_COUNT = sizeof(RALLY_COLUMNS) / sizeof(RALLY_COLUMNS[0]);
+
+/// <summary>
+///     Default class constructor.
+/// </summary>
+CResultStore::CResultStore(void)
+    : m_matches(MATCH_COLUMNS, MATCH_COLUMN_COUNT)
+    , m_rallies(RALLY_COLUMNS, RALLY_COLUMN_COUNT)
+{
+}
+
+/// <summary>
+///     Open or create both tables.
+/// </summary>
+/// <param name="prefix">Path of the tables without their extensions.</param>
+/// <param name="writable">True to append, creating the tables if needed.</param>
+/// <returns>False if either could not be opened.</returns>
+bool CResultStore::open(const std::string& prefix, bool writable)
+{
+    if (!m_matches.open(prefix + ".matches", writable) || !m_rallies.open(prefix + ".rallies", writable))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+///     Close both tables. Every append must have returned.
+/// </summary>
+void CResultStore::close(void)
+{
+    m_matches.close();
+    m_rallies.close();
+}
+
+/// <summary>
+///     Append a match, safe from any number of threads.
+/// </summary>
+/// <returns>False if the table is full.</returns>
+bool CResultStore::append(const MatchRecord& record)
+{
+    return m_matches.append(&record);
+}
+
+/// <summary>
+///     Append a rally, safe from any number of threads.
+/// </summary>
+/// <returns>False if the table is full.</returns>
+bool CResultStore::append(const RallyRecord& record)
+{
+    return m_rallies.append(&record);
+}
+
+/// <summary>
+///     The match table, for queries.
+/// </summary>
+CColumnStore& CResultStore::matches(void)
+{
+    return m_matches;
+}
+
+/// <summary>
+///     The rally table, for queries.
+/// </summary>
+CColumnStore& CResultStore::rallies(void)
+{
+    return m_rallies;
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CRESULTSTORE_HPP
+#define WINTEN_CRESULTSTORE_HPP
+
+// Include external header files
+#include <cstdint>
+#include <string>
+
+// Include project header files
+#include "ccolumnstore.hpp"
+
+/// <summary>
+///     Outcome of one match.
+/// </summary>
+struct MatchRecord
+{
+    std::uint64_t seed;
+    // ControllerKind of each side, and a tracking controller's horizon
+    std::int32_t npcController;
+    std::int32_t playerController;
+    float npcHorizon;
+    float playerHorizon;
+    std::int32_t scoreNpc;
+    std::int32_t scorePlayer;
+    std::int32_t rallies;
+    // Simulated seconds
+    float duration;
+};
+
+/// <summary>
+///     One rally, from a serve or the last point to the next point.
+/// </summary>
+struct RallyRecord
+{
+    std::uint64_t seed;
+    std::int32_t rally;
+    // Paddle hits, and the side which won the point
+    std::int32_t hits;
+    std::int32_t winner;
+    // Simulated seconds
+    float duration;
+    // Mean and largest angle from horizontal of the hits, in degrees
+    float meanAngle;
+    float maxAngle;
+};
+
+/// <summary>
+///     Match and rally results of tournament runs, a columnar table of each
+///     stored beside each other as PREFIX.matches and PREFIX.rallies.
+/// </summary>
+class CResultStore
+{
+private:
+    CColumnStore m_matches;
+    CColumnStore m_rallies;
+
+public:
+    static const ColumnSpec MATCH_COLUMNS[];
+    static const int MATCH_COLUMN_COUNT;
+    static const ColumnSpec RALLY_COLUMNS[];
+    static const int RALLY_COLUMN_COUNT;
+
+    CResultStore(void);
+    bool open(const std::string& prefix, bool writable);
+    void close(void);
+    bool append(const MatchRecord& record);
+    bool append(const RallyRecord& record);
+    CColumnStore& matches(void);
+    CColumnStore& rallies(void);
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <chrono>
+#include <thread>
+
+// Include project header files
+#include "cschedulerchrono.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="rate">Target frame rate in hertz.</param>
+/// <param name="spinThreshold">Nanoseconds before each deadline to stop sleeping and spin.</param>
+CSchedulerChrono::CSchedulerChrono(float rate, std::int64_t spinThreshold)
+    : m_period()
+    , m_spinThreshold(std::chrono::nanoseconds(spinThreshold))
+    , m_deadline()
+    , m_started(false)
+    , m_stats()
+{
+    setRate(rate);
+}
+
+/// <summary>
+///     Set the target frame rate.
+/// </summary>
+/// <param name="rate">Frame rate in hertz.</param>
+void CSchedulerChrono::setRate(float rate)
+{
+    m_period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / static_cast<double>(rate)));
+}
+
+/// <summary>
+///     Set how long before each deadline the scheduler stops sleeping and spins.
+///     Zero sleeps the whole interval, larger values reduce jitter at the cost of CPU.
+/// </summary>
+/// <param name="spinThreshold">Spin interval in nanoseconds.</param>
+void CSchedulerChrono::setSpinThreshold(std::int64_t spinThreshold)
+{
+    m_spinThreshold = std::chrono::nanoseconds(spinThreshold);
+}
+
+/// <summary>
+///     Restart the deadline sequence one period from now.
+/// </summary>
+void CSchedulerChrono::reset(void)
+{
+    m_deadline = clock::now() + m_period;
+    m_started = true;
+}
+
+/// <summary>
+///     Block until the next deadline.
+/// </summary>
+void CSchedulerChrono::wait(void)
+{
+    clock::time_point thisTime;
+    std::int64_t error;
+
+    if (!m_started)
+        reset();
+
+    // Coarse sleep until just before the deadline
+    thisTime = clock::now();
+    if (m_deadline - thisTime > m_spinThreshold)
+        std::this_thread::sleep_for(m_deadline - thisTime - m_spinThreshold);
+
+    // Spin for the remainder
+    thisTime = clock::now();
+    while (thisTime < m_deadline)
+    {
+        std::this_thread::yield();
+        thisTime = clock::now();
+    }
+
+    // Record how late the wake-up was
+    error = std::chrono::duration_cast<std::chrono::nanoseconds>(thisTime - m_deadline).count();
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.wakeups++;
+        m_stats.lastError = error;
+        m_stats.totalError += error;
+        if (error > m_stats.maxError)
+            m_stats.maxError = error;
+    }
+
+    // Advance the deadline, dropping whole periods if overrun rather than bursting
+    m_deadline += m_period;
+    if (m_deadline <= thisTime)
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.missed += static_cast<std::uint64_t>((thisTime - m_deadline) / m_period) + 1;
+        m_deadline = thisTime + m_period;
+    }
+}
+
+/// <summary>
+///     Get a snapshot of the wake-up statistics.
+/// </summary>
+/// <returns>The statistics.</returns>
+SchedulerStats CSchedulerChrono::getStats(void) const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
@@ -0,0 +1,53 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CSCHEDULERCHRONO_HPP
+#define WINTEN_CSCHEDULERCHRONO_HPP
+
+// Include external header files
+#include <chrono>
+#include <mutex>
+
+// Include project header files
+#include "ischeduler.hpp"
+
+/// <summary>
+///     Portable frame scheduler using std::chrono::steady_clock. Sleeps until
+///     shortly before each deadline then spins for the remainder, so the spin
+///     threshold trades CPU time for wake-up jitter.
+/// </summary>
+class CSchedulerChrono : public IScheduler
+{
+private:
+    typedef std::chrono::steady_clock clock;
+
+    clock::duration m_period;
+    clock::duration m_spinThreshold;
+    clock::time_point m_deadline;
+    bool m_started;
+    // Statistics are read from other threads for display
+    mutable std::mutex m_statsMutex;
+    SchedulerStats m_stats;
+
+public:
+    CSchedulerChrono(float rate, std::int64_t spinThreshold);
+    void setRate(float rate) override;
+    void setSpinThreshold(std::int64_t spinThreshold);
+    void reset(void) override;
+    void wait(void) override;
+    SchedulerStats getStats(void) const override;
+};
+
+#endif
@@ -0,0 +1,528 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <exception>
+
+// Include project header files
+#include "csessionhost.hpp"
+#include "winten_constants.hpp"
+
+#if WINTEN_COROUTINES
+
+namespace
+{
+    // Index of the worker running on this thread, -1 on other threads
+    thread_local int t_worker = -1;
+}
+
+/// <summary>
+///     One hosted session. Its status word is the token of the timer it is
+///     parked on shifted left one, zero while queued or running, with the low
+///     bit set when input has arrived since its last tick. Whoever clears the
+///     token, its timer or an input, queues it to run.
+/// </summary>
+struct CSessionHost::Session
+{
+    SessionId id;
+    std::unique_ptr<IState> state;
+    std::coroutine_handle<> handle;
+    std::atomic<std::uint64_t> status;
+    // Worker whose timers the session is parked on, and its timer there
+    int worker;
+    TimerHandle timer;
+    std::mutex inputMutex;
+    SessionInput keys;
+    bool closing;
+
+    Session(void)
+        : id(0)
+        , state()
+        , handle()
+        , status(0)
+        , worker(0)
+        , timer{ -1, 0 }
+        , inputMutex()
+        , keys()
+        , closing(false) {}
+};
+
+/// <summary>
+///     Worker constructor.
+/// </summary>
+CSessionHost::Worker::Worker(void)
+    : mutex()
+    , wake()
+    , ready()
+    , queued(0)
+    , sleeping(false)
+    , notified(false)
+    , cancels()
+    , timers()
+    , cancelling()
+    , thread()
+    , ticks(0)
+    , inputs(0)
+    , steals(0)
+    , sleeps(0)
+    , idles(0)
+    , missed(0)
+    , totalLateness(0)
+    , maxLateness(0)
+    , busy(0)
+{
+}
+
+/// <summary>
+///     Park the session on a timer of the worker running it, unless input
+///     arrived since its last tick.
+/// </summary>
+/// <param name="handle">The suspending session coroutine.</param>
+/// <returns>False to carry on at once.</returns>
+bool CSessionHost::TickAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    Worker& worker = *host.m_workers[t_worker];
+    std::uint64_t token = host.m_nextToken++;
+    std::uint64_t expected = 0;
+
+    session->handle = handle;
+    session->worker = t_worker;
+    session->timer = worker.timers.schedule(deadline, Timer{ token, session });
+    // Once parked another thread may resume the session, so touch nothing after
+    return session->status.compare_exchange_strong(expected, token << 1);
+}
+
+/// <summary>
+///     Class constructor, starting the workers.
+/// </summary>
+/// <param name="threads">Number of worker threads, or zero for one per core.</param>
+/// <param name="rate">Tick rate of every session in hertz.</param>
+CSessionHost::CSessionHost(int threads, float rate)
+    : m_workers()
+    , m_period(static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / static_cast<double>(rate)))
+    , m_origin(std::chrono::steady_clock::now())
+    , m_sessionsMutex()
+    , m_sessions()
+    , m_nextId(1)
+    , m_nextToken(1)
+    , m_sleeping(0)
+    , m_nextWorker(0)
+    , m_stopping(false)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int index = 0; index < threads; index++)
+        m_workers.push_back(std::make_unique<Worker>());
+    for (int index = 0; index < threads; index++)
+        m_workers[index]->thread = std::thread(&CSessionHost::work, this, index);
+}
+
+/// <summary>
+///     Class destructor, stopping the workers and discarding every session.
+/// </summary>
+CSessionHost::~CSessionHost()
+{
+    m_stopping = true;
+    for (auto& worker : m_workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->notified = true;
+        }
+        worker->wake.notify_one();
+    }
+    for (auto& worker : m_workers)
+        worker->thread.join();
+
+    // Every session is suspended now, in a queue or on a timer
+    for (auto& session : m_sessions)
+        session.second->handle.destroy();
+    m_sessions.clear();
+}
+
+/// <summary>
+///     Start a session.
+/// </summary>
+/// <param name="state">The session's first state.</param>
+/// <returns>Identifier to send input to the session with.</returns>
+CSessionHost::SessionId CSessionHost::open(std::unique_ptr<IState> state)
+{
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    Worker& worker = *m_workers[m_nextWorker++ % m_workers.size()];
+
+    session->state = std::move(state);
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        session->id = m_nextId++;
+        m_sessions[session->id] = session;
+    }
+    session->handle = play(session).handle;
+    schedule(worker, session->handle);
+    return session->id;
+}
+
+/// <summary>
+///     Send keys to a session, waking it to tick early.
+/// </summary>
+/// <param name="id">Session to send to.</param>
+/// <param name="keys">Keys held, and whether any key was pressed.</param>
+/// <returns>False if there is no such session.</returns>
+bool CSessionHost::input(SessionId id, const SessionInput& keys)
+{
+    // Holding the map lock keeps the session from being retired meanwhile
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    auto found = m_sessions.find(id);
+    if (found == m_sessions.end())
+        return false;
+
+    Session& session = *found->second;
+    {
+        std::lock_guard<std::mutex> inputLock(session.inputMutex);
+        bool pressed = session.keys.keyPressed;
+        session.keys = keys;
+        session.keys.keyPressed = keys.keyPressed || pressed;
+    }
+    std::uint64_t status = session.status.fetch_or(1);
+    if ((status >> 1) != 0)
+        wake(session, status >> 1);
+    return true;
+}
+
+/// <summary>
+///     End a session at its next wake-up, which is brought forward to now.
+/// </summary>
+/// <param name="id">Session to end.</param>
+/// <returns>False if there is no such session.</returns>
+bool CSessionHost::close(SessionId id)
+{
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    auto found = m_sessions.find(id);
+    if (found == m_sessions.end())
+        return false;
+
+    Session& session = *found->second;
+    {
+        std::lock_guard<std::mutex> inputLock(session.inputMutex);
+        session.closing = true;
+    }
+    std::uint64_t status = session.status.fetch_or(1);
+    if ((status >> 1) != 0)
+        wake(session, status >> 1);
+    return true;
+}
+
+/// <summary>
+///     Get the number of open sessions.
+/// </summary>
+/// <returns>The session count.</returns>
+std::size_t CSessionHost::size(void) const
+{
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    return m_sessions.size();
+}
+
+/// <summary>
+///     Get the number of worker threads.
+/// </summary>
+/// <returns>The thread count.</returns>
+int CSessionHost::threads(void) const
+{
+    return static_cast<int>(m_workers.size());
+}
+
+/// <summary>
+///     Get the activity of all workers so far.
+/// </summary>
+/// <returns>The statistics.</returns>
+HostStats CSessionHost::getStats(void) const
+{
+    HostStats stats;
+
+    stats.sessions = size();
+    for (const auto& worker : m_workers)
+    {
+        stats.ticks += worker->ticks;
+        stats.inputs += worker->inputs;
+        stats.steals += worker->steals;
+        stats.sleeps += worker->sleeps;
+        stats.idles += worker->idles;
+        stats.missed += worker->missed;
+        stats.totalLateness += worker->totalLateness;
+        stats.maxLateness = std::max<std::int64_t>(stats.maxLateness, worker->maxLateness);
+        stats.busy += worker->busy;
+    }
+    return stats;
+}
+
+/// <summary>
+///     Loop of one session: wait for the next tick deadline, or the state's
+///     timeout if it has one, or an input, then update the state, until the
+///     session is closed.
+/// </summary>
+/// <param name="session">The session, kept alive by the coroutine frame.</param>
+CSessionHost::Task CSessionHost::play(std::shared_ptr<Session> session)
+{
+    std::int64_t lastTime = now();
+    std::int64_t deadline = lastTime + m_period;
+    std::int64_t timeout = 0;
+
+    for (;;)
+    {
+        bool idle = timeout > m_period;
+        std::int64_t wakeTime = idle ? lastTime + timeout : deadline;
+        co_await TickAwaiter{ *this, session, wakeTime };
+
+        Worker& worker = *m_workers[t_worker];
+        SessionInput keys;
+        bool closing;
+
+        // Drop the timer if input or closing woke the session first, so it
+        // does not hold the session until its deadline
+        cancelTimer(*session);
+
+        // Input after this point wakes the next wait instead
+        session->status = 0;
+        {
+            std::lock_guard<std::mutex> lock(session->inputMutex);
+            keys = session->keys;
+            closing = session->closing;
+            session->keys.keyPressed = false;
+        }
+        if (closing)
+            break;
+
+        // A deadline is followed by the next, dropping whole periods if late.
+        // Input ticks early and leaves the deadline where it is. Ticking
+        // resumes a period after an idle wait however it ends.
+        std::int64_t thisTime = now();
+        if (thisTime >= wakeTime)
+        {
+            std::int64_t lateness = thisTime - wakeTime;
+            worker.totalLateness += lateness;
+            if (lateness > worker.maxLateness)
+                worker.maxLateness = lateness;
+            deadline += m_period;
+            if (deadline <= thisTime && !idle)
+            {
+                worker.missed += static_cast<std::uint64_t>((thisTime - deadline) / m_period) + 1;
+                deadline = thisTime + m_period;
+            }
+        }
+        else
+            worker.inputs++;
+        if (idle)
+        {
+            worker.idles++;
+            deadline = thisTime + m_period;
+        }
+
+        std::unique_ptr<IState> nextState = session->state->update(
+            thisTime - lastTime,
+            keys.keyUp,
+            keys.keyDown,
+            keys.keyEscape,
+            keys.keyPressed);
+        if (nextState)
+            session->state = std::move(nextState);
+        timeout = session->state->timeout();
+        lastTime = thisTime;
+        worker.ticks++;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    m_sessions.erase(session->id);
+}
+
+/// <summary>
+///     Worker thread loop: wake sessions whose timers have expired, run
+///     queued sessions, steal from other workers when out of work, and sleep
+///     until the earliest timer when there is nothing to steal.
+/// </summary>
+/// <param name="index">Index of the worker.</param>
+void CSessionHost::work(int index)
+{
+    Worker& worker = *m_workers[index];
+    t_worker = index;
+
+    while (!m_stopping)
+    {
+        std::int64_t thisTime = now();
+        worker.timers.advance(thisTime, [&](Timer& timer) { wake(*timer.session, timer.token); });
+
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.cancels.swap(worker.cancelling);
+            if (!worker.ready.empty())
+            {
+                handle = worker.ready.front();
+                worker.ready.pop_front();
+                worker.queued--;
+            }
+        }
+        for (TimerHandle timer : worker.cancelling)
+            worker.timers.cancel(timer);
+        worker.cancelling.clear();
+        if (!handle)
+        {
+            handle = steal(index);
+            if (handle)
+                worker.steals++;
+        }
+        if (handle)
+        {
+            handle.resume();
+            worker.busy += now() - thisTime;
+            continue;
+        }
+
+        std::int64_t nextTime = worker.timers.nextDeadline();
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        if (!worker.ready.empty() || m_stopping)
+            continue;
+        if (nextTime >= 0 && nextTime <= now())
+            continue;
+        worker.sleeping = true;
+        worker.notified = false;
+        worker.sleeps++;
+        m_sleeping++;
+        if (nextTime < 0)
+            worker.wake.wait(lock, [&]() { return worker.notified || !worker.ready.empty(); });
+        else
+            worker.wake.wait_until(
+                lock,
+                m_origin + std::chrono::nanoseconds(nextTime),
+                [&]() { return worker.notified || !worker.ready.empty(); });
+        m_sleeping--;
+        worker.sleeping = false;
+    }
+}
+
+/// <summary>
+///     Queue a session coroutine on a worker. If the worker is busy and
+///     another is asleep, wake that one to steal it.
+/// </summary>
+/// <param name="worker">Worker to queue on.</param>
+/// <param name="handle">Session coroutine.</param>
+void CSessionHost::schedule(Worker& worker, std::coroutine_handle<> handle)
+{
+    bool sleeping;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.ready.push_back(handle);
+        worker.queued++;
+        sleeping = worker.sleeping;
+    }
+    if (sleeping)
+    {
+        worker.wake.notify_one();
+        return;
+    }
+    if (m_sleeping == 0)
+        return;
+
+    for (auto& other : m_workers)
+    {
+        std::unique_lock<std::mutex> lock(other->mutex);
+        if (other->sleeping && !other->notified)
+        {
+            other->notified = true;
+            lock.unlock();
+            other->wake.notify_one();
+            return;
+        }
+    }
+}
+
+/// <summary>
+///     Queue a session if it is still parked on the given wait.
+/// </summary>
+/// <param name="session">Session to wake.</param>
+/// <param name="token">Token of the wait to end.</param>
+/// <returns>True if this call woke it.</returns>
+bool CSessionHost::wake(Session& session, std::uint64_t token)
+{
+    std::uint64_t status = session.status;
+
+    while ((status >> 1) == token)
+    {
+        if (session.status.compare_exchange_weak(status, status & 1))
+        {
+            schedule(*m_workers[session.worker], session.handle);
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+///     Cancel the timer a resumed session was parked on. The timer wheel
+///     belongs to the worker that parked it, so a session resumed on another
+///     worker hands the cancel to that one. Nothing happens if the timer
+///     has already expired.
+/// </summary>
+/// <param name="session">The resumed session.</param>
+void CSessionHost::cancelTimer(Session& session)
+{
+    Worker& owner = *m_workers[session.worker];
+
+    if (session.worker == t_worker)
+    {
+        owner.timers.cancel(session.timer);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    owner.cancels.push_back(session.timer);
+}
+
+/// <summary>
+///     Take the most recently queued session of another worker.
+/// </summary>
+/// <param name="thief">Index of the stealing worker.</param>
+/// <returns>The session coroutine, or null if every queue is empty.</returns>
+std::coroutine_handle<> CSessionHost::steal(int thief)
+{
+    int count = static_cast<int>(m_workers.size());
+
+    for (int offset = 1; offset < count; offset++)
+    {
+        Worker& victim = *m_workers[(thief + offset) % count];
+        if (victim.queued == 0)
+            continue;
+
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ready.empty())
+        {
+            std::coroutine_handle<> handle = victim.ready.back();
+            victim.ready.pop_back();
+            victim.queued--;
+            return handle;
+        }
+    }
+    return std::coroutine_handle<>();
+}
+
+/// <summary>
+///     Get the host's time.
+/// </summary>
+/// <returns>Nanoseconds since the host started.</returns>
+std::int64_t CSessionHost::now(void) const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_origin).count();
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CSESSIONHOST_HPP
+#define WINTEN_CSESSIONHOST_HPP
+
+// Sessions are C++20 coroutines, so the host only exists in C++20 builds
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define WINTEN_COROUTINES 1
+#else
+#define WINTEN_COROUTINES 0
+#endif
+
+#if WINTEN_COROUTINES
+
+// Include external header files
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Include project header files
+#include "ctimingwheel.hpp"
+#include "istate.hpp"
+
+/// <summary>
+///     Keys sent to a session. Held keys replace the last ones sent, and a
+///     press is kept until the session's next tick.
+/// </summary>
+struct SessionInput
+{
+    bool keyUp;
+    bool keyDown;
+    bool keyEscape;
+    bool keyPressed;
+};
+
+/// <summary>
+///     Activity of a session host since it started.
+/// </summary>
+struct HostStats
+{
+    // Sessions open now
+    std::uint64_t sessions;
+    // State updates run, and those woken early by input
+    std::uint64_t ticks;
+    std::uint64_t inputs;
+    // Sessions run by a worker other than the one which queued them
+    std::uint64_t steals;
+    // Times a worker found nothing to run and slept
+    std::uint64_t sleeps;
+    // Waits for a state's timeout instead of the next tick
+    std::uint64_t idles;
+    // Whole tick periods dropped because a session woke too late
+    std::uint64_t missed;
+    // Wake-up lateness after tick deadlines in nanoseconds
+    std::int64_t totalLateness;
+    std::int64_t maxLateness;
+    // Time workers spent running sessions, in nanoseconds
+    std::int64_t busy;
+
+    HostStats(void)
+        : sessions(0)
+        , ticks(0)
+        , inputs(0)
+        , steals(0)
+        , sleeps(0)
+        , idles(0)
+        , missed(0)
+        , totalLateness(0)
+        , maxLateness(0)
+        , busy(0) {}
+};
+
+/// <summary>
+///     Hosts many independent sessions, each an intro, demo or game state of
+///     its own, on a small pool of worker threads. Every session is a
+///     coroutine which suspends until its next tick deadline or an input, so
+///     a suspended session costs nothing but its timer. A state with nothing
+///     to do until a timeout, such as the intro screen, sleeps until then.
+///     Each worker has its own run queue and timing wheel, and an idle worker
+///     steals from the others before sleeping until its earliest deadline.
+/// </summary>
+class CSessionHost
+{
+public:
+    typedef std::uint32_t SessionId;
+
+private:
+    struct Session;
+
+    /// <summary>
+    ///     Coroutine type of a session's loop. The frame starts suspended
+    ///     and frees itself when the loop returns.
+    /// </summary>
+    struct Task
+    {
+        struct promise_type
+        {
+            Task get_return_object(void)
+            {
+                return Task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+            std::suspend_always initial_suspend(void) noexcept { return {}; }
+            std::suspend_never final_suspend(void) noexcept { return {}; }
+            void return_void(void) {}
+            void unhandled_exception(void) { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // Timer waking a session if it is still parked with the same token
+    struct Timer
+    {
+        std::uint64_t token;
+        std::shared_ptr<Session> session;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::coroutine_handle<>> ready;
+        // Length of the run queue, to pass over empty ones when stealing
+        std::atomic<int> queued;
+        // Whether the worker is waiting, and whether it has been woken to steal
+        bool sleeping;
+        bool notified;
+        // Timers of sessions resumed on other workers, to cancel here
+        std::vector<TimerHandle> cancels;
+        // Only touched by the worker's own thread
+        CTimingWheel<Timer> timers;
+        std::vector<TimerHandle> cancelling;
+        std::thread thread;
+        // Statistics, read from other threads
+        std::atomic<std::uint64_t> ticks;
+        std::atomic<std::uint64_t> inputs;
+        std::atomic<std::uint64_t> steals;
+        std::atomic<std::uint64_t> sleeps;
+        std::atomic<std::uint64_t> idles;
+        std::atomic<std::uint64_t> missed;
+        std::atomic<std::int64_t> totalLateness;
+        std::atomic<std::int64_t> maxLateness;
+        std::atomic<std::int64_t> busy;
+
+        Worker(void);
+    };
+
+    // Suspends a session until its deadline, or at once if input is waiting
+    struct TickAwaiter
+    {
+        CSessionHost& host;
+        const std::shared_ptr<Session>& session;
+        std::int64_t deadline;
+
+        bool await_ready(void) const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume(void) const noexcept {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::int64_t m_period;
+    std::chrono::steady_clock::time_point m_origin;
+    mutable std::mutex m_sessionsMutex;
+    std::unordered_map<SessionId, std::shared_ptr<Session>> m_sessions;
+    SessionId m_nextId;
+    std::atomic<std::uint64_t> m_nextToken;
+    std::atomic<int> m_sleeping;
+    std::atomic<unsigned> m_nextWorker;
+    std::atomic<bool> m_stopping;
+
+    Task play(std::shared_ptr<Session> session);
+    void work(int index);
+    void schedule(Worker& worker, std::coroutine_handle<> handle);
+    bool wake(Session& session, std::uint64_t token);
+    void cancelTimer(Session& session);
+    std::coroutine_handle<> steal(int thief);
+    std::int64_t now(void) const;
+
+public:
+    CSessionHost(int threads, float rate);
+    ~CSessionHost();
+    CSessionHost(const CSessionHost&) = delete;
+    CSessionHost& operator=(const CSessionHost&) = delete;
+    SessionId open(std::unique_ptr<IState> state);
+    bool input(SessionId id, const SessionInput& keys);
+    bool close(SessionId id);
+    std::size_t size(void) const;
+    int threads(void) const;
+    HostStats getStats(void) const;
+};
+
+#endif
+
+#endif
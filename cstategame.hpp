@@ -16,43 +16,26 @@
 #ifndef WINTEN_CSTATEGAME_HPP
 #define WINTEN_CSTATEGAME_HPP
 
+// Include external header files
+#include <cstdint>
+#include <memory>
+
 // Include project header files
 #include "istate.hpp"
-#include "vector2d.hpp"
 
 /// <summary>
 ///     Implements the player vs NPC game state.
 /// </summary>
 class CStateGame : public IState
 {
-private:
-    // State of ball velocity
-    float m_ballSpeed;
-    float m_ballAngle;
-    bool m_ballDirection;
-
 public:
     CStateGame();
     std::unique_ptr<IState> update(
-        float deltaT,
+        std::int64_t deltaT,
         bool keyUp,
         bool keyDown,
         bool keyEscape,
         bool keyPressed) override;
-    // Handle keystroke movement of paddle
-    void updatePlayer(
-        bool keyUp, 
-        bool keyDown, 
-        vector2d<float>& paddle, 
-        float delta);
-    // Handle NPC paddle
-    void updateNpc(
-        vector2d<float>& paddle,
-        vector2d<float>& ball,
-        float delta);
-    bool isCollision(vector2d<float>& paddle);
-    // Handle dynamics of ball
-    bool updateBall(float delta);
 };
 
 #endif
\ No newline at end of file
@@ -15,79 +15,81 @@
 */
 // Include external header files
 #include <memory>
-#include <random>
-#include <ctime>
 
 // include project header files
 #include "cstatedemo.hpp"
 #include "cstategame.hpp"
 #include "cstateintro.hpp"
+#include "systems.hpp"
 #include "winten_constants.hpp"
-#include "vector2d.hpp"
 
 /// <summary>
 ///     Default class constructor.
 /// </summary>
 CStateIntro::CStateIntro()
-    : m_ballDirection(false)
-    , m_ballAngle(0)
-    , m_ballSpeed(winten_constants::BALL_SPEED)
-    , m_startTime(0)
+    : m_elapsed(0)
 {
-    // Initialise coordinates
-    npc.x = winten_constants::PADDLE_X_NPC;
-    npc.y = winten_constants::H / 2.0f;
-    player.x = winten_constants::PADDLE_X_PLAYER;
-    player.y = winten_constants::H / 2.0f;
-    ball.x = winten_constants::W / 2.0f;
-    ball.y = winten_constants::H / 2.0f;
-
-    // Save the start time in this state
-    m_startTime = std::time(0);
+    // Stationary paddles and ball behind the title
+    systems::createPaddle(world, winten_constants::PADDLE_X_PLAYER, nullptr);
+    systems::createPaddle(world, winten_constants::PADDLE_X_NPC, nullptr);
+    systems::createBall(world, winten_constants::W / 2.0f, winten_constants::H / 2.0f, nullptr);
+    systems::createScores(world);
 
     // Set the intro screen message
-    message = "         WIN-TENNIS\nPRESS KEY TO START";
-    
-    // Seed the random number generator with current time
-    std::srand(static_cast<unsigned int>(std::time(0)));
+    systems::createText(
+        world,
+        winten_constants::MESSAGE_TEXT_X,
+        winten_constants::MESSAGE_TEXT_Y,
+        "         WIN-TENNIS\nPRESS KEY TO START",
+        -1);
 }
 
 /// <summary>
 ///     Updates the game world during this state.
 /// </summary>
-/// <param name="deltaT">Time difference in seconds between updates.</param>
+/// <param name="deltaT">Time difference in ticks between updates.</param>
 /// <param name="keyUp">State of the up key.</param>
 /// <param name="keyDown">State of the down key.</param>
 /// <param name="keyEscape">State of the escape key.</param>
 /// <param name="keyPressed">True if any key pressed.</param>
 /// <returns>The next state.</returns>
 std::unique_ptr<IState> CStateIntro::update(
-    float deltaT,
+    std::int64_t deltaT,
     bool keyUp,
     bool keyDown,
     bool keyEscape,
     bool keyPressed)
 {
     std::unique_ptr<IState> nextState(nullptr);
-    std::time_t thisTime;
 
-    // Get the current time
-    thisTime = std::time(0);
+    // Accumulate time spent in this state
+    m_elapsed += deltaT;
 
     // If key pressed transition to player-vs-npc game
     if (keyPressed)
     {
+        world.events.push(EVENT_TRANSITION, 0, 0, GAME_STATE_GAME);
         nextState = std::move(std::make_unique<CStateGame>());
         // Enter the player-vs-npc state
         return nextState;
     }
     // If timeout transition to demo game
-    else if ((thisTime - m_startTime) > winten_constants::DELAY_DEMO)
+    else if (m_elapsed > winten_constants::DELAY_DEMO)
     {
+        world.events.push(EVENT_TRANSITION, 0, 0, GAME_STATE_DEMO);
         nextState = std::move(std::make_unique<CStateDemo>());
         // Enter the player-vs-npc state
         return nextState;
     }
 
     return nextState;
-}
\ No newline at end of file
+}
+
+/// <summary>
+///     Time until the demo starts, the screen being static until then.
+/// </summary>
+/// <returns>Clock ticks until the next update is needed.</returns>
+std::int64_t CStateIntro::timeout(void) const
+{
+    return m_elapsed > winten_constants::DELAY_DEMO ? 0 : winten_constants::DELAY_DEMO - m_elapsed + 1;
+}
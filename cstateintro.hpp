@@ -16,34 +16,31 @@
 #ifndef WINTEN_CStateIntro_HPP
 #define WINTEN_CStateIntro_HPP
 
-// Include external header fiels
-#include <ctime>
+// Include external header files
+#include <cstdint>
 #include <memory>
 
 // Include project header files
 #include "istate.hpp"
-#include "vector2d.hpp"
 
 /// <summary>
-///     Implements the player vs NPC game state.
+///     Implements the intro screen state.
 /// </summary>
 class CStateIntro : public IState
 {
 private:
-    // State of ball velocity
-    float m_ballSpeed;
-    float m_ballAngle;
-    bool m_ballDirection;
-    std::time_t m_startTime;
+    // Ticks elapsed in this state
+    std::int64_t m_elapsed;
 
 public:
     CStateIntro();
     std::unique_ptr<IState> update(
-        float deltaT,
+        std::int64_t deltaT,
         bool keyUp,
         bool keyDown,
         bool keyEscape,
         bool keyPressed) override;
+    std::int64_t timeout(void) const override;
 };
 
 #endif
\ No newline at end of file
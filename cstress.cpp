@@ -0,0 +1,549 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Include project header files
+#include "angletable.hpp"
+#include "cstress.hpp"
+#include "systems.hpp"
+#include "winten_constants.hpp"
+
+const float CStress::PADDLE_X[2] = { winten_constants::PADDLE_X_NPC, winten_constants::PADDLE_X_PLAYER };
+const float CStress::STUCK_SECONDS = 0.1f;
+
+namespace
+{
+    const float NOMINAL_DELTA = 1.0f / winten_constants::TICK_RATE;
+    // Ticks each lane advances per round
+    const int ROUND_TICKS = 256;
+
+    /// <summary>
+    ///     Small splitmix64 generator for the time step and key schedules,
+    ///     the same on every platform unlike the standard distributions.
+    /// </summary>
+    class CScheduleRandom
+    {
+    private:
+        std::uint64_t m_state;
+
+    public:
+        explicit CScheduleRandom(std::uint64_t seed)
+            : m_state(seed) {}
+
+        std::uint64_t next(void)
+        {
+            std::uint64_t value = (m_state += 0x9E3779B97F4A7C15ull);
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+
+        float uniform(float low, float high)
+        {
+            return low + (high - low) * static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+        }
+    };
+}
+
+/// <summary>
+///     Format as a replay token: the seed, the longest step in milliseconds
+///     and the failing tick, then if minimized the ticks which keep their
+///     scheduled step, each part after a slash.
+/// </summary>
+/// <returns>The token.</returns>
+std::string StressFailure::token(void) const
+{
+    char text[64];
+    std::string result;
+
+    std::snprintf(
+        text,
+        sizeof(text),
+        "%llu/%g/%d",
+        static_cast<unsigned long long>(seed),
+        maxDelta * 1000.0f,
+        tick);
+    result = text;
+    if (irregular < 0)
+        return result;
+    result += '/';
+    for (std::size_t index = 0; index < kept.size(); index++)
+    {
+        std::snprintf(text, sizeof(text), index > 0 ? ",%d" : "%d", kept[index]);
+        result += text;
+    }
+    return result;
+}
+
+/// <summary>
+///     Read a replay token written by token().
+/// </summary>
+/// <param name="text">The token.</param>
+/// <returns>False if it is malformed.</returns>
+bool StressFailure::parse(const char* text)
+{
+    char* end;
+
+    *this = StressFailure();
+    seed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '/')
+        return false;
+    text = end + 1;
+    maxDelta = std::strtof(text, &end) / 1000.0f;
+    if (end == text || !(maxDelta > 0.0f) || *end != '/')
+        return false;
+    text = end + 1;
+    tick = static_cast<int>(std::strtol(text, &end, 10));
+    if (end == text || tick < 0)
+        return false;
+    irregular = -1;
+    if (*end == '\0')
+        return true;
+    if (*end != '/')
+        return false;
+    irregular = 0;
+    for (text = end + 1; *text != '\0'; text = end + (*end == ',' ? 1 : 0))
+    {
+        long tick = std::strtol(text, &end, 10);
+        if (end == text || tick < 0)
+            return false;
+        kept.push_back(static_cast<int>(tick));
+    }
+    return true;
+}
+
+/// <summary>
+///     Class constructor, starting every lane of every thread.
+/// </summary>
+/// <param name="settings">Stress settings.</param>
+CStress::CStress(const StressSettings& settings)
+    : m_settings(settings)
+    , m_workers(static_cast<std::size_t>(std::max(settings.threads, 1)))
+    , m_pool(std::max(settings.threads, 1))
+    , m_stats()
+    , m_failureMutex()
+    , m_failures()
+{
+    std::size_t lanes = static_cast<std::size_t>(std::max(settings.lanes, 1));
+
+    m_settings.ticks = std::max(m_settings.ticks, 1);
+    m_settings.maxDelta = std::max(m_settings.maxDelta, NOMINAL_DELTA);
+    for (std::size_t worker = 0; worker < m_workers.size(); worker++)
+    {
+        Worker& self = m_workers[worker];
+        Batch& batch = self.batch;
+
+        // Each thread takes every thread-count'th seed
+        self.next = worker;
+        self.lanes.resize(lanes);
+        batch.x.resize(lanes);
+        batch.y.resize(lanes);
+        batch.lastX.resize(lanes);
+        batch.lastY.resize(lanes);
+        batch.delta.resize(lanes);
+        batch.violations.resize(lanes);
+        for (int paddle = 0; paddle < 2; paddle++)
+        {
+            batch.paddleY[paddle].resize(lanes);
+            batch.contact[paddle].assign(lanes, 0.0f);
+            batch.touched[paddle].assign(lanes, 0);
+        }
+        for (std::size_t lane = 0; lane < lanes; lane++)
+        {
+            start(self.lanes[lane], m_settings.seed + self.next, m_settings);
+            self.next += m_workers.size();
+            gather(self.lanes[lane], batch, lane);
+        }
+    }
+    m_stats.threads = m_pool.size();
+}
+
+/// <summary>
+///     Start a match from its seed: the tracking rule against a paddle
+///     holding random keys, a serve in a random direction, and a time step
+///     schedule drawn from one of four distributions.
+/// </summary>
+/// <param name="lane">Lane to start.</param>
+/// <param name="seed">Seed of the match.</param>
+/// <param name="settings">Stress settings.</param>
+void CStress::start(Lane& lane, std::uint64_t seed, const StressSettings& settings)
+{
+    Controller tracking = {
+        CONTROLLER_TRACKING,
+        winten_constants::PADDLE_SPEED,
+        winten_constants::NPC_HORIZON,
+        false,
+        ACTION_STAY };
+    Controller keyboard = { CONTROLLER_KEYBOARD, winten_constants::PADDLE_SPEED, 0.0f, false, ACTION_STAY };
+    CScheduleRandom random(~seed);
+    int regime = static_cast<int>(random.next() % 4);
+    int held = 0;
+    std::uint8_t key = 0;
+
+    lane.world = CRegistry();
+    lane.world.seed(seed);
+    Velocity serve = {
+        winten_constants::BALL_SPEED,
+        static_cast<int>(lane.world.random() % angle_table::STEPS),
+        (lane.world.random() & 1) != 0 };
+
+    lane.paddles[0] = systems::createPaddle(lane.world, PADDLE_X[0], &tracking);
+    lane.paddles[1] = systems::createPaddle(lane.world, PADDLE_X[1], &keyboard);
+    lane.ball = systems::createBall(lane.world, winten_constants::W / 2.0f, winten_constants::H / 2.0f, &serve);
+    lane.seed = seed;
+    lane.tick = 0;
+
+    lane.deltas.resize(static_cast<std::size_t>(settings.ticks));
+    lane.keys.resize(static_cast<std::size_t>(settings.ticks));
+    for (int tick = 0; tick < settings.ticks; tick++)
+    {
+        float delta = NOMINAL_DELTA;
+        switch (regime)
+        {
+        case 1:
+            // Jitter about the nominal tick
+            delta = std::min(random.uniform(0.5f, 1.5f) * NOMINAL_DELTA, settings.maxDelta);
+            break;
+        case 2:
+            // Nominal ticks with occasional stalls
+            if (random.next() % 64 == 0)
+                delta = random.uniform(NOMINAL_DELTA, settings.maxDelta);
+            break;
+        case 3:
+            // Anything from a millisecond to the longest step
+            delta = random.uniform(0.001f, settings.maxDelta);
+            break;
+        default:
+            break;
+        }
+        lane.deltas[tick] = delta;
+
+        // Hold random keys for a random number of ticks
+        if (held-- <= 0)
+        {
+            key = static_cast<std::uint8_t>(random.next() % 3);
+            held = static_cast<int>(random.next() % 32);
+        }
+        lane.keys[tick] = key;
+    }
+}
+
+/// <summary>
+///     Copy a lane's ball and paddles into the batch arrays, keeping the
+///     ball's previous position.
+/// </summary>
+/// <param name="lane">Lane just stepped.</param>
+/// <param name="batch">Batch to fill.</param>
+/// <param name="index">Lane index.</param>
+void CStress::gather(const Lane& lane, Batch& batch, std::size_t index)
+{
+    const Position& ball = lane.world.positions.get(lane.ball);
+
+    batch.lastX[index] = batch.x[index];
+    batch.lastY[index] = batch.y[index];
+    batch.x[index] = ball.x;
+    batch.y[index] = ball.y;
+    batch.delta[index] = lane.tick > 0 ? lane.deltas[lane.tick - 1] : 0.0f;
+    for (int paddle = 0; paddle < 2; paddle++)
+        batch.paddleY[paddle][index] = lane.world.positions.get(lane.paddles[paddle]).y;
+    if (lane.tick == 0)
+    {
+        batch.lastX[index] = ball.x;
+        batch.lastY[index] = ball.y;
+        for (int paddle = 0; paddle < 2; paddle++)
+        {
+            batch.contact[paddle][index] = 0.0f;
+            batch.touched[paddle][index] = 0;
+        }
+    }
+}
+
+/// <summary>
+///     Check the invariants of every lane of a batch, setting each lane's
+///     violation mask. The predicates combine comparisons with bitwise
+///     operators rather than branches so each loop vectorizes.
+/// </summary>
+/// <param name="batch">Batch to check.</param>
+/// <param name="count">Number of lanes.</param>
+void CStress::check(Batch& batch, std::size_t count)
+{
+    const float halfLevel = winten_constants::PADDLE_HEIGHT / 2.0f;
+    const float touchX = (winten_constants::PADDLE_WIDTH + winten_constants::BALL_DIAMETER) / 2.0f + 1.0f;
+    const float touchY = (winten_constants::PADDLE_HEIGHT + winten_constants::BALL_DIAMETER) / 2.0f;
+    const float* x = batch.x.data();
+    const float* y = batch.y.data();
+    const float* lastX = batch.lastX.data();
+    const float* lastY = batch.lastY.data();
+    const float* delta = batch.delta.data();
+    std::uint8_t* violations = batch.violations.data();
+
+    // Inside the field, which a NaN never is
+    for (std::size_t lane = 0; lane < count; lane++)
+    {
+        std::uint8_t inside = static_cast<std::uint8_t>(
+            (x[lane] >= winten_constants::BALL_MIN_X) & (x[lane] <= winten_constants::BALL_MAX_X)
+            & (y[lane] >= winten_constants::BALL_MIN_Y) & (y[lane] <= winten_constants::BALL_MAX_Y));
+        violations[lane] = static_cast<std::uint8_t>((inside ^ 1) * VIOLATION_FIELD);
+    }
+
+    for (int paddle = 0; paddle < 2; paddle++)
+    {
+        // In front of the left paddle is to its right, and of the right to its left
+        const float side = paddle == 0 ? 1.0f : -1.0f;
+        const float paddleX = PADDLE_X[paddle];
+        const float* paddleY = batch.paddleY[paddle].data();
+        float* contact = batch.contact[paddle].data();
+        std::uint8_t* touched = batch.touched[paddle].data();
+
+        for (std::size_t lane = 0; lane < count; lane++)
+        {
+            std::uint8_t wasFront = side * (lastX[lane] - paddleX) > 0.0f;
+            std::uint8_t isBehind = side * (x[lane] - paddleX) < 0.0f;
+            std::uint8_t level = (std::fabs(y[lane] - paddleY[lane]) < halfLevel)
+                & (std::fabs(lastY[lane] - paddleY[lane]) < halfLevel);
+            std::uint8_t touching = (side * (x[lane] - paddleX) > 0.0f)
+                & (std::fabs(x[lane] - paddleX) < touchX)
+                & (std::fabs(y[lane] - paddleY[lane]) < touchY);
+
+            // Time spent against the front face since the tick reaching it,
+            // reset on leaving it, so one long step ending there does not count
+            contact[lane] = (contact[lane] + delta[lane] * touched[lane]) * touching;
+            touched[lane] = touching;
+            violations[lane] |= static_cast<std::uint8_t>(
+                (wasFront & isBehind & level) * VIOLATION_TUNNEL
+                | (contact[lane] > STUCK_SECONDS) * VIOLATION_STUCK);
+        }
+    }
+}
+
+/// <summary>
+///     Advance one thread's lanes for a round, checking every tick. Lanes
+///     which finish or fail start the thread's next seed.
+/// </summary>
+/// <param name="worker">Worker index.</param>
+void CStress::play(int worker)
+{
+    Worker& self = m_workers[worker];
+    std::size_t count = self.lanes.size();
+
+    for (int round = 0; round < ROUND_TICKS; round++)
+    {
+        for (std::size_t index = 0; index < count; index++)
+        {
+            Lane& lane = self.lanes[index];
+            std::uint8_t key = lane.keys[lane.tick];
+            systems::Input input = { key == 1, key == 2 };
+
+            systems::step(lane.world, input, lane.deltas[lane.tick]);
+            lane.tick++;
+            gather(lane, self.batch, index);
+        }
+        check(self.batch, count);
+        self.stats.ticks += count;
+
+        for (std::size_t index = 0; index < count; index++)
+        {
+            Lane& lane = self.lanes[index];
+            std::uint8_t violations = self.batch.violations[index];
+            if (violations == 0 && lane.tick < m_settings.ticks)
+                continue;
+
+            if (violations != 0)
+            {
+                StressFailure failure;
+                failure.seed = lane.seed;
+                failure.maxDelta = m_settings.maxDelta;
+                failure.tick = lane.tick - 1;
+                failure.violations = violations;
+                failure.irregular = -1;
+                self.stats.failures++;
+                std::lock_guard<std::mutex> lock(m_failureMutex);
+                m_failures.push_back(failure);
+            }
+            self.stats.matches++;
+            start(lane, m_settings.seed + self.next, m_settings);
+            self.next += m_workers.size();
+            gather(lane, self.batch, index);
+        }
+    }
+}
+
+/// <summary>
+///     Advance every thread's lanes for a round in parallel.
+/// </summary>
+void CStress::round(void)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_pool.run(static_cast<int>(m_workers.size()), [this](int worker) {
+        play(worker);
+    });
+
+    m_stats.ticks = 0;
+    m_stats.matches = 0;
+    m_stats.failures = 0;
+    for (const Worker& worker : m_workers)
+    {
+        m_stats.ticks += worker.stats.ticks;
+        m_stats.matches += worker.stats.matches;
+        m_stats.failures += worker.stats.failures;
+    }
+    m_stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// <summary>
+///     Get the counters so far.
+/// </summary>
+/// <returns>The counters.</returns>
+StressStats CStress::getStats(void) const
+{
+    return m_stats;
+}
+
+/// <summary>
+///     Take the failures found since the last call.
+/// </summary>
+/// <returns>Failing seeds and ticks, not yet minimized.</returns>
+std::vector<StressFailure> CStress::takeFailures(void)
+{
+    std::lock_guard<std::mutex> lock(m_failureMutex);
+    std::vector<StressFailure> result;
+
+    result.swap(m_failures);
+    return result;
+}
+
+/// <summary>
+///     Replay one match on its own, with every step the nominal tick except
+///     the kept ones if minimized, until an invariant fails or it ends.
+/// </summary>
+/// <param name="failure">Seed and kept ticks to replay.</param>
+/// <param name="trace">Receives the match after every tick, or nullptr.</param>
+/// <returns>The seed with the failing tick and violations, none if it passed.</returns>
+StressFailure CStress::replay(const StressFailure& failure, std::vector<CRegistry>* trace) const
+{
+    StressFailure result = failure;
+    Lane lane;
+    Batch batch;
+
+    start(lane, failure.seed, m_settings);
+    if (failure.irregular >= 0)
+    {
+        std::vector<float> scheduled;
+        scheduled.swap(lane.deltas);
+        lane.deltas.assign(scheduled.size(), NOMINAL_DELTA);
+        for (int tick : failure.kept)
+            if (tick < static_cast<int>(scheduled.size()))
+                lane.deltas[tick] = scheduled[tick];
+    }
+
+    batch.x.resize(1);
+    batch.y.resize(1);
+    batch.lastX.resize(1);
+    batch.lastY.resize(1);
+    batch.delta.resize(1);
+    batch.violations.resize(1);
+    for (int paddle = 0; paddle < 2; paddle++)
+    {
+        batch.paddleY[paddle].resize(1);
+        batch.contact[paddle].assign(1, 0.0f);
+        batch.touched[paddle].assign(1, 0);
+    }
+    gather(lane, batch, 0);
+
+    result.tick = 0;
+    result.violations = 0;
+    if (trace != nullptr)
+        trace->clear();
+    while (lane.tick < m_settings.ticks)
+    {
+        std::uint8_t key = lane.keys[lane.tick];
+        systems::Input input = { key == 1, key == 2 };
+
+        systems::step(lane.world, input, lane.deltas[lane.tick]);
+        lane.tick++;
+        if (trace != nullptr)
+            trace->push_back(lane.world);
+        gather(lane, batch, 0);
+        check(batch, 1);
+        if (batch.violations[0] != 0)
+        {
+            result.tick = lane.tick - 1;
+            result.violations = batch.violations[0];
+            break;
+        }
+    }
+    return result;
+}
+
+/// <summary>
+///     Reduce a failure to the fewest irregular time steps which still break
+///     the same invariant, by trying to make ever smaller runs of them nominal.
+///     Steps after the failing tick cannot matter and are dropped first.
+/// </summary>
+/// <param name="failure">Failure found by a round.</param>
+/// <returns>The minimized failure, or one with no violations if it did not reproduce.</returns>
+StressFailure CStress::minimize(const StressFailure& failure) const
+{
+    StressFailure whole = failure;
+    StressFailure best;
+    Lane lane;
+
+    whole.irregular = -1;
+    whole.kept.clear();
+    whole = replay(whole, nullptr);
+    if ((whole.violations & failure.violations) == 0)
+        return whole;
+
+    // Every irregular step up to the failure
+    start(lane, failure.seed, m_settings);
+    best = whole;
+    best.irregular = 0;
+    for (int tick = 0; tick <= whole.tick; tick++)
+    {
+        if (lane.deltas[tick] != NOMINAL_DELTA)
+            best.kept.push_back(tick);
+    }
+    best.irregular = static_cast<int>(best.kept.size());
+
+    for (std::size_t chunk = std::max<std::size_t>(best.kept.size() / 2, 1); chunk > 0; chunk /= 2)
+    {
+        for (std::size_t begin = 0; begin < best.kept.size();)
+        {
+            StressFailure candidate = best;
+            std::size_t end = std::min(begin + chunk, candidate.kept.size());
+
+            candidate.kept.erase(candidate.kept.begin() + begin, candidate.kept.begin() + end);
+            candidate = replay(candidate, nullptr);
+            if ((candidate.violations & failure.violations) == 0)
+            {
+                begin += chunk;
+                continue;
+            }
+
+            // Still fails, so keep the smaller set up to its failing tick
+            while (!candidate.kept.empty() && candidate.kept.back() > candidate.tick)
+                candidate.kept.pop_back();
+            best = candidate;
+        }
+    }
+    return best;
+}
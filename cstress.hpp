@@ -0,0 +1,196 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CSTRESS_HPP
+#define WINTEN_CSTRESS_HPP
+
+// Include external header files
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "cregistry.hpp"
+#include "cthreadpool.hpp"
+
+/// <summary>
+///     Physics invariants checked every tick, as bits of a mask.
+/// </summary>
+enum StressViolation : std::uint8_t
+{
+    // The ball is outside the field or not a number
+    VIOLATION_FIELD = 1,
+    // The ball crossed a paddle's centre from in front to behind while
+    // level with it, passing through without a hit
+    VIOLATION_TUNNEL = 2,
+    // The ball stayed against a paddle face instead of leaving it
+    VIOLATION_STUCK = 4
+};
+
+/// <summary>
+///     Settings of a stress run.
+/// </summary>
+struct StressSettings
+{
+    // Matches each thread plays in lockstep per batch
+    int lanes;
+    // Threads including the caller
+    int threads;
+    // Ticks each match lasts
+    int ticks;
+    // Longest time step in seconds drawn by the random step schedules
+    float maxDelta;
+    std::uint64_t seed;
+
+    StressSettings(void)
+        : lanes(64)
+        , threads(1)
+        , ticks(1000)
+        , maxDelta(0.03f)
+        , seed(1) {}
+};
+
+/// <summary>
+///     A failing match reduced to the fewest irregular time steps which still
+///     break the same invariant. Every other step is the nominal tick, and the
+///     kept steps take their values from the seed's schedule, so the seed,
+///     the longest step of the run, the kept ticks and the failing tick
+///     replay it exactly.
+/// </summary>
+struct StressFailure
+{
+    std::uint64_t seed;
+    // Longest random time step of the run in seconds, shaping the schedule
+    float maxDelta;
+    int tick;
+    std::uint8_t violations;
+    // Ticks keeping their scheduled step, or empty to keep every step
+    std::vector<int> kept;
+    // Irregular steps before minimizing, or -1 if not minimized and every
+    // step is as scheduled
+    int irregular;
+
+    StressFailure(void)
+        : seed(0)
+        , maxDelta(0)
+        , tick(0)
+        , violations(0)
+        , kept()
+        , irregular(0) {}
+
+    std::string token(void) const;
+    bool parse(const char* text);
+};
+
+/// <summary>
+///     Counters of a stress run.
+/// </summary>
+struct StressStats
+{
+    std::uint64_t ticks;
+    std::uint64_t matches;
+    std::uint64_t failures;
+    double seconds;
+    int threads;
+
+    StressStats(void)
+        : ticks(0)
+        , matches(0)
+        , failures(0)
+        , seconds(0)
+        , threads(1) {}
+
+    double ticksPerSecond(void) const
+    {
+        return seconds > 0 ? ticks / seconds : 0.0;
+    }
+};
+
+/// <summary>
+///     Plays randomized matches as fast as possible and checks physics
+///     invariants every tick. Each match is one 64-bit seed, giving the ball's
+///     serve and hits, random keys for one paddle against the tracking rule,
+///     and a schedule of time steps from one of several distributions. Each
+///     thread plays a batch of matches in lockstep, gathering the ball and
+///     paddles of every match into arrays so the invariants are checked by
+///     branch-free loops the compiler vectorizes. Failing seeds are replayed
+///     and minimized afterwards on one thread.
+/// </summary>
+class CStress
+{
+private:
+    struct Lane
+    {
+        CRegistry world;
+        Entity ball;
+        Entity paddles[2];
+        std::uint64_t seed;
+        int tick;
+        std::vector<float> deltas;
+        std::vector<std::uint8_t> keys;
+    };
+
+    // Ball and paddles of every lane, structure of arrays
+    struct Batch
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> lastX;
+        std::vector<float> lastY;
+        std::vector<float> delta;
+        std::vector<float> paddleY[2];
+        std::vector<float> contact[2];
+        std::vector<std::uint8_t> touched[2];
+        std::vector<std::uint8_t> violations;
+    };
+
+    struct Worker
+    {
+        std::vector<Lane> lanes;
+        Batch batch;
+        StressStats stats;
+        std::uint64_t next;
+    };
+
+    StressSettings m_settings;
+    std::vector<Worker> m_workers;
+    CThreadPool m_pool;
+    StressStats m_stats;
+    std::mutex m_failureMutex;
+    std::vector<StressFailure> m_failures;
+
+    static void start(Lane& lane, std::uint64_t seed, const StressSettings& settings);
+    static void gather(const Lane& lane, Batch& batch, std::size_t index);
+    static void check(Batch& batch, std::size_t count);
+    void play(int worker);
+
+public:
+    // Paddle x positions, as created by start
+    static const float PADDLE_X[2];
+    // Time against a paddle face after which the ball counts as stuck
+    static const float STUCK_SECONDS;
+
+    explicit CStress(const StressSettings& settings);
+    CStress(const CStress&) = delete;
+    CStress& operator=(const CStress&) = delete;
+    void round(void);
+    StressStats getStats(void) const;
+    std::vector<StressFailure> takeFailures(void);
+    StressFailure minimize(const StressFailure& failure) const;
+    StressFailure replay(const StressFailure& failure, std::vector<CRegistry>* trace) const;
+};
+
+#endif
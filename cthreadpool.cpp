@@ -0,0 +1,126 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "cthreadpool.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="threads">Total threads including the caller of run.</param>
+CThreadPool::CThreadPool(int threads)
+    : m_job(nullptr)
+    , m_count(0)
+    , m_next(0)
+    , m_busy(0)
+    , m_generation(0)
+    , m_stopping(false)
+{
+    for (int index = 1; index < threads; index++)
+        m_workers.emplace_back(&CThreadPool::work, this);
+}
+
+/// <summary>
+///     Class destructor.
+/// </summary>
+CThreadPool::~CThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_started.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+/// <summary>
+///     Number of threads running jobs, including the caller.
+/// </summary>
+int CThreadPool::size(void) const
+{
+    return static_cast<int>(m_workers.size()) + 1;
+}
+
+/// <summary>
+///     Claim and run job indices until none remain.
+/// </summary>
+void CThreadPool::drain(const std::function<void(int)>& job, int count)
+{
+    for (int index = m_next.fetch_add(1); index < count; index = m_next.fetch_add(1))
+        job(index);
+}
+
+/// <summary>
+///     Worker thread body, joining each job as it is published.
+/// </summary>
+void CThreadPool::work(void)
+{
+    std::uint64_t generation = 0;
+
+    for (;;)
+    {
+        const std::function<void(int)>* job;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_started.wait(lock, [&]() { return m_stopping || m_generation != generation; });
+            if (m_stopping)
+                return;
+            generation = m_generation;
+            job = m_job;
+            count = m_count;
+        }
+
+        drain(*job, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0)
+                m_finished.notify_one();
+        }
+    }
+}
+
+/// <summary>
+///     Run a job for every index in [0, count), returning when all are done.
+///     Indices are claimed dynamically so uneven jobs balance across threads.
+/// </summary>
+/// <param name="count">Number of indices.</param>
+/// <param name="job">Called once per index, from any thread.</param>
+void CThreadPool::run(int count, const std::function<void(int)>& job)
+{
+    if (m_workers.empty() || count <= 1)
+    {
+        for (int index = 0; index < count; index++)
+            job(index);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next.store(0);
+        m_busy = static_cast<int>(m_workers.size());
+        m_generation++;
+    }
+    m_started.notify_all();
+
+    drain(job, count);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [&]() { return m_busy == 0; });
+}
@@ -0,0 +1,59 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CTHREADPOOL_HPP
+#define WINTEN_CTHREADPOOL_HPP
+
+// Include external header files
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+///     Persistent pool of worker threads running indexed jobs in parallel.
+///     The calling thread takes part, so a pool of one thread has no workers.
+/// </summary>
+class CThreadPool
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_started;
+    std::condition_variable m_finished;
+    // Current job, published under the mutex with a new generation
+    const std::function<void(int)>* m_job;
+    int m_count;
+    std::atomic<int> m_next;
+    int m_busy;
+    std::uint64_t m_generation;
+    bool m_stopping;
+
+    void work(void);
+    void drain(const std::function<void(int)>& job, int count);
+
+public:
+    explicit CThreadPool(int threads);
+    ~CThreadPool();
+    CThreadPool(const CThreadPool&) = delete;
+    CThreadPool& operator=(const CThreadPool&) = delete;
+    int size(void) const;
+    void run(int count, const std::function<void(int)>& job);
+};
+
+#endif
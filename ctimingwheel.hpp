@@ -0,0 +1,319 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CTIMINGWHEEL_HPP
+#define WINTEN_CTIMINGWHEEL_HPP
+
+// Include external header files
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// <summary>
+///     Handle of a scheduled timer, for cancelling it.
+/// </summary>
+struct TimerHandle
+{
+    std::int32_t index;
+    std::uint32_t generation;
+};
+
+/// <summary>
+///     Hierarchical timing wheel of one-shot timers carrying a value of type
+///     T. Time is counted in slots of 2^SHIFT clock ticks. Each level is a
+///     ring of SLOTS slots, each slot of a level spanning a whole ring of the
+///     level below, and a timer sits in the lowest level whose ring reaches
+///     its deadline. Scheduling and cancelling are O(1). Advancing expires
+///     the current slot of the lowest level and, each time a ring comes
+///     round, moves the next slot of the level above down, so a timer moves
+///     at most once per level. Occupancy bitmaps skip empty slots, so an
+///     idle wheel jumps straight to its next deadline. Deadlines are rounded
+///     up to a slot boundary.
+/// </summary>
+template <typename T>
+class CTimingWheel
+{
+public:
+    static const int SHIFT = 17;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 5;
+
+private:
+    static const std::int32_t NONE = -1;
+    // List of timers already due, after the slots of every level
+    static const int DUE = LEVELS * SLOTS;
+
+    struct Entry
+    {
+        T value;
+        std::int64_t slot;
+        std::int32_t previous;
+        std::int32_t next;
+        std::int32_t list;
+        std::uint32_t generation;
+    };
+
+    std::vector<Entry> m_entries;
+    std::int32_t m_free;
+    std::int32_t m_heads[DUE + 1];
+    std::uint64_t m_occupied[LEVELS];
+    // Last slot processed
+    std::int64_t m_current;
+    std::size_t m_size;
+
+    void link(std::int32_t index, int list)
+    {
+        Entry& entry = m_entries[index];
+        entry.list = list;
+        entry.previous = NONE;
+        entry.next = m_heads[list];
+        if (entry.next != NONE)
+            m_entries[entry.next].previous = index;
+        m_heads[list] = index;
+        if (list < DUE)
+            m_occupied[list / SLOTS] |= 1ull << (list % SLOTS);
+    }
+
+    void unlink(std::int32_t index)
+    {
+        Entry& entry = m_entries[index];
+        if (entry.previous != NONE)
+            m_entries[entry.previous].next = entry.next;
+        else
+            m_heads[entry.list] = entry.next;
+        if (entry.next != NONE)
+            m_entries[entry.next].previous = entry.previous;
+        if (m_heads[entry.list] == NONE && entry.list < DUE)
+            m_occupied[entry.list / SLOTS] &= ~(1ull << (entry.list % SLOTS));
+    }
+
+    // File a timer in the level whose ring reaches its slot
+    void place(std::int32_t index)
+    {
+        std::int64_t slot = m_entries[index].slot;
+        std::int64_t ahead = slot - m_current;
+
+        if (ahead <= 0)
+        {
+            link(index, DUE);
+            return;
+        }
+        int level = 0;
+        while (level < LEVELS - 1 && ahead >= (static_cast<std::int64_t>(1) << (SLOT_BITS * (level + 1))))
+            level++;
+        // Beyond the top ring, wait in its furthest slot and be refiled
+        if (ahead >= (static_cast<std::int64_t>(1) << (SLOT_BITS * LEVELS)))
+            slot = m_current + (static_cast<std::int64_t>(1) << (SLOT_BITS * LEVELS)) - 1;
+        link(index, level * SLOTS + static_cast<int>((slot >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    }
+
+    // First slot after the current one at which a level has work
+    std::int64_t nextSlot(void) const
+    {
+        std::int64_t best = -1;
+
+        for (int level = 0; level < LEVELS; level++)
+        {
+            if (m_occupied[level] == 0)
+                continue;
+            int shift = SLOT_BITS * level;
+            int current = static_cast<int>((m_current >> shift) & (SLOTS - 1));
+            std::int64_t ring = (m_current >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            // Slots after the current one come round in this ring, the rest in the next
+            std::uint64_t later = current == SLOTS - 1 ? 0 : m_occupied[level] & (~0ull << (current + 1));
+            std::uint64_t bits = later != 0 ? later : m_occupied[level];
+            if (later == 0)
+                ring += static_cast<std::int64_t>(1) << (shift + SLOT_BITS);
+            std::int64_t slot = ring + (static_cast<std::int64_t>(lowestBit(bits)) << shift);
+            if (best < 0 || slot < best)
+                best = slot;
+        }
+        return best;
+    }
+
+    static int lowestBit(std::uint64_t bits)
+    {
+        int index = 0;
+        while ((bits & 1) == 0)
+        {
+            bits >>= 1;
+            index++;
+        }
+        return index;
+    }
+
+    // Expire and refile everything a slot holds
+    template <typename F>
+    void drain(int list, F& expired)
+    {
+        std::int32_t index = m_heads[list];
+        m_heads[list] = NONE;
+        if (list < DUE)
+            m_occupied[list / SLOTS] &= ~(1ull << (list % SLOTS));
+
+        while (index != NONE)
+        {
+            std::int32_t next = m_entries[index].next;
+            if (m_entries[index].slot <= m_current)
+            {
+                T value = std::move(m_entries[index].value);
+                release(index);
+                expired(value);
+            }
+            else
+                place(index);
+            index = next;
+        }
+    }
+
+    void release(std::int32_t index)
+    {
+        Entry& entry = m_entries[index];
+        entry.value = T();
+        entry.generation++;
+        entry.list = NONE;
+        entry.next = m_free;
+        m_free = index;
+        m_size--;
+    }
+
+public:
+    /// <summary>
+    ///     Class constructor.
+    /// </summary>
+    /// <param name="now">Current time in clock ticks.</param>
+    explicit CTimingWheel(std::int64_t now = 0)
+        : m_entries()
+        , m_free(NONE)
+        , m_occupied()
+        , m_current(now >> SHIFT)
+        , m_size(0)
+    {
+        for (auto& head : m_heads)
+            head = NONE;
+    }
+
+    /// <summary>
+    ///     Add a timer.
+    /// </summary>
+    /// <param name="deadline">Time to expire at in clock ticks.</param>
+    /// <param name="value">Value handed back on expiry.</param>
+    /// <returns>Handle to cancel the timer with.</returns>
+    TimerHandle schedule(std::int64_t deadline, T value)
+    {
+        std::int32_t index = m_free;
+        if (index != NONE)
+            m_free = m_entries[index].next;
+        else
+        {
+            index = static_cast<std::int32_t>(m_entries.size());
+            m_entries.push_back(Entry());
+            m_entries.back().generation = 0;
+        }
+
+        Entry& entry = m_entries[index];
+        entry.value = std::move(value);
+        entry.slot = (deadline + (static_cast<std::int64_t>(1) << SHIFT) - 1) >> SHIFT;
+        m_size++;
+        place(index);
+        TimerHandle handle = { index, entry.generation };
+        return handle;
+    }
+
+    /// <summary>
+    ///     Remove a timer which has not expired.
+    /// </summary>
+    /// <returns>False if it already expired or was cancelled.</returns>
+    bool cancel(TimerHandle handle)
+    {
+        if (handle.index < 0 || handle.index >= static_cast<std::int32_t>(m_entries.size()))
+            return false;
+        Entry& entry = m_entries[handle.index];
+        if (entry.generation != handle.generation || entry.list == NONE)
+            return false;
+
+        unlink(handle.index);
+        release(handle.index);
+        return true;
+    }
+
+    /// <summary>
+    ///     Expire every timer due by a time, in no particular order.
+    /// </summary>
+    /// <param name="now">Current time in clock ticks.</param>
+    /// <param name="expired">Called with the value of each expired timer.</param>
+    template <typename F>
+    void advance(std::int64_t now, F expired)
+    {
+        std::int64_t target = now >> SHIFT;
+
+        drain(DUE, expired);
+        while (m_size > 0)
+        {
+            std::int64_t slot = nextSlot();
+            if (slot < 0 || slot > target)
+                break;
+
+            // Bring down the slots of the levels whose rings came round
+            m_current = slot;
+            for (int level = LEVELS - 1; level > 0; level--)
+            {
+                if ((slot & ((static_cast<std::int64_t>(1) << (SLOT_BITS * level)) - 1)) == 0)
+                    drain(level * SLOTS + static_cast<int>((slot >> (SLOT_BITS * level)) & (SLOTS - 1)), expired);
+            }
+            drain(static_cast<int>(slot & (SLOTS - 1)), expired);
+            drain(DUE, expired);
+        }
+        if (target > m_current)
+            m_current = target;
+    }
+
+    /// <summary>
+    ///     Get the earliest time at which advancing may do anything.
+    /// </summary>
+    /// <returns>Time in clock ticks, or -1 if the wheel is empty.</returns>
+    std::int64_t nextDeadline(void) const
+    {
+        if (m_size == 0)
+            return -1;
+        if (m_heads[DUE] != NONE)
+            return m_current << SHIFT;
+        return nextSlot() << SHIFT;
+    }
+
+    /// <summary>
+    ///     Number of pending timers.
+    /// </summary>
+    std::size_t size(void) const
+    {
+        return m_size;
+    }
+};
+
+template <typename T>
+const int CTimingWheel<T>::SHIFT;
+template <typename T>
+const int CTimingWheel<T>::SLOT_BITS;
+template <typename T>
+const int CTimingWheel<T>::SLOTS;
+template <typename T>
+const int CTimingWheel<T>::LEVELS;
+template <typename T>
+const std::int32_t CTimingWheel<T>::NONE;
+template <typename T>
+const int CTimingWheel<T>::DUE;
+
+#endif
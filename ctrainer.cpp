@@ -0,0 +1,349 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <chrono>
+
+// Include project header files
+#include "angletable.hpp"
+#include "ctrainer.hpp"
+#include "systems.hpp"
+#include "winten_constants.hpp"
+
+/// <summary>
+///     Class constructor, starting every match and zeroing the value table.
+/// </summary>
+/// <param name="settings">Training settings.</param>
+CTrainer::CTrainer(const TrainerSettings& settings)
+    : m_settings(settings)
+    , m_matches(static_cast<std::size_t>(std::max(settings.matches, 1)))
+    , m_workers(static_cast<std::size_t>(std::max(settings.threads, 1)))
+    , m_values(new std::atomic<float>[CPolicyTabular::STATES * ACTION_COUNT])
+    , m_pool(std::max(settings.threads, 1))
+    , m_stats()
+    , m_snapshotMutex()
+    , m_snapshot(std::make_shared<CPolicyTabular>())
+{
+    Controller keyboard = { CONTROLLER_KEYBOARD, winten_constants::PADDLE_SPEED, 0.0f, false, ACTION_STAY };
+
+    for (int index = 0; index < CPolicyTabular::STATES * ACTION_COUNT; index++)
+        m_values[index].store(0.0f, std::memory_order_relaxed);
+    for (std::size_t index = 0; index < m_matches.size(); index++)
+        reset(m_matches[index], m_settings.seed + index, keyboard);
+    m_stats.threads = m_pool.size();
+}
+
+/// <summary>
+///     Start a match between a learning paddle at the NPC end and the
+///     tracking rule, serving in a random direction.
+/// </summary>
+/// <param name="match">Match to start.</param>
+/// <param name="seed">Seed of the match's random number generator.</param>
+/// <param name="controller">Controller of the learning paddle.</param>
+void CTrainer::reset(Match& match, std::uint64_t seed, const Controller& controller)
+{
+    Controller tracking = {
+        CONTROLLER_TRACKING,
+        winten_constants::PADDLE_SPEED,
+        winten_constants::NPC_HORIZON,
+        false,
+        ACTION_STAY };
+
+    match.world = CRegistry();
+    match.world.seed(seed);
+    Velocity serve = {
+        winten_constants::BALL_SPEED,
+        static_cast<int>(match.world.random() % angle_table::STEPS),
+        (match.world.random() & 1) != 0 };
+
+    match.learner = systems::createPaddle(match.world, winten_constants::PADDLE_X_NPC, &controller);
+    systems::createPaddle(match.world, winten_constants::PADDLE_X_PLAYER, &tracking);
+    match.ball = systems::createBall(match.world, winten_constants::W / 2.0f, winten_constants::H / 2.0f, &serve);
+    match.state = CPolicyTabular::state(systems::observe(match.world, match.learner));
+}
+
+/// <summary>
+///     Hold an action for a number of frames. Returning the ball is rewarded
+///     and missing it penalized.
+/// </summary>
+/// <param name="match">Match to advance.</param>
+/// <param name="action">Keys the learning paddle holds.</param>
+/// <param name="frames">Frames to hold them for.</param>
+/// <param name="stats">Counters to add to.</param>
+/// <param name="reward">Receives the reward.</param>
+/// <param name="terminal">Receives whether the ball was missed.</param>
+void CTrainer::play(Match& match, int action, int frames, TrainerStats& stats, float& reward, bool& terminal)
+{
+    const float delta = 1.0f / winten_constants::FRAME_RATE;
+    systems::Input input = { action == ACTION_UP, action == ACTION_DOWN };
+
+    reward = 0.0f;
+    terminal = false;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // The learner is at the left end, so incoming balls travel left
+        bool incoming = match.world.velocities.get(match.ball).left;
+        int conceded = match.world.score[SIDE_RIGHT];
+
+        systems::step(match.world, input, delta);
+        stats.steps++;
+        if (match.world.score[SIDE_RIGHT] != conceded)
+        {
+            reward -= 1.0f;
+            terminal = true;
+            stats.misses++;
+        }
+        else if (incoming && !match.world.velocities.get(match.ball).left)
+        {
+            reward += 1.0f;
+            stats.hits++;
+        }
+    }
+    stats.decisions++;
+}
+
+/// <summary>
+///     Choose an action for a match's current state, at random with some
+///     probability and otherwise the best by the shared values.
+/// </summary>
+/// <param name="match">Match deciding.</param>
+/// <param name="exploration">Probability of a random action.</param>
+/// <returns>The action.</returns>
+int CTrainer::choose(Match& match, float exploration) const
+{
+    float values[ACTION_COUNT];
+
+    if (match.world.uniform() < exploration)
+        return static_cast<int>(match.world.random() % ACTION_COUNT);
+    for (int action = 0; action < ACTION_COUNT; action++)
+        values[action] = m_values[match.state * ACTION_COUNT + action].load(std::memory_order_relaxed);
+    return CPolicyTabular::best(values);
+}
+
+/// <summary>
+///     Play one worker's share of the matches for a batch of decisions,
+///     recording the experience in its own buffer.
+/// </summary>
+/// <param name="worker">Worker index.</param>
+/// <param name="exploration">Probability of a random action.</param>
+void CTrainer::simulate(int worker, float exploration)
+{
+    Worker& self = m_workers[worker];
+    std::size_t begin = m_matches.size() * worker / m_workers.size();
+    std::size_t end = m_matches.size() * (worker + 1) / m_workers.size();
+
+    self.experience.clear();
+    for (std::size_t index = begin; index < end; index++)
+    {
+        Match& match = m_matches[index];
+
+        for (int decision = 0; decision < m_settings.batch; decision++)
+        {
+            Transition transition;
+
+            transition.state = match.state;
+            transition.action = choose(match, exploration);
+            play(match, transition.action, m_settings.actionRepeat, self.stats, transition.reward, transition.terminal);
+            transition.next = CPolicyTabular::state(systems::observe(match.world, match.learner));
+            self.experience.push_back(transition);
+            match.state = transition.next;
+        }
+    }
+}
+
+/// <summary>
+///     Fold a worker's experience into the shared values by Q-learning. Each
+///     update is an atomic compare-and-swap, so workers learn concurrently
+///     without locks and no update is lost.
+/// </summary>
+/// <param name="worker">Worker index.</param>
+void CTrainer::learn(int worker)
+{
+    for (const Transition& transition : m_workers[worker].experience)
+    {
+        float target = transition.reward;
+        if (!transition.terminal)
+        {
+            float best = m_values[transition.next * ACTION_COUNT].load(std::memory_order_relaxed);
+            for (int action = 1; action < ACTION_COUNT; action++)
+                best = std::max(best, m_values[transition.next * ACTION_COUNT + action].load(std::memory_order_relaxed));
+            target += m_settings.discount * best;
+        }
+
+        std::atomic<float>& value = m_values[transition.state * ACTION_COUNT + transition.action];
+        float current = value.load(std::memory_order_relaxed);
+        while (!value.compare_exchange_weak(
+            current,
+            current + m_settings.learningRate * (target - current),
+            std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+/// <summary>
+///     Run one round: every match makes a batch of decisions and the
+///     experience is learned, in parallel across the threads.
+/// </summary>
+/// <param name="exploration">Probability of a random action.</param>
+void CTrainer::round(float exploration)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_pool.run(static_cast<int>(m_workers.size()), [this, exploration](int worker) {
+        simulate(worker, exploration);
+        learn(worker);
+    });
+
+    for (Worker& worker : m_workers)
+    {
+        m_stats.steps += worker.stats.steps;
+        m_stats.decisions += worker.stats.decisions;
+        m_stats.hits += worker.stats.hits;
+        m_stats.misses += worker.stats.misses;
+        worker.stats = TrainerStats();
+    }
+    m_stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// <summary>
+///     Take a greedy policy from the current values and publish it as the
+///     latest snapshot. Call between rounds.
+/// </summary>
+/// <returns>The snapshot.</returns>
+std::shared_ptr<const CPolicyTabular> CTrainer::snapshot(void)
+{
+    std::vector<float> values(static_cast<std::size_t>(CPolicyTabular::STATES * ACTION_COUNT));
+
+    for (std::size_t index = 0; index < values.size(); index++)
+        values[index] = m_values[index].load(std::memory_order_relaxed);
+
+    std::shared_ptr<const CPolicyTabular> result = std::make_shared<CPolicyTabular>(values);
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_snapshot = result;
+    return result;
+}
+
+/// <summary>
+///     Get the most recent snapshot, from any thread.
+/// </summary>
+/// <returns>The snapshot, which always stays before the first is taken.</returns>
+std::shared_ptr<const CPolicyTabular> CTrainer::latest(void) const
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return m_snapshot;
+}
+
+/// <summary>
+///     Get the training counters.
+/// </summary>
+/// <returns>The counters.</returns>
+TrainerStats CTrainer::getStats(void) const
+{
+    return m_stats;
+}
+
+/// <summary>
+///     Play fresh matches with a policy paddle, or the tracking rule in its
+///     place, against the tracking rule, optionally sampling what it observes.
+/// </summary>
+/// <param name="policy">Policy to play, or nullptr for the tracking rule.</param>
+/// <param name="matches">Number of matches.</param>
+/// <param name="frames">Frames each match lasts.</param>
+/// <param name="interval">Frames between observation samples.</param>
+/// <param name="samples">Receives the observations, or nullptr to sample none.</param>
+/// <returns>The counters.</returns>
+TrainerStats CTrainer::playout(std::shared_ptr<const IPolicy> policy, int matches, int frames, int interval, std::vector<Observation>* samples)
+{
+    Controller controller = {
+        policy ? CONTROLLER_POLICY : CONTROLLER_TRACKING,
+        winten_constants::PADDLE_SPEED,
+        winten_constants::NPC_HORIZON,
+        false,
+        ACTION_STAY };
+    std::vector<Match> games(static_cast<std::size_t>(std::max(matches, 1)));
+    std::vector<TrainerStats> stats(m_workers.size());
+    std::vector<std::vector<Observation>> observed(m_workers.size());
+    TrainerStats result;
+    auto start = std::chrono::steady_clock::now();
+
+    interval = std::max(interval, 1);
+    m_pool.run(static_cast<int>(m_workers.size()), [&](int worker) {
+        std::size_t begin = games.size() * worker / m_workers.size();
+        std::size_t end = games.size() * (worker + 1) / m_workers.size();
+        float reward;
+        bool terminal;
+
+        for (std::size_t index = begin; index < end; index++)
+        {
+            // Seeds apart from the training matches
+            reset(games[index], ~(m_settings.seed + index), controller);
+            games[index].world.policy = policy;
+            if (!samples)
+            {
+                play(games[index], ACTION_STAY, frames, stats[worker], reward, terminal);
+                continue;
+            }
+            for (int frame = 0; frame < frames; frame += interval)
+            {
+                observed[worker].push_back(systems::observe(games[index].world, games[index].learner));
+                play(games[index], ACTION_STAY, std::min(interval, frames - frame), stats[worker], reward, terminal);
+            }
+        }
+    });
+
+    for (std::size_t worker = 0; worker < stats.size(); worker++)
+    {
+        result.steps += stats[worker].steps;
+        result.hits += stats[worker].hits;
+        result.misses += stats[worker].misses;
+        if (samples)
+            samples->insert(samples->end(), observed[worker].begin(), observed[worker].end());
+    }
+    result.threads = m_pool.size();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/// <summary>
+///     Play fresh matches with a policy paddle, or the tracking rule in its
+///     place, against the tracking rule, and count how often it returns the ball.
+/// </summary>
+/// <param name="policy">Policy to evaluate, or nullptr for the tracking rule.</param>
+/// <param name="matches">Number of matches.</param>
+/// <param name="frames">Frames each match lasts.</param>
+/// <returns>The counters.</returns>
+TrainerStats CTrainer::evaluate(std::shared_ptr<const IPolicy> policy, int matches, int frames)
+{
+    return playout(policy, matches, frames, frames, nullptr);
+}
+
+/// <summary>
+///     Gather the situations a policy paddle meets in play, as training data
+///     for another policy imitating it.
+/// </summary>
+/// <param name="policy">Policy to play.</param>
+/// <param name="matches">Number of matches.</param>
+/// <param name="frames">Frames each match lasts.</param>
+/// <param name="interval">Frames between samples.</param>
+/// <returns>The observations in match order.</returns>
+std::vector<Observation> CTrainer::collect(std::shared_ptr<const IPolicy> policy, int matches, int frames, int interval)
+{
+    std::vector<Observation> samples;
+
+    playout(policy, matches, frames, interval, &samples);
+    return samples;
+}
@@ -0,0 +1,165 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CTRAINER_HPP
+#define WINTEN_CTRAINER_HPP
+
+// Include external header files
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Include project header files
+#include "cpolicytabular.hpp"
+#include "cregistry.hpp"
+#include "cthreadpool.hpp"
+
+/// <summary>
+///     Settings of a training run.
+/// </summary>
+struct TrainerSettings
+{
+    // Matches simulated side by side, split evenly between the threads
+    int matches;
+    // Threads including the caller
+    int threads;
+    // Decisions each match makes per round before its experience is learned
+    int batch;
+    // Frames each decision is held for
+    int actionRepeat;
+    float learningRate;
+    float discount;
+    std::uint64_t seed;
+
+    TrainerSettings(void)
+        : matches(256)
+        , threads(1)
+        , batch(32)
+        , actionRepeat(4)
+        , learningRate(0.1f)
+        , discount(0.97f)
+        , seed(1) {}
+};
+
+/// <summary>
+///     Training or evaluation counters of the learning paddles.
+/// </summary>
+struct TrainerStats
+{
+    // Environment steps, one per frame of one match
+    std::uint64_t steps;
+    std::uint64_t decisions;
+    // Balls returned and missed
+    std::uint64_t hits;
+    std::uint64_t misses;
+    // Wall time simulating and learning
+    double seconds;
+    int threads;
+
+    TrainerStats(void)
+        : steps(0)
+        , decisions(0)
+        , hits(0)
+        , misses(0)
+        , seconds(0)
+        , threads(1) {}
+
+    double stepsPerSecond(void) const
+    {
+        return seconds > 0 ? steps / seconds : 0.0;
+    }
+
+    double stepsPerSecondPerCore(void) const
+    {
+        return stepsPerSecond() / threads;
+    }
+
+    /// <summary>
+    ///     Fraction of balls reaching the paddle which were returned.
+    /// </summary>
+    double hitRate(void) const
+    {
+        return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0;
+    }
+};
+
+/// <summary>
+///     Learns a paddle policy by tabular Q-learning over many matches at once.
+///     Each match has a learning paddle at the NPC's end against the tracking
+///     rule. Each round, every thread plays its share of the matches with an
+///     epsilon-greedy policy into its own experience buffer, then folds that
+///     experience into the shared value table with atomic compare-and-swap,
+///     taking no locks while other threads still read it. Snapshots of the
+///     table are greedy CPolicyTabular policies which can drive any paddle.
+/// </summary>
+class CTrainer
+{
+private:
+    struct Transition
+    {
+        int state;
+        int action;
+        float reward;
+        int next;
+        // The ball was missed, so the next state's value is not counted
+        bool terminal;
+    };
+
+    struct Match
+    {
+        CRegistry world;
+        Entity learner;
+        Entity ball;
+        int state;
+    };
+
+    struct Worker
+    {
+        std::vector<Transition> experience;
+        TrainerStats stats;
+    };
+
+    TrainerSettings m_settings;
+    std::vector<Match> m_matches;
+    std::vector<Worker> m_workers;
+    // Shared action values, ACTION_COUNT per state
+    std::unique_ptr<std::atomic<float>[]> m_values;
+    CThreadPool m_pool;
+    TrainerStats m_stats;
+    mutable std::mutex m_snapshotMutex;
+    std::shared_ptr<const CPolicyTabular> m_snapshot;
+
+    static void reset(Match& match, std::uint64_t seed, const Controller& controller);
+    static void play(Match& match, int action, int frames, TrainerStats& stats, float& reward, bool& terminal);
+    int choose(Match& match, float exploration) const;
+    void simulate(int worker, float exploration);
+    void learn(int worker);
+    TrainerStats playout(std::shared_ptr<const IPolicy> policy, int matches, int frames, int interval, std::vector<Observation>* samples);
+
+public:
+    explicit CTrainer(const TrainerSettings& settings);
+    CTrainer(const CTrainer&) = delete;
+    CTrainer& operator=(const CTrainer&) = delete;
+    void round(float exploration);
+    std::shared_ptr<const CPolicyTabular> snapshot(void);
+    std::shared_ptr<const CPolicyTabular> latest(void) const;
+    TrainerStats getStats(void) const;
+    TrainerStats evaluate(std::shared_ptr<const IPolicy> policy, int matches, int frames);
+    std::vector<Observation> collect(std::shared_ptr<const IPolicy> policy, int matches, int frames, int interval);
+};
+
+#endif
@@ -0,0 +1,483 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <cmath>
+#include <cstring>
+
+// Include project header files
+#include "ctrajectory.hpp"
+
+#if WINTEN_RASTER_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const char MAGIC[4] = { 'W', 'T', 'J', '1' };
+    const std::int32_t ONE = 1 << trajectory::VELOCITY_BITS;
+    const std::int32_t HALF = ONE / 2;
+    // Bounds keeping base + step * k within 32 bits over a padded block
+    const std::int32_t MAX_UNITS = 1 << 17;
+    const std::int32_t MAX_VELOCITY = 1 << 19;
+    // Per run fields: length - 1, start residual and velocity symbol
+    const int FIELDS = 3;
+    const int SELECTOR_BITS = 2;
+
+    void expandScalar(float* out, int count, std::int32_t base, std::int32_t step, float scale)
+    {
+        for (int index = 0; index < count; index++)
+        {
+            out[index] = static_cast<float>(base >> trajectory::VELOCITY_BITS) * scale;
+            base += step;
+        }
+    }
+
+#if WINTEN_RASTER_X86
+    WINTEN_TARGET_SSE2 void expandSSE2(float* out, int count, std::int32_t base, std::int32_t step, float scale)
+    {
+        const __m128 scaleV = _mm_set1_ps(scale);
+        const __m128i stride = _mm_set1_epi32(step * 4);
+        // Lanes step by addition only, SSE2 having no 32-bit multiply
+        __m128i position = _mm_add_epi32(
+            _mm_set1_epi32(base),
+            _mm_setr_epi32(0, step, step * 2, step * 3));
+
+        for (int index = 0; index < count; index += 4)
+        {
+            __m128i units = _mm_srai_epi32(position, trajectory::VELOCITY_BITS);
+            _mm_storeu_ps(out + index, _mm_mul_ps(_mm_cvtepi32_ps(units), scaleV));
+            position = _mm_add_epi32(position, stride);
+        }
+    }
+
+    WINTEN_TARGET_AVX2 void expandAVX2(float* out, int count, std::int32_t base, std::int32_t step, float scale)
+    {
+        const __m256 scaleV = _mm256_set1_ps(scale);
+        const __m256i stride = _mm256_set1_epi32(step * 8);
+        __m256i position = _mm256_add_epi32(
+            _mm256_set1_epi32(base),
+            _mm256_mullo_epi32(_mm256_set1_epi32(step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+
+        for (int index = 0; index < count; index += 8)
+        {
+            __m256i units = _mm256_srai_epi32(position, trajectory::VELOCITY_BITS);
+            _mm256_storeu_ps(out + index, _mm256_mul_ps(_mm256_cvtepi32_ps(units), scaleV));
+            position = _mm256_add_epi32(position, stride);
+        }
+    }
+#endif
+
+    std::uint32_t zigzag(std::int32_t value)
+    {
+        return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+    std::int32_t unzigzag(std::uint32_t value)
+    {
+        return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+    }
+
+    // Floor division for a positive divisor
+    std::int64_t floorDivide(std::int64_t numerator, std::int64_t divisor)
+    {
+        std::int64_t quotient = numerator / divisor;
+        return quotient * divisor > numerator ? quotient - 1 : quotient;
+    }
+
+    void putVarint(std::vector<std::uint8_t>& output, std::uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    bool getVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint32_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35 && data < end; shift += 7)
+        {
+            std::uint8_t byte = *data++;
+            value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    /// <summary>
+    ///     Append values bit-packed least significant first, preceded by their
+    ///     width. The width is chosen for the smallest output, so a few large
+    ///     values do not widen the rest: their high bits follow as exceptions,
+    ///     each the varint distance from the previous one and the varint bits.
+    /// </summary>
+    void putPacked(std::vector<std::uint8_t>& output, const std::vector<std::uint32_t>& values)
+    {
+        std::size_t lengths[33] = {};
+        std::uint64_t bits = 0;
+        int used = 0;
+        int width = 0;
+        std::size_t best = ~static_cast<std::size_t>(0);
+
+        for (std::uint32_t value : values)
+        {
+            int length = 0;
+            while (length < 32 && (value >> length) != 0)
+                length++;
+            lengths[length]++;
+        }
+        for (int candidate = 0; candidate <= 32; candidate++)
+        {
+            std::size_t size = values.size() * candidate;
+            for (int length = candidate + 1; length <= 32; length++)
+                size += lengths[length] * (8 + 8 * ((length - candidate + 6) / 7));
+            if (size < best)
+            {
+                best = size;
+                width = candidate;
+            }
+        }
+        output.push_back(static_cast<std::uint8_t>(width));
+
+        std::uint32_t mask = width == 32 ? 0xFFFFFFFFu : (1u << width) - 1;
+        std::uint32_t exceptions = 0;
+        for (std::uint32_t value : values)
+        {
+            exceptions += (value & ~mask) != 0 ? 1 : 0;
+            bits |= static_cast<std::uint64_t>(value & mask) << used;
+            used += width;
+            while (used >= 8)
+            {
+                output.push_back(static_cast<std::uint8_t>(bits));
+                bits >>= 8;
+                used -= 8;
+            }
+        }
+        if (used > 0)
+            output.push_back(static_cast<std::uint8_t>(bits));
+
+        putVarint(output, exceptions);
+        std::size_t previous = 0;
+        for (std::size_t index = 0; index < values.size(); index++)
+        {
+            if ((values[index] & ~mask) != 0)
+            {
+                putVarint(output, static_cast<std::uint32_t>(index - previous));
+                putVarint(output, values[index] >> width);
+                previous = index;
+            }
+        }
+    }
+
+    bool getPacked(const std::uint8_t*& data, const std::uint8_t* end, std::uint32_t count, std::vector<std::uint32_t>& values)
+    {
+        if (data >= end || *data > 32)
+            return false;
+        int width = *data++;
+        std::size_t bytes = (static_cast<std::size_t>(count) * width + 7) / 8;
+        std::uint64_t bits = 0;
+        int available = 0;
+        std::uint32_t mask = width == 32 ? 0xFFFFFFFFu : (1u << width) - 1;
+        std::uint32_t exceptions;
+
+        if (static_cast<std::size_t>(end - data) < bytes)
+            return false;
+        values.resize(count);
+        for (std::uint32_t index = 0; index < count; index++)
+        {
+            while (available < width)
+            {
+                bits |= static_cast<std::uint64_t>(*data++) << available;
+                available += 8;
+            }
+            values[index] = static_cast<std::uint32_t>(bits) & mask;
+            bits >>= width;
+            available -= width;
+        }
+
+        if (!getVarint(data, end, exceptions) || exceptions > count)
+            return false;
+        std::uint32_t index = 0;
+        for (std::uint32_t exception = 0; exception < exceptions; exception++)
+        {
+            std::uint32_t distance;
+            std::uint32_t high;
+            if (!getVarint(data, end, distance)
+                || !getVarint(data, end, high)
+                || distance >= count - index
+                || width >= 32)
+                return false;
+            index += distance;
+            values[index] |= high << width;
+        }
+        return true;
+    }
+
+    // Candidate velocities a run's velocity is coded against, by selector
+    std::int32_t candidate(const TrajectoryPredictor& predictor, std::uint32_t selector)
+    {
+        std::int32_t velocity = predictor.velocities[selector >> 1];
+        return (selector & 1) != 0 ? -velocity : velocity;
+    }
+}
+
+namespace trajectory_kernels {
+    const TrajectoryKernels SCALAR = { "scalar", expandScalar };
+#if WINTEN_RASTER_X86
+    const TrajectoryKernels SSE2 = { "sse2", expandSSE2 };
+    const TrajectoryKernels AVX2 = { "avx2", expandAVX2 };
+#endif
+
+    /// <summary>
+    ///     Get every variant the processor supports.
+    /// </summary>
+    /// <returns>Variants ordered slowest first.</returns>
+    std::vector<const TrajectoryKernels*> supported(void)
+    {
+        std::vector<const TrajectoryKernels*> variants;
+
+        variants.push_back(&SCALAR);
+#if WINTEN_RASTER_X86
+        if (raster_kernels::cpuSupportsSSE2())
+            variants.push_back(&SSE2);
+        if (raster_kernels::cpuSupportsAVX2())
+            variants.push_back(&AVX2);
+#endif
+        return variants;
+    }
+}
+
+/// <summary>
+///     Class constructor, writing the stream header.
+/// </summary>
+/// <param name="output">Buffer the encoded stream is appended to.</param>
+CTrajectoryEncoder::CTrajectoryEncoder(std::vector<std::uint8_t>& output)
+    : m_output(output)
+    , m_predictors()
+    , m_ticks(0)
+{
+    m_output.insert(m_output.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    for (auto& block : m_block)
+        block.reserve(trajectory::BLOCK_TICKS);
+}
+
+/// <summary>
+///     Add one tick, encoding a block when it fills.
+/// </summary>
+/// <param name="values">Coordinates in pixels, indexed by TrajectoryChannel.</param>
+void CTrajectoryEncoder::add(const float values[TRAJECTORY_CHANNELS])
+{
+    for (int channel = 0; channel < TRAJECTORY_CHANNELS; channel++)
+    {
+        float units = std::floor(values[channel] * trajectory::UNITS_PER_PIXEL + 0.5f);
+        units = units < -MAX_UNITS ? -MAX_UNITS : (units > MAX_UNITS ? MAX_UNITS : units);
+        m_block[channel].push_back(static_cast<std::int32_t>(units));
+    }
+    m_ticks++;
+    if (m_block[0].size() == static_cast<std::size_t>(trajectory::BLOCK_TICKS))
+        flush();
+}
+
+/// <summary>
+///     Encode the final partial block. Ticks added afterwards start a new one.
+/// </summary>
+void CTrajectoryEncoder::finish(void)
+{
+    if (!m_block[0].empty())
+        flush();
+}
+
+/// <summary>
+///     Get the number of ticks added.
+/// </summary>
+/// <returns>The tick count.</returns>
+std::uint64_t CTrajectoryEncoder::ticks(void) const
+{
+    return m_ticks;
+}
+
+/// <summary>
+///     Encode the buffered ticks as one block.
+/// </summary>
+void CTrajectoryEncoder::flush(void)
+{
+    putVarint(m_output, static_cast<std::uint32_t>(m_block[0].size()));
+    for (int channel = 0; channel < TRAJECTORY_CHANNELS; channel++)
+    {
+        encodeChannel(channel);
+        m_block[channel].clear();
+    }
+}
+
+/// <summary>
+///     Cut one channel of the block into runs and write their fields.
+/// </summary>
+/// <param name="channel">Channel index.</param>
+void CTrajectoryEncoder::encodeChannel(int channel)
+{
+    const std::vector<std::int32_t>& units = m_block[channel];
+    const int count = static_cast<int>(units.size());
+    TrajectoryPredictor& predictor = m_predictors[channel];
+    std::vector<std::uint32_t> fields[FIELDS];
+
+    for (int start = 0; start < count;)
+    {
+        std::int64_t base = static_cast<std::int64_t>(units[start]) * ONE;
+        std::int64_t low = -MAX_VELOCITY;
+        std::int64_t high = MAX_VELOCITY;
+        int end = start + 1;
+
+        // Grow the run while some velocity still reproduces every tick of it
+        for (; end < count; end++)
+        {
+            std::int64_t step = end - start;
+            std::int64_t target = static_cast<std::int64_t>(units[end]) * ONE;
+            std::int64_t from = -floorDivide(base + HALF - target, step);
+            std::int64_t to = floorDivide(target + ONE - 1 - base - HALF, step);
+
+            from = from > low ? from : low;
+            to = to < high ? to : high;
+            if (from > to)
+                break;
+            low = from;
+            high = to;
+        }
+
+        // Of the velocities allowed, take the cheapest to code
+        std::uint32_t symbol = 0xFFFFFFFFu;
+        std::int32_t velocity = 0;
+        for (std::uint32_t selector = 0; selector < (1u << SELECTOR_BITS); selector++)
+        {
+            std::int32_t predicted = candidate(predictor, selector);
+            std::int32_t chosen = static_cast<std::int32_t>(predicted < low ? low : (predicted > high ? high : predicted));
+            std::uint32_t coded = zigzag(chosen - predicted) << SELECTOR_BITS | selector;
+            if (coded < symbol)
+            {
+                symbol = coded;
+                velocity = chosen;
+            }
+        }
+
+        int length = end - start;
+        fields[0].push_back(static_cast<std::uint32_t>(length - 1));
+        fields[1].push_back(zigzag(units[start] - predictor.next));
+        fields[2].push_back(symbol);
+
+        predictor.next = (units[start] * ONE + HALF + velocity * length) >> trajectory::VELOCITY_BITS;
+        predictor.velocities[1] = predictor.velocities[0];
+        predictor.velocities[0] = velocity;
+        start = end;
+    }
+
+    putVarint(m_output, static_cast<std::uint32_t>(fields[0].size()));
+    for (const auto& field : fields)
+        putPacked(m_output, field);
+}
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="data">Encoded stream, which must outlive the decoder.</param>
+/// <param name="size">Size of the stream in bytes.</param>
+/// <param name="kernels">Kernels reconstructing the runs.</param>
+CTrajectoryDecoder::CTrajectoryDecoder(const std::uint8_t* data, std::size_t size, const TrajectoryKernels* kernels)
+    : m_data(data)
+    , m_end(data + size)
+    , m_kernels(kernels)
+    , m_predictors()
+{
+    // A stream without the header decodes as empty
+    if (size < sizeof(MAGIC) || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        m_data = m_end;
+    else
+        m_data += sizeof(MAGIC);
+}
+
+/// <summary>
+///     Decode the next block.
+/// </summary>
+/// <param name="block">Receives the block.</param>
+/// <returns>False at the end of the stream or if it is corrupt.</returns>
+bool CTrajectoryDecoder::next(TrajectoryBlock& block)
+{
+    std::uint32_t ticks;
+
+    if (m_data >= m_end
+        || !getVarint(m_data, m_end, ticks)
+        || ticks == 0
+        || ticks > static_cast<std::uint32_t>(trajectory::BLOCK_TICKS))
+    {
+        m_data = m_end;
+        return false;
+    }
+    block.ticks = static_cast<int>(ticks);
+    for (int channel = 0; channel < TRAJECTORY_CHANNELS; channel++)
+    {
+        if (!decodeChannel(channel, block.ticks, block.values[channel]))
+        {
+            m_data = m_end;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// <summary>
+///     Read one channel of a block and reconstruct its runs.
+/// </summary>
+/// <param name="channel">Channel index.</param>
+/// <param name="ticks">Ticks in the block.</param>
+/// <param name="out">Receives the coordinates in pixels.</param>
+/// <returns>False if the channel is corrupt.</returns>
+bool CTrajectoryDecoder::decodeChannel(int channel, int ticks, float* out)
+{
+    const float scale = 1.0f / trajectory::UNITS_PER_PIXEL;
+    TrajectoryPredictor& predictor = m_predictors[channel];
+    std::uint32_t runs;
+    int position = 0;
+
+    if (!getVarint(m_data, m_end, runs) || runs == 0 || runs > static_cast<std::uint32_t>(ticks))
+        return false;
+    for (auto& field : m_fields)
+    {
+        if (!getPacked(m_data, m_end, runs, field))
+            return false;
+    }
+
+    for (std::uint32_t run = 0; run < runs; run++)
+    {
+        std::uint32_t length = m_fields[0][run] + 1;
+        std::int32_t start = predictor.next + unzigzag(m_fields[1][run]);
+        std::uint32_t symbol = m_fields[2][run];
+        std::int32_t velocity = candidate(predictor, symbol & ((1u << SELECTOR_BITS) - 1)) + unzigzag(symbol >> SELECTOR_BITS);
+
+        if (length > static_cast<std::uint32_t>(ticks - position)
+            || start < -MAX_UNITS || start > MAX_UNITS
+            || velocity < -MAX_VELOCITY || velocity > MAX_VELOCITY)
+            return false;
+
+        std::int32_t base = start * ONE + HALF;
+        m_kernels->expand(out + position, static_cast<int>(length), base, velocity, scale);
+        position += static_cast<int>(length);
+
+        predictor.next = (base + velocity * static_cast<std::int32_t>(length)) >> trajectory::VELOCITY_BITS;
+        predictor.velocities[1] = predictor.velocities[0];
+        predictor.velocities[0] = velocity;
+    }
+    return position == ticks;
+}
@@ -0,0 +1,147 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CTRAJECTORY_HPP
+#define WINTEN_CTRAJECTORY_HPP
+
+// Include external header files
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Include project header files
+#include "rasterkernels.hpp"
+
+/// <summary>
+///     Coordinates recorded each tick. The paddles only move vertically.
+/// </summary>
+enum TrajectoryChannel
+{
+    TRAJECTORY_BALL_X,
+    TRAJECTORY_BALL_Y,
+    TRAJECTORY_NPC_Y,
+    TRAJECTORY_PLAYER_Y,
+    TRAJECTORY_CHANNELS
+};
+
+/// <summary>
+///     Kernels reconstructing a run of positions moving linearly in fixed
+///     point: out[k] = ((base + step * k) >> VELOCITY_BITS) * scale. Each
+///     may write up to seven values past the run, which the decoder pads for.
+/// </summary>
+struct TrajectoryKernels
+{
+    const char* name;
+
+    void (*expand)(float* out, int count, std::int32_t base, std::int32_t step, float scale);
+};
+
+namespace trajectory_kernels {
+    extern const TrajectoryKernels SCALAR;
+#if WINTEN_RASTER_X86
+    extern const TrajectoryKernels SSE2;
+    extern const TrajectoryKernels AVX2;
+#endif
+
+    // All variants this CPU supports, slowest first
+    std::vector<const TrajectoryKernels*> supported(void);
+}
+
+/// <summary>
+///     Lossy trajectory codec shared settings. Coordinates are quantized to
+///     UNITS_PER_PIXEL units and each channel is cut into the longest runs
+///     which a straight line in fixed point reproduces exactly, so a run
+///     between bounces or paddle moves costs its length, its start's
+///     difference from the previous run carried on, and its velocity's
+///     difference from one of the last two velocities or their negation.
+///     Those fields are bit-packed per block of BLOCK_TICKS ticks, with the
+///     rare values too wide for the packing patched in after.
+/// </summary>
+namespace trajectory {
+    const int BLOCK_TICKS = 1024;
+    const int UNITS_PER_PIXEL = 8;
+    // Fractional bits of run velocities
+    const int VELOCITY_BITS = 12;
+    // Decoded blocks have room for a kernel to write past the last run
+    const int BLOCK_PADDING = 8;
+}
+
+/// <summary>
+///     Prediction state of one channel, kept alike by encoder and decoder.
+/// </summary>
+struct TrajectoryPredictor
+{
+    // Where the last run would have continued to
+    std::int32_t next;
+    // Last two run velocities
+    std::int32_t velocities[2];
+
+    TrajectoryPredictor(void)
+        : next(0)
+        , velocities() {}
+};
+
+/// <summary>
+///     Encodes a stream of ticks, a block at a time, appending to a buffer.
+/// </summary>
+class CTrajectoryEncoder
+{
+private:
+    std::vector<std::uint8_t>& m_output;
+    std::vector<std::int32_t> m_block[TRAJECTORY_CHANNELS];
+    TrajectoryPredictor m_predictors[TRAJECTORY_CHANNELS];
+    std::uint64_t m_ticks;
+
+    void flush(void);
+    void encodeChannel(int channel);
+
+public:
+    explicit CTrajectoryEncoder(std::vector<std::uint8_t>& output);
+    CTrajectoryEncoder(const CTrajectoryEncoder&) = delete;
+    CTrajectoryEncoder& operator=(const CTrajectoryEncoder&) = delete;
+    void add(const float values[TRAJECTORY_CHANNELS]);
+    void finish(void);
+    std::uint64_t ticks(void) const;
+};
+
+/// <summary>
+///     Up to BLOCK_TICKS decoded ticks, one array per channel.
+/// </summary>
+struct TrajectoryBlock
+{
+    int ticks;
+    float values[TRAJECTORY_CHANNELS][trajectory::BLOCK_TICKS + trajectory::BLOCK_PADDING];
+};
+
+/// <summary>
+///     Decodes an encoded stream a block at a time.
+/// </summary>
+class CTrajectoryDecoder
+{
+private:
+    const std::uint8_t* m_data;
+    const std::uint8_t* m_end;
+    const TrajectoryKernels* m_kernels;
+    TrajectoryPredictor m_predictors[TRAJECTORY_CHANNELS];
+    std::vector<std::uint32_t> m_fields[3];
+
+    bool decodeChannel(int channel, int ticks, float* out);
+
+public:
+    CTrajectoryDecoder(const std::uint8_t* data, std::size_t size, const TrajectoryKernels* kernels);
+    bool next(TrajectoryBlock& block);
+};
+
+#endif
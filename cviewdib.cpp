@@ -0,0 +1,140 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "cviewdib.hpp"
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="hWnd">Handle of window to draw to.</param>
+CViewDIB::CViewDIB(HWND hWnd)
+    : m_hWnd(hWnd)
+    , m_bitmapInfo()
+    , m_viewportXOffset(0)
+    , m_viewportYOffset(0)
+    , m_needErase(true)
+{
+}
+
+/// <summary>
+///     Initialize the view.
+/// </summary>
+/// <param name="newXOffset">X offset of viewport in window.</param>
+/// <param name="newYOffset">Y offset of viewport in window.</param>
+/// <param name="newWidth">Width of viewport in window.</param>
+/// <param name="newHeight">Height of viewport in window.</param>
+void CViewDIB::initialize(int newXOffset, int newYOffset, int newWidth, int newHeight)
+{
+    std::lock_guard<std::mutex> lock(m_presentMutex);
+
+    CViewFramebuffer::initialize(newXOffset, newYOffset, newWidth, newHeight);
+    m_viewportXOffset = newXOffset;
+    m_viewportYOffset = newYOffset;
+    m_needErase = true;
+
+    // Top-down 32-bit bitmap matching the framebuffer layout, sized per frame
+    m_bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    m_bitmapInfo.bmiHeader.biPlanes = 1;
+    m_bitmapInfo.bmiHeader.biBitCount = 32;
+    m_bitmapInfo.bmiHeader.biCompression = BI_RGB;
+}
+
+/// <summary>
+///     Shutdown the view.
+/// </summary>
+void CViewDIB::shutdown(void)
+{
+    std::lock_guard<std::mutex> lock(m_presentMutex);
+
+    CViewFramebuffer::shutdown();
+}
+
+/// <summary>
+///     The window stretches half resolution frames when they are presented.
+/// </summary>
+/// <returns>True.</returns>
+bool CViewDIB::presentsScaled(void) const
+{
+    return true;
+}
+
+/// <summary>
+///     Draws all objects into the framebuffer and copies it to the window.
+/// </summary>
+/// <param name="list">Frame commands to draw.</param>
+/// <returns>Whether the frame was presented or skipped while resizing.</returns>
+DrawResult CViewDIB::DrawAll(const CRenderList& list)
+{
+    HDC hdc;
+
+    // Skip the frame while the window is being resized
+    std::unique_lock<std::mutex> lock(m_presentMutex, std::try_to_lock);
+    if (!lock.owns_lock() || width() <= 0 || height() <= 0)
+        return DRAW_SKIPPED;
+
+    if (CViewFramebuffer::DrawAll(list) == DRAW_SKIPPED)
+        return DRAW_SKIPPED;
+
+    hdc = GetDC(m_hWnd);
+
+    // Clear the letterbox margins after a resize
+    if (m_needErase)
+    {
+        RECT rc;
+        HBRUSH brushErase = CreateSolidBrush(RGB(0, 0, 0));
+
+        GetClientRect(m_hWnd, &rc);
+        FillRect(hdc, &rc, brushErase);
+        DeleteObject(brushErase);
+        m_needErase = false;
+    }
+
+    // Present the frame as drawn, stretching a half resolution frame
+    m_bitmapInfo.bmiHeader.biWidth = frameWidth();
+    m_bitmapInfo.bmiHeader.biHeight = -frameHeight();
+    if (frameWidth() != width() || frameHeight() != height())
+        StretchDIBits(
+            hdc,
+            m_viewportXOffset,
+            m_viewportYOffset,
+            width(),
+            height(),
+            0,
+            0,
+            frameWidth(),
+            frameHeight(),
+            frame(),
+            &m_bitmapInfo,
+            DIB_RGB_COLORS,
+            SRCCOPY);
+    else
+        SetDIBitsToDevice(
+            hdc,
+            m_viewportXOffset,
+            m_viewportYOffset,
+            width(),
+            height(),
+            0,
+            0,
+            0,
+            height(),
+            frame(),
+            &m_bitmapInfo,
+            DIB_RGB_COLORS);
+
+    ReleaseDC(m_hWnd, hdc);
+    return DRAW_PRESENTED;
+}
@@ -0,0 +1,51 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CVIEWDIB_HPP
+#define WINTEN_CVIEWDIB_HPP
+
+// Include external header files
+#include <windows.h>
+#include <mutex>
+
+// Include project header files
+#include "cviewframebuffer.hpp"
+
+/// <summary>
+///     Class implements a view under windows drawn by the tiled software
+///     rasterizer and presented to the window as a device independent bitmap.
+/// </summary>
+class CViewDIB : public CViewFramebuffer
+{
+private:
+    // Handle of owning window
+    HWND m_hWnd;
+    BITMAPINFO m_bitmapInfo;
+    int m_viewportXOffset;
+    int m_viewportYOffset;
+    bool m_needErase;
+    std::mutex m_presentMutex;
+
+protected:
+    bool presentsScaled(void) const override;
+
+public:
+    CViewDIB(HWND hWnd);
+    void initialize(int newXOffset, int newYOffset, int newWidth, int newHeight) override;
+    void shutdown(void) override;
+    DrawResult DrawAll(const CRenderList& list) override;
+};
+
+#endif
@@ -0,0 +1,632 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Include project header files
+#include "cframebuilder.hpp"
+#include "cframecapture.hpp"
+#include "cthreadpool.hpp"
+#include "cviewframebuffer.hpp"
+#include "font5x7.hpp"
+#include "winten_constants.hpp"
+
+namespace
+{
+    // Tile edge in pixels, a tile of pixels fitting comfortably in L2 cache
+    const int TILE_SIZE = 64;
+
+    /// <summary>
+    ///     Pixel range whose centres lie in [start, end), clipped to [low, high).
+    /// </summary>
+    void pixelSpan(float start, float end, int low, int high, int& first, int& last)
+    {
+        first = std::max(static_cast<int>(std::ceil(start - 0.5f)), low);
+        last = std::min(static_cast<int>(std::ceil(end - 0.5f)), high);
+    }
+}
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+CViewFramebuffer::CViewFramebuffer(void)
+    : m_width(0)
+    , m_height(0)
+    , m_quality(QUALITY_FULL)
+    , m_drawWidth(0)
+    , m_drawHeight(0)
+    , m_scaling(0)
+    , m_upscale(true)
+    , m_capture(nullptr)
+    , m_captureBlocking(false)
+    , m_kernels(&raster_kernels::selected())
+    , m_pool(new CThreadPool(std::max(static_cast<int>(std::thread::hardware_concurrency()), 1)))
+    , m_tileColumns(0)
+    , m_tileRows(0)
+{
+    CFrameBuilder::buildCourt(m_court);
+}
+
+/// <summary>
+///     Class destructor.
+/// </summary>
+CViewFramebuffer::~CViewFramebuffer()
+{
+}
+
+/// <summary>
+///     Initialize the view.
+/// </summary>
+/// <param name="newXOffset">Unused, the framebuffer has no margin.</param>
+/// <param name="newYOffset">Unused, the framebuffer has no margin.</param>
+/// <param name="newWidth">Width of framebuffer in pixels.</param>
+/// <param name="newHeight">Height of framebuffer in pixels.</param>
+void CViewFramebuffer::initialize(int newXOffset, int newYOffset, int newWidth, int newHeight)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_width = newWidth;
+    m_height = newHeight;
+    m_pixels.resize(static_cast<std::size_t>(m_width) * m_height);
+    layout();
+}
+
+/// <summary>
+///     Size the tiles and pre-render the court background for the quality
+///     level, every tile being drawn in full on the next frame.
+/// </summary>
+void CViewFramebuffer::layout(void)
+{
+    int divisor = m_quality >= QUALITY_HALF_RESOLUTION ? 2 : 1;
+
+    m_drawWidth = (m_width + divisor - 1) / divisor;
+    m_drawHeight = (m_height + divisor - 1) / divisor;
+    m_scaling = static_cast<float>(m_width) / winten_constants::W / static_cast<float>(divisor);
+    m_glyphs.clear();
+    m_tileColumns = (m_drawWidth + TILE_SIZE - 1) / TILE_SIZE;
+    m_tileRows = (m_drawHeight + TILE_SIZE - 1) / TILE_SIZE;
+    m_bins.assign(static_cast<std::size_t>(m_tileColumns) * m_tileRows, std::vector<BinEntry>());
+    m_tileDrawn.assign(m_bins.size(), 1);
+
+    // Pre-render the court background
+    m_background.assign(static_cast<std::size_t>(m_drawWidth) * m_drawHeight, winten_constants::COLOUR_BACKGROUND);
+    if (divisor > 1)
+        m_canvas.resize(m_background.size());
+    else
+        m_canvas.clear();
+    PixelRect frame = { 0, 0, m_drawWidth, m_drawHeight };
+    for (const RenderCommand& command : m_court.commands())
+        drawCommand(m_background.data(), frame, m_court, command, -1);
+}
+
+/// <summary>
+///     Set the static layout pre-rendered behind every frame.
+/// </summary>
+/// <param name="court">Layout to draw from the next initialize.</param>
+void CViewFramebuffer::setCourt(const CRenderList& court)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_court = court;
+}
+
+/// <summary>
+///     Shutdown the view.
+/// </summary>
+void CViewFramebuffer::shutdown(void)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_width = 0;
+    m_height = 0;
+}
+
+/// <summary>
+///     Fill a rectangle given in virtual coordinates.
+/// </summary>
+void CViewFramebuffer::fillRect(
+    std::uint32_t* pixels,
+    const PixelRect& clip,
+    float left,
+    float top,
+    float right,
+    float bottom,
+    std::uint32_t colour)
+{
+    int x0, x1, y0, y1;
+
+    pixelSpan(left * m_scaling, right * m_scaling, clip.left, clip.right, x0, x1);
+    pixelSpan(top * m_scaling, bottom * m_scaling, clip.top, clip.bottom, y0, y1);
+    if (x1 <= x0)
+        return;
+    for (int y = y0; y < y1; y++)
+        m_kernels->fillSpan(pixels + y * m_drawWidth + x0, x1 - x0, colour);
+}
+
+/// <summary>
+///     Fill the ellipse inscribed in a rectangle given in virtual coordinates
+///     with an anti-aliased edge, or a hard one without anti-aliasing.
+/// </summary>
+void CViewFramebuffer::fillEllipse(
+    std::uint32_t* pixels,
+    const PixelRect& clip,
+    float left,
+    float top,
+    float right,
+    float bottom,
+    std::uint32_t colour)
+{
+    float cx = (left + right) / 2.0f * m_scaling;
+    float cy = (top + bottom) / 2.0f * m_scaling;
+    float rx = (right - left) / 2.0f * m_scaling;
+    float ry = (bottom - top) / 2.0f * m_scaling;
+    int x0, x1, y0, y1;
+
+    if (rx <= 0.0f || ry <= 0.0f)
+        return;
+
+    // Include a pixel either side for the partially covered edge
+    pixelSpan(left * m_scaling - 1.0f, right * m_scaling + 1.0f, clip.left, clip.right, x0, x1);
+    pixelSpan(top * m_scaling - 1.0f, bottom * m_scaling + 1.0f, clip.top, clip.bottom, y0, y1);
+    if (x1 <= x0)
+        return;
+    for (int y = y0; y < y1; y++)
+    {
+        // Rows are stretched onto a circle of the horizontal radius
+        float dy = (y + 0.5f - cy) * rx / ry;
+        if (m_quality < QUALITY_NO_ANTIALIAS)
+            m_kernels->circleSpan(pixels + y * m_drawWidth + x0, x1 - x0, x0 + 0.5f - cx, dy * dy, rx, colour);
+        else if (dy * dy < rx * rx)
+        {
+            float half = std::sqrt(rx * rx - dy * dy);
+            int first, last;
+            pixelSpan(cx - half, cx + half, x0, x1, first, last);
+            if (last > first)
+                m_kernels->fillSpan(pixels + y * m_drawWidth + first, last - first, colour);
+        }
+    }
+}
+
+/// <summary>
+///     Get the coverage masks of every glyph at a text size, rasterizing them
+///     on first use with each font pixel supersampled four by four. Without
+///     anti-aliasing pixels are either covered or not.
+/// </summary>
+/// <param name="size">Text size in virtual coordinates.</param>
+/// <returns>The glyph masks.</returns>
+const CViewFramebuffer::GlyphSet& CViewFramebuffer::glyphs(float size)
+{
+    const int SAMPLES = 4;
+    const int GLYPH_COUNT = font5x7::LAST - font5x7::FIRST + 1;
+    float unit = size / font5x7::EM_HEIGHT * m_scaling;
+
+    for (const GlyphSet& set : m_glyphs)
+        if (set.size == size)
+            return set;
+
+    m_glyphs.push_back(GlyphSet());
+    GlyphSet& set = m_glyphs.back();
+    set.size = size;
+    set.width = static_cast<int>(std::ceil(font5x7::GLYPH_WIDTH * unit));
+    set.height = static_cast<int>(std::ceil(font5x7::GLYPH_HEIGHT * unit));
+    set.masks.assign(static_cast<std::size_t>(GLYPH_COUNT) * set.width * set.height, 0);
+
+    for (int index = 0; index < GLYPH_COUNT; index++)
+    {
+        const unsigned char* rows = font5x7::GLYPHS[index];
+        std::uint8_t* mask = &set.masks[static_cast<std::size_t>(index) * set.width * set.height];
+
+        for (int y = 0; y < set.height; y++)
+            for (int x = 0; x < set.width; x++)
+            {
+                int covered = 0;
+                for (int sy = 0; sy < SAMPLES; sy++)
+                    for (int sx = 0; sx < SAMPLES; sx++)
+                    {
+                        int row = static_cast<int>((y + (sy + 0.5f) / SAMPLES) / unit);
+                        int column = static_cast<int>((x + (sx + 0.5f) / SAMPLES) / unit);
+                        if (row < font5x7::GLYPH_HEIGHT && column < font5x7::GLYPH_WIDTH
+                            && (rows[row] & (1 << (font5x7::GLYPH_WIDTH - 1 - column))))
+                            covered++;
+                    }
+                if (m_quality >= QUALITY_NO_ANTIALIAS)
+                    covered = covered * 2 >= SAMPLES * SAMPLES ? SAMPLES * SAMPLES : 0;
+                mask[y * set.width + x] = static_cast<std::uint8_t>(covered * 255 / (SAMPLES * SAMPLES));
+            }
+    }
+    return set;
+}
+
+/// <summary>
+///     Draw text with the bitmap font, scaled so a line is the font size high.
+///     Glyphs are placed on whole pixels and blended through their masks.
+/// </summary>
+void CViewFramebuffer::drawText(
+    std::uint32_t* pixels,
+    const PixelRect& clip,
+    const std::string& text,
+    float x,
+    float y,
+    float size,
+    std::uint32_t colour)
+{
+    const GlyphSet& set = glyphs(size);
+    float unit = size / font5x7::EM_HEIGHT;
+    float penX = x;
+    float penY = y;
+
+    for (char character : text)
+    {
+        if (character == '\n')
+        {
+            penX = x;
+            penY += size;
+            continue;
+        }
+
+        int index = static_cast<int>(font5x7::glyph(character) - font5x7::GLYPHS[0]) / font5x7::GLYPH_HEIGHT;
+        const std::uint8_t* mask = &set.masks[static_cast<std::size_t>(index) * set.width * set.height];
+        int left = static_cast<int>(std::floor(penX * m_scaling + 0.5f));
+        int top = static_cast<int>(std::floor(penY * m_scaling + 0.5f));
+
+        // Clip the glyph box
+        int x0 = std::max(left, clip.left);
+        int x1 = std::min(left + set.width, clip.right);
+        int y0 = std::max(top, clip.top);
+        int y1 = std::min(top + set.height, clip.bottom);
+        if (character != ' ' && x1 > x0)
+            for (int row = y0; row < y1; row++)
+                m_kernels->maskSpan(
+                    pixels + row * m_drawWidth + x0,
+                    mask + (row - top) * set.width + (x0 - left),
+                    x1 - x0,
+                    colour);
+        penX += font5x7::ADVANCE * unit;
+    }
+}
+
+/// <summary>
+///     Draw one command clipped to a rectangle. Instanced commands draw the
+///     given instance, or all of them if the instance is -1.
+/// </summary>
+void CViewFramebuffer::drawCommand(
+    std::uint32_t* pixels,
+    const PixelRect& clip,
+    const CRenderList& list,
+    const RenderCommand& command,
+    int instance)
+{
+    const RenderInstance* positions = list.instances(command);
+    int first = instance < 0 ? 0 : instance;
+    int last = instance < 0 ? command.instanceCount : instance + 1;
+
+    switch (command.type)
+    {
+    case RENDER_FILL_RECT:
+        fillRect(pixels, clip, command.x, command.y, command.x + command.width, command.y + command.height, command.colour);
+        break;
+    case RENDER_FILL_ELLIPSE:
+        fillEllipse(pixels, clip, command.x, command.y, command.x + command.width, command.y + command.height, command.colour);
+        break;
+    case RENDER_TEXT:
+        drawText(pixels, clip, list.string(command.textId), command.x, command.y, command.height, command.colour);
+        break;
+    case RENDER_FILL_RECTS:
+        for (int index = first; index < last; index++)
+        {
+            float x = positions[index].x;
+            float y = positions[index].y;
+            fillRect(pixels, clip, x, y, x + command.width, y + command.height, command.colour);
+        }
+        break;
+    case RENDER_FILL_ELLIPSES:
+        for (int index = first; index < last; index++)
+        {
+            float x = positions[index].x;
+            float y = positions[index].y;
+            fillEllipse(pixels, clip, x, y, x + command.width, y + command.height, command.colour);
+        }
+        break;
+    }
+}
+
+/// <summary>
+///     Conservative pixel bounds of a command or one of its instances, used
+///     to bin it to tiles.
+/// </summary>
+CViewFramebuffer::PixelRect CViewFramebuffer::bounds(const CRenderList& list, const RenderCommand& command, int instance) const
+{
+    float x = instance < 0 ? command.x : list.instances(command)[instance].x;
+    float y = instance < 0 ? command.y : list.instances(command)[instance].y;
+    float right = x + command.width;
+    float bottom = y + command.height;
+    // Anti-aliased edges and glyphs rounded to whole pixels reach past the shape
+    float margin = 2.0f;
+
+    if (command.type == RENDER_TEXT)
+    {
+        const std::string& text = list.string(command.textId);
+        int lines = 1;
+        int columns = 0;
+        int widest = 0;
+
+        for (char character : text)
+        {
+            if (character == '\n')
+            {
+                lines++;
+                columns = 0;
+            }
+            else
+                widest = std::max(widest, ++columns);
+        }
+        right = x + widest * font5x7::ADVANCE * command.height / font5x7::EM_HEIGHT;
+        bottom = y + lines * command.height;
+    }
+
+    PixelRect rect = {
+        static_cast<int>(std::floor(x * m_scaling - margin)),
+        static_cast<int>(std::floor(y * m_scaling - margin)),
+        static_cast<int>(std::ceil(right * m_scaling + margin)),
+        static_cast<int>(std::ceil(bottom * m_scaling + margin)) };
+    return rect;
+}
+
+/// <summary>
+///     Add a command or one of its instances to the bins of the tiles it overlaps.
+/// </summary>
+/// <param name="list">Frame commands.</param>
+/// <param name="command">Command index.</param>
+/// <param name="instance">Instance index, or -1 if not instanced.</param>
+void CViewFramebuffer::bin(const CRenderList& list, int command, int instance)
+{
+    PixelRect rect = bounds(list, list.commands()[command], instance);
+    BinEntry entry = { command, instance };
+
+    if (rect.right <= 0 || rect.bottom <= 0 || rect.left >= m_drawWidth || rect.top >= m_drawHeight)
+        return;
+
+    int column0 = std::max(rect.left, 0) / TILE_SIZE;
+    int column1 = std::min(rect.right - 1, m_drawWidth - 1) / TILE_SIZE;
+    int row0 = std::max(rect.top, 0) / TILE_SIZE;
+    int row1 = std::min(rect.bottom - 1, m_drawHeight - 1) / TILE_SIZE;
+    for (int row = row0; row <= row1; row++)
+        for (int column = column0; column <= column1; column++)
+            m_bins[row * m_tileColumns + column].push_back(entry);
+}
+
+/// <summary>
+///     Draw one tile: copy its background then draw its binned commands. With
+///     dirty regions a tile nothing was drawn on in this frame or the last is
+///     left as it is.
+/// </summary>
+/// <param name="tile">Row-major tile index.</param>
+/// <param name="list">Frame commands.</param>
+void CViewFramebuffer::drawTile(int tile, const CRenderList& list)
+{
+    int column = tile % m_tileColumns;
+    int row = tile / m_tileColumns;
+    PixelRect clip = {
+        column * TILE_SIZE,
+        row * TILE_SIZE,
+        std::min((column + 1) * TILE_SIZE, m_drawWidth),
+        std::min((row + 1) * TILE_SIZE, m_drawHeight) };
+    std::vector<std::uint32_t>& pixels = m_canvas.empty() ? m_pixels : m_canvas;
+    bool drawn = !m_bins[tile].empty();
+
+    if (m_quality >= QUALITY_DIRTY_REGIONS && !drawn && !m_tileDrawn[tile])
+        return;
+    m_tileDrawn[tile] = drawn;
+
+    for (int y = clip.top; y < clip.bottom; y++)
+        std::copy(
+            m_background.begin() + y * m_drawWidth + clip.left,
+            m_background.begin() + y * m_drawWidth + clip.right,
+            pixels.begin() + y * m_drawWidth + clip.left);
+
+    for (const BinEntry& entry : m_bins[tile])
+        drawCommand(pixels.data(), clip, list, list.commands()[entry.command], entry.instance);
+
+    if (!m_canvas.empty() && m_upscale)
+        upscaleTile(clip);
+}
+
+/// <summary>
+///     Scale a tile of the half resolution canvas up into the framebuffer,
+///     widening each row once and copying it to the row below.
+/// </summary>
+/// <param name="clip">Tile in canvas pixels.</param>
+void CViewFramebuffer::upscaleTile(const PixelRect& clip)
+{
+    int left = clip.left * 2;
+    int right = std::min(clip.right * 2, m_width);
+    int bottom = std::min(clip.bottom * 2, m_height);
+
+    for (int y = clip.top * 2; y < bottom; y += 2)
+    {
+        const std::uint32_t* source = &m_canvas[static_cast<std::size_t>(y / 2) * m_drawWidth];
+        std::uint32_t* destination = &m_pixels[static_cast<std::size_t>(y) * m_width];
+        int x = left;
+
+        for (; x + 1 < right; x += 2)
+        {
+            std::uint32_t colour = source[x / 2];
+            destination[x] = colour;
+            destination[x + 1] = colour;
+        }
+        if (x < right)
+            destination[x] = source[x / 2];
+        if (y + 1 < bottom)
+            std::copy(destination + left, destination + right, destination + m_width + left);
+    }
+}
+
+/// <summary>
+///     Draws all objects in the view and passes the frame to the capture.
+/// </summary>
+/// <param name="list">Frame commands to draw.</param>
+/// <returns>Skipped without a frame to draw into, dropped if a capture had no free buffer.</returns>
+DrawResult CViewFramebuffer::DrawAll(const CRenderList& list)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+    const std::vector<RenderCommand>& commands = list.commands();
+
+    if (m_width <= 0 || m_height <= 0)
+        return DRAW_SKIPPED;
+
+    // Bin commands and instances to the tiles they overlap, keeping their order
+    for (std::vector<BinEntry>& entries : m_bins)
+        entries.clear();
+    for (int index = 0; index < static_cast<int>(commands.size()); index++)
+    {
+        const RenderCommand& command = commands[index];
+
+        // Masks are shared read-only between tiles so are built up front
+        if (command.type == RENDER_TEXT)
+            glyphs(command.height);
+        if (command.type == RENDER_FILL_RECTS || command.type == RENDER_FILL_ELLIPSES)
+        {
+            for (int instance = 0; instance < command.instanceCount; instance++)
+                bin(list, index, instance);
+        }
+        else
+            bin(list, index, -1);
+    }
+
+    // Starting or stopping scaling up half resolution frames redraws every tile
+    bool upscale = m_capture != nullptr || !presentsScaled();
+    if (upscale != m_upscale)
+    {
+        m_upscale = upscale;
+        m_tileDrawn.assign(m_tileDrawn.size(), 1);
+    }
+
+    m_pool->run(static_cast<int>(m_bins.size()), [this, &list](int tile) { drawTile(tile, list); });
+
+    if (m_capture != nullptr && !m_capture->submit(m_pixels.data(), m_width, m_captureBlocking) && !m_captureBlocking)
+        return DRAW_DROPPED;
+    return DRAW_PRESENTED;
+}
+
+/// <summary>
+///     A capture needs a frame on every tick, changed or not.
+/// </summary>
+/// <returns>True while capturing.</returns>
+bool CViewFramebuffer::drawsEveryFrame(void) const
+{
+    return m_capture != nullptr;
+}
+
+/// <summary>
+///     Set the quality level, laying the frame out again for it.
+/// </summary>
+/// <param name="quality">Quality level.</param>
+void CViewFramebuffer::setQuality(RenderQuality quality)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_quality = quality;
+    if (m_width > 0 && m_height > 0)
+        layout();
+}
+
+/// <summary>
+///     Attach a capture receiving every drawn frame.
+/// </summary>
+/// <param name="capture">Capture of the framebuffer's size, or nullptr to detach.</param>
+/// <param name="blocking">True to wait for a free capture buffer rather than drop the frame.</param>
+void CViewFramebuffer::setCapture(CFrameCapture* capture, bool blocking)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_capture = capture;
+    m_captureBlocking = blocking;
+}
+
+/// <summary>
+///     Replace the raster kernels, for comparing variants.
+/// </summary>
+/// <param name="kernels">Kernels the processor supports.</param>
+void CViewFramebuffer::setKernels(const RasterKernels& kernels)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_kernels = &kernels;
+}
+
+/// <summary>
+///     Set the number of threads drawing tiles, by default one per core.
+/// </summary>
+/// <param name="threads">Thread count including the drawing thread.</param>
+void CViewFramebuffer::setThreads(int threads)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_pool.reset(new CThreadPool(std::max(threads, 1)));
+}
+
+/// <summary>
+///     Pixels of the last drawn frame, row-major 0xXXRRGGBB. At half
+///     resolution they are only kept up to date if the view isn't presented
+///     scaled or a capture is attached.
+/// </summary>
+const std::uint32_t* CViewFramebuffer::pixels(void) const
+{
+    return m_pixels.data();
+}
+
+/// <summary>
+///     Width in pixels.
+/// </summary>
+int CViewFramebuffer::width(void) const
+{
+    return m_width;
+}
+
+/// <summary>
+///     Height in pixels.
+/// </summary>
+int CViewFramebuffer::height(void) const
+{
+    return m_height;
+}
+
+/// <summary>
+///     Pixels of the last frame as drawn, at half resolution before scaling
+///     up if reduced, row-major 0xXXRRGGBB.
+/// </summary>
+const std::uint32_t* CViewFramebuffer::frame(void) const
+{
+    return m_canvas.empty() ? m_pixels.data() : m_canvas.data();
+}
+
+/// <summary>
+///     Width of the frame as drawn in pixels.
+/// </summary>
+int CViewFramebuffer::frameWidth(void) const
+{
+    return m_drawWidth;
+}
+
+/// <summary>
+///     Height of the frame as drawn in pixels.
+/// </summary>
+int CViewFramebuffer::frameHeight(void) const
+{
+    return m_drawHeight;
+}
@@ -0,0 +1,143 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CVIEWFRAMEBUFFER_HPP
+#define WINTEN_CVIEWFRAMEBUFFER_HPP
+
+// Include external header files
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "iview.hpp"
+#include "rasterkernels.hpp"
+#include "renderlist.hpp"
+
+class CFrameCapture;
+class CThreadPool;
+
+/// <summary>
+///     Class implements a software rendered view into an in-memory 32-bit
+///     XRGB framebuffer, optionally feeding every frame to a capture. Spans
+///     are drawn by the fastest raster kernels the processor supports.
+///     Frames are split into tiles which are drawn in parallel, each from
+///     the commands binned to it.
+/// </summary>
+class CViewFramebuffer : public IView
+{
+private:
+    /// <summary>
+    ///     Pixel rectangle, right and bottom exclusive.
+    /// </summary>
+    struct PixelRect
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    /// <summary>
+    ///     A command, or one instance of an instanced command, binned to a tile.
+    /// </summary>
+    struct BinEntry
+    {
+        int command;
+        // Instance index, -1 for commands which are not instanced
+        int instance;
+    };
+
+    /// <summary>
+    ///     Anti-aliased coverage masks of every font glyph at one text size.
+    /// </summary>
+    struct GlyphSet
+    {
+        float size;
+        int width;
+        int height;
+        std::vector<std::uint8_t> masks;
+    };
+
+    int m_width;
+    int m_height;
+    // Quality level, and the size and scaling frames are drawn at, half the
+    // framebuffer's at reduced resolution
+    RenderQuality m_quality;
+    int m_drawWidth;
+    int m_drawHeight;
+    float m_scaling;
+    CRenderList m_court;
+    std::vector<std::uint32_t> m_background;
+    std::vector<std::uint32_t> m_pixels;
+    // Half resolution frame, scaled up into the framebuffer unless the
+    // presenter scales it
+    std::vector<std::uint32_t> m_canvas;
+    bool m_upscale;
+    CFrameCapture* m_capture;
+    bool m_captureBlocking;
+    std::mutex m_updateMutex;
+    const RasterKernels* m_kernels;
+    std::vector<GlyphSet> m_glyphs;
+    std::unique_ptr<CThreadPool> m_pool;
+    // Commands overlapping each tile, reused between frames
+    int m_tileColumns;
+    int m_tileRows;
+    std::vector<std::vector<BinEntry>> m_bins;
+    // Tiles drawn on in the last frame, the others still holding the background
+    std::vector<std::uint8_t> m_tileDrawn;
+
+    void layout(void);
+    const GlyphSet& glyphs(float size);
+    PixelRect bounds(const CRenderList& list, const RenderCommand& command, int instance) const;
+    void bin(const CRenderList& list, int command, int instance);
+    void drawTile(int tile, const CRenderList& list);
+    void upscaleTile(const PixelRect& clip);
+    void drawCommand(std::uint32_t* pixels, const PixelRect& clip, const CRenderList& list, const RenderCommand& command, int instance);
+    void fillRect(std::uint32_t* pixels, const PixelRect& clip, float left, float top, float right, float bottom, std::uint32_t colour);
+    void fillEllipse(std::uint32_t* pixels, const PixelRect& clip, float left, float top, float right, float bottom, std::uint32_t colour);
+    void drawText(std::uint32_t* pixels, const PixelRect& clip, const std::string& text, float x, float y, float size, std::uint32_t colour);
+
+protected:
+    // True if the frame is presented scaled to the viewport, so a half
+    // resolution frame needn't be scaled up unless captured
+    virtual bool presentsScaled(void) const
+    {
+        return false;
+    }
+
+public:
+    CViewFramebuffer(void);
+    ~CViewFramebuffer();
+    void initialize(int newXOffset, int newYOffset, int newWidth, int newHeight) override;
+    void shutdown(void) override;
+    void setCourt(const CRenderList& court) override;
+    DrawResult DrawAll(const CRenderList& list) override;
+    bool drawsEveryFrame(void) const override;
+    void setQuality(RenderQuality quality) override;
+    void setCapture(CFrameCapture* capture, bool blocking);
+    void setKernels(const RasterKernels& kernels);
+    void setThreads(int threads);
+    const std::uint32_t* pixels(void) const;
+    int width(void) const;
+    int height(void) const;
+    const std::uint32_t* frame(void) const;
+    int frameWidth(void) const;
+    int frameHeight(void) const;
+};
+
+#endif
@@ -17,10 +17,11 @@
 #include <windows.h>
 #include <objidl.h>
 #include <gdiplus.h>
+#include <algorithm>
 
 // Include project header files
+#include "cframebuilder.hpp"
 #include "cviewgdi.hpp"
-#include "istate.hpp"
 
 /// <summary>
 ///   Class constructor.
@@ -34,7 +35,12 @@ CViewGDI::CViewGDI(HWND hWnd)
     , m_hBitmapDrawPrevious(0)
     , m_hdcBackground(0)
     , m_hdcBuffer(0)
+    , m_hdcBackgroundHalf(0)
+    , m_hBitmapBackgroundHalf(0)
+    , m_hBitmapBackgroundHalfPrevious(0)
     , m_needErase(true)
+    , m_quality(QUALITY_FULL)
+    , m_dirtyValid(false)
     , m_viewportHeight(0)
     , m_viewportWidth(0)
     , m_viewportXOffset(0)
@@ -44,10 +50,9 @@ CViewGDI::CViewGDI(HWND hWnd)
     // Initialize GDI+.
     Gdiplus::GdiplusStartup(&m_gdiplusToken, &m_gdiplusStartupInput, NULL);
 
-    // Draw field
-    m_brushGreen.reset(new Gdiplus::SolidBrush((Gdiplus::Color(255, 0, 255, 0))));
-    m_brushBlack.reset(new Gdiplus::SolidBrush((Gdiplus::Color(255, 0, 0, 0))));
-    
+    // Layout of the field
+    CFrameBuilder::buildCourt(m_court);
+
     // Font will be scaled and recreated during resize
     m_fontFamily.reset(new Gdiplus::FontFamily(L"Times New Roman"));
 }
@@ -58,9 +63,181 @@ CViewGDI::CViewGDI(HWND hWnd)
 CViewGDI::~CViewGDI()
 {
     // Destroy resources
+    m_brushes.clear();
+    m_font.reset(nullptr);
+    m_fontHalf.reset(nullptr);
+    m_fontFamily.reset(nullptr);
     Gdiplus::GdiplusShutdown(m_gdiplusToken);
 }
 
+/// <summary>
+///     Get a cached brush for a colour.
+/// </summary>
+/// <param name="colour">Colour as 0xAARRGGBB.</param>
+/// <returns>The brush.</returns>
+Gdiplus::SolidBrush* CViewGDI::brush(std::uint32_t colour)
+{
+    for (auto& entry : m_brushes)
+        if (entry.first == colour)
+            return entry.second.get();
+
+    m_brushes.emplace_back(
+        colour,
+        std::unique_ptr<Gdiplus::SolidBrush>(new Gdiplus::SolidBrush(Gdiplus::Color(colour))));
+    return m_brushes.back().second.get();
+}
+
+/// <summary>
+///     Scale and draw the commands of a render list.
+/// </summary>
+/// <param name="graphics">Graphics object to draw with.</param>
+/// <param name="list">Commands to draw.</param>
+/// <param name="scaling">Pixels per virtual unit.</param>
+/// <param name="font">Font scaled to match.</param>
+void CViewGDI::drawList(Gdiplus::Graphics* graphics, const CRenderList& list, float scaling, Gdiplus::Font* font)
+{
+    // Refresh wide copies of strings which changed
+    if (static_cast<int>(m_text.size()) < list.stringCount())
+    {
+        m_text.resize(list.stringCount());
+        m_textRevisions.resize(list.stringCount(), 0);
+    }
+    for (int textId = 0; textId < list.stringCount(); textId++)
+    {
+        if (m_textRevisions[textId] != list.revision(textId))
+        {
+            const std::string& text = list.string(textId);
+            m_text[textId].assign(text.begin(), text.end());
+            m_textRevisions[textId] = list.revision(textId);
+        }
+    }
+
+    for (const RenderCommand& command : list.commands())
+    {
+        switch (command.type)
+        {
+        case RENDER_FILL_RECT:
+            graphics->FillRectangle(
+                brush(command.colour),
+                command.x * scaling,
+                command.y * scaling,
+                command.width * scaling,
+                command.height * scaling);
+            break;
+        case RENDER_FILL_ELLIPSE:
+            graphics->FillEllipse(
+                brush(command.colour),
+                command.x * scaling,
+                command.y * scaling,
+                command.width * scaling,
+                command.height * scaling);
+            break;
+        case RENDER_FILL_RECTS:
+        {
+            const RenderInstance* positions = list.instances(command);
+            m_rects.clear();
+            for (int index = 0; index < command.instanceCount; index++)
+                m_rects.push_back(
+                    Gdiplus::RectF(
+                        positions[index].x * scaling,
+                        positions[index].y * scaling,
+                        command.width * scaling,
+                        command.height * scaling));
+            graphics->FillRectangles(brush(command.colour), m_rects.data(), static_cast<INT>(m_rects.size()));
+            break;
+        }
+        case RENDER_FILL_ELLIPSES:
+        {
+            const RenderInstance* positions = list.instances(command);
+            for (int index = 0; index < command.instanceCount; index++)
+                graphics->FillEllipse(
+                    brush(command.colour),
+                    positions[index].x * scaling,
+                    positions[index].y * scaling,
+                    command.width * scaling,
+                    command.height * scaling);
+            break;
+        }
+        case RENDER_TEXT:
+            graphics->DrawString(
+                m_text[command.textId].c_str(),
+                -1,
+                font,
+                Gdiplus::PointF(command.x * scaling, command.y * scaling),
+                brush(command.colour));
+            break;
+        }
+    }
+}
+
+/// <summary>
+///     Turn anti-aliasing of shapes and text on for full quality, or off.
+/// </summary>
+void CViewGDI::setAntialias(void)
+{
+    bool antialias = m_quality < QUALITY_NO_ANTIALIAS;
+
+    m_graphics->SetSmoothingMode(antialias ? Gdiplus::SmoothingModeAntiAlias : Gdiplus::SmoothingModeHighSpeed);
+    m_graphics->SetTextRenderingHint(
+        antialias ? Gdiplus::TextRenderingHintAntiAlias : Gdiplus::TextRenderingHintSingleBitPerPixelGridFit);
+}
+
+/// <summary>
+///     Record the areas of the buffer a frame drew over, with a margin for
+///     anti-aliased edges. Text is bounded by a square per character.
+/// </summary>
+/// <param name="list">Commands drawn.</param>
+/// <param name="scaling">Pixels per virtual unit.</param>
+/// <param name="width">Width of the buffer area in use.</param>
+/// <param name="height">Height of the buffer area in use.</param>
+void CViewGDI::recordDirty(const CRenderList& list, float scaling, int width, int height)
+{
+    m_dirty.clear();
+    for (const RenderCommand& command : list.commands())
+    {
+        const RenderInstance* positions = list.instances(command);
+        bool instanced = command.type == RENDER_FILL_RECTS || command.type == RENDER_FILL_ELLIPSES;
+        int count = instanced ? command.instanceCount : 1;
+        float right = command.width;
+        float bottom = command.height;
+
+        if (command.type == RENDER_TEXT)
+        {
+            const std::string& text = list.string(command.textId);
+            int lines = 1;
+            int columns = 0;
+            int widest = 0;
+
+            for (char character : text)
+            {
+                if (character == '\n')
+                {
+                    lines++;
+                    columns = 0;
+                }
+                else
+                    widest = std::max(widest, ++columns);
+            }
+            right = (widest + 1) * command.height;
+            bottom = (lines + 1) * command.height;
+        }
+
+        for (int index = 0; index < count; index++)
+        {
+            float x = instanced ? positions[index].x : command.x;
+            float y = instanced ? positions[index].y : command.y;
+            RECT rect;
+
+            rect.left = std::max(static_cast<int>(x * scaling) - 2, 0);
+            rect.top = std::max(static_cast<int>(y * scaling) - 2, 0);
+            rect.right = std::min(static_cast<int>((x + right) * scaling) + 3, width);
+            rect.bottom = std::min(static_cast<int>((y + bottom) * scaling) + 3, height);
+            if (rect.right > rect.left && rect.bottom > rect.top)
+                m_dirty.push_back(rect);
+        }
+    }
+}
+
 /// <summary>
 ///     Initialize the view.
 /// </summary>
@@ -92,34 +269,37 @@ void CViewGDI::initialize(int newXOffset, int newYOffset, int newWidth, int newH
     m_hBitmapDraw = CreateCompatibleBitmap(hdcWindow, newWidth, newHeight);
     // Create a compatible bitmap for drawing
     m_hBitmapBackground = CreateCompatibleBitmap(hdcWindow, newWidth, newHeight);
+    // Create the half resolution background layer
+    m_hdcBackgroundHalf = CreateCompatibleDC(hdcWindow);
+    m_hBitmapBackgroundHalf = CreateCompatibleBitmap(hdcWindow, (newWidth + 1) / 2, (newHeight + 1) / 2);
     // Select new bitmap into device context
     m_hBitmapDrawPrevious = (HBITMAP)SelectObject(m_hdcBuffer, m_hBitmapDraw);
     m_hBitmapBackgroundPrevious = (HBITMAP)SelectObject(m_hdcBackground, m_hBitmapBackground);
-    // Create graphics object
-    m_graphics.reset(new Gdiplus::Graphics(m_hdcBackground));
-
-    // Draw filled rectangles
-    m_graphics->FillRectangle(
-        m_brushGreen.get(),
-        0,
-        0,
-        newWidth,
-        newHeight);
-    m_graphics->FillRectangle(
-        m_brushBlack.get(),
-        winten_constants::FIELD_BORDER * m_scaling,
-        winten_constants::FIELD_BORDER * m_scaling,
-        (winten_constants::W - 2.0f * winten_constants::FIELD_BORDER) * m_scaling,
-        (winten_constants::H - 2.0f * winten_constants::FIELD_BORDER) * m_scaling);
-
-    // Reset graphics objects
-    m_graphics.reset(new Gdiplus::Graphics(m_hdcBuffer));
+    m_hBitmapBackgroundHalfPrevious = (HBITMAP)SelectObject(m_hdcBackgroundHalf, m_hBitmapBackgroundHalf);
+    // Create fonts for both resolutions
     m_font.reset(
         new Gdiplus::Font(
             m_fontFamily.get(), 
-            24.0f * m_scaling,
+            winten_constants::TEXT_SIZE * m_scaling,
             Gdiplus::FontStyleRegular, 
             Gdiplus::UnitPixel));
+    m_fontHalf.reset(
+        new Gdiplus::Font(
+            m_fontFamily.get(),
+            winten_constants::TEXT_SIZE * m_scaling / 2.0f,
+            Gdiplus::FontStyleRegular,
+            Gdiplus::UnitPixel));
+
+    // Draw the court into the background layers
+    m_graphics.reset(new Gdiplus::Graphics(m_hdcBackground));
+    drawList(m_graphics.get(), m_court, m_scaling, m_font.get());
+    m_graphics.reset(new Gdiplus::Graphics(m_hdcBackgroundHalf));
+    drawList(m_graphics.get(), m_court, m_scaling / 2.0f, m_fontHalf.get());
+
+    // Reset graphics objects
+    m_graphics.reset(new Gdiplus::Graphics(m_hdcBuffer));
+    setAntialias();
+    m_dirtyValid = false;
 
     // Release window DC
     ReleaseDC(m_hWnd, hdcWindow);
@@ -128,6 +308,17 @@ void CViewGDI::initialize(int newXOffset, int newYOffset, int newWidth, int newH
     gdiUpdateMutex.unlock();
 }
 
+/// <summary>
+///     Set the static layout drawn into the background layer.
+/// </summary>
+/// <param name="court">Layout to draw from the next initialize.</param>
+void CViewGDI::setCourt(const CRenderList& court)
+{
+    std::lock_guard<std::mutex> lock(gdiUpdateMutex);
+
+    m_court = court;
+}
+
 /// <summary>
 ///     Shutdown the view.
 /// </summary>
@@ -143,14 +334,20 @@ void CViewGDI::shutdown(void)
     SelectObject(m_hdcBuffer, m_hBitmapDrawPrevious);
     // Restore previous bitmap into device context
     SelectObject(m_hdcBackground, m_hBitmapBackgroundPrevious);
+    // Restore previous bitmap into device context
+    SelectObject(m_hdcBackgroundHalf, m_hBitmapBackgroundHalfPrevious);
     // Delete drawing bitmap
     DeleteObject(m_hBitmapDraw);
     // Delete drawing bitmap
     DeleteObject(m_hBitmapBackground);
+    // Delete drawing bitmap
+    DeleteObject(m_hBitmapBackgroundHalf);
     // Delete the buffering device context
     DeleteDC(m_hdcBuffer);
     // Delete the buffering device context
     DeleteDC(m_hdcBackground);
+    // Delete the buffering device context
+    DeleteDC(m_hdcBackgroundHalf);
 
     // Unlock mutex
     gdiUpdateMutex.unlock();
@@ -159,15 +356,12 @@ void CViewGDI::shutdown(void)
 /// <summary>
 ///     Draws all objects in the view.
 /// </summary>
-/// <param name="state">State to draw.</param>
-/// <param name="fps">Frames per second for display.</param>
-/// <param name="latency">Latency for display.</param>
-void CViewGDI::DrawAll(
-    IState* state,
-    float fps,
-    float latency) 
+/// <param name="list">Frame commands to draw.</param>
+/// <returns>Whether the frame was presented or skipped while resizing.</returns>
+DrawResult CViewGDI::DrawAll(const CRenderList& list)
 {
     HDC hdc;
+    DrawResult result = DRAW_SKIPPED;
 
     // Attempt to get exclusive access to GDI resources
     if (gdiUpdateMutex.try_lock())
@@ -175,79 +369,39 @@ void CViewGDI::DrawAll(
         // If graphics object initialised
         if (m_graphics.get() != nullptr)
         {
+            // At half resolution the frame is drawn into a corner of the buffer
+            bool half = m_quality >= QUALITY_HALF_RESOLUTION;
+            float scaling = half ? m_scaling / 2.0f : m_scaling;
+            int width = half ? (m_viewportWidth + 1) / 2 : m_viewportWidth;
+            int height = half ? (m_viewportHeight + 1) / 2 : m_viewportHeight;
+            HDC hdcBackground = half ? m_hdcBackgroundHalf : m_hdcBackground;
+
             // Get window client area device context
             hdc = GetDC(m_hWnd);
 
-            // Copy background layer to buffer
-            BitBlt(m_hdcBuffer, 0, 0, m_viewportWidth, m_viewportHeight, m_hdcBackground, 0, 0, SRCCOPY);
-
-            // Draw player
-            m_graphics->FillRectangle(
-                m_brushGreen.get(),
-                (state->player.x - winten_constants::PADDLE_WIDTH / 2.0f) * m_scaling,
-                (state->player.y - winten_constants::PADDLE_HEIGHT / 2.0f) * m_scaling,
-                winten_constants::PADDLE_WIDTH * m_scaling,
-                winten_constants::PADDLE_HEIGHT * m_scaling);
-
-            // Draw NPC
-            m_graphics->FillRectangle(
-                m_brushGreen.get(),
-                (state->npc.x - winten_constants::PADDLE_WIDTH / 2) * m_scaling,
-                (state->npc.y - winten_constants::PADDLE_HEIGHT / 2) * m_scaling,
-                winten_constants::PADDLE_WIDTH * m_scaling,
-                winten_constants::PADDLE_HEIGHT * m_scaling);
-
-            // Draw ball
-            m_graphics->FillEllipse(
-                m_brushGreen.get(),
-                (state->ball.x - winten_constants::BALL_DIAMETER / 2) * m_scaling,
-                (state->ball.y - winten_constants::BALL_DIAMETER / 2) * m_scaling,
-                winten_constants::BALL_DIAMETER * m_scaling,
-                winten_constants::BALL_DIAMETER * m_scaling);
-
-            // Convert numeric values to string 
-            std::wostringstream fpsText;
-            fpsText << L"FPS: " << std::setprecision(4) << fps;
-            std::wostringstream latencyText;
-            latencyText << L"LAT: " << std::setprecision(4) << latency;
-            std::wostringstream scoreNpcText;
-            scoreNpcText << state->scoreNpc;
-            std::wostringstream scorePlayerText;
-            scorePlayerText << state->scorePlayer;
-            std::wostringstream messageText;
-            messageText << state->message.c_str();
-
-            // Draw text in window
-            m_graphics->DrawString(
-                scoreNpcText.str().c_str(),
-                -1,
-                m_font.get(),
-                Gdiplus::PointF(winten_constants::SCORE_TEXT_NPC * m_scaling, winten_constants::SCORE_TEXT_Y * m_scaling),
-                m_brushGreen.get());
-            m_graphics->DrawString(
-                fpsText.str().c_str(),
-                -1,
-                m_font.get(),
-                Gdiplus::PointF(winten_constants::SCORE_TEXT_NPC * m_scaling, 2.0f * winten_constants::SCORE_TEXT_Y * m_scaling),
-                m_brushGreen.get());
-            m_graphics->DrawString(
-                latencyText.str().c_str(),
-                -1,
-                m_font.get(),
-                Gdiplus::PointF(winten_constants::SCORE_TEXT_NPC * m_scaling, 3.0f * winten_constants::SCORE_TEXT_Y * m_scaling),
-                m_brushGreen.get());
-            m_graphics->DrawString(
-                scorePlayerText.str().c_str(),
-                -1,
-                m_font.get(),
-                Gdiplus::PointF(winten_constants::SCORE_TEXT_PLAYER * m_scaling, winten_constants::SCORE_TEXT_Y * m_scaling),
-                m_brushGreen.get());
-            m_graphics->DrawString(
-                messageText.str().c_str(),
-                -1,
-                m_font.get(),
-                Gdiplus::PointF(winten_constants::MESSAGE_TEXT_X * m_scaling, winten_constants::MESSAGE_TEXT_Y * m_scaling),
-                m_brushGreen.get());
+            // Copy background layer to buffer, only where the last frame
+            // drew when using dirty regions
+            if (m_quality >= QUALITY_DIRTY_REGIONS && m_dirtyValid)
+            {
+                for (const RECT& rect : m_dirty)
+                    BitBlt(
+                        m_hdcBuffer,
+                        rect.left,
+                        rect.top,
+                        rect.right - rect.left,
+                        rect.bottom - rect.top,
+                        hdcBackground,
+                        rect.left,
+                        rect.top,
+                        SRCCOPY);
+            }
+            else
+                BitBlt(m_hdcBuffer, 0, 0, width, height, hdcBackground, 0, 0, SRCCOPY);
+
+            // Draw paddles, ball and text
+            drawList(m_graphics.get(), list, scaling, half ? m_fontHalf.get() : m_font.get());
+            recordDirty(list, scaling, width, height);
+            m_dirtyValid = true;
 
             // Copy the buffer hdc to the window hdc
             if (m_needErase)
@@ -261,14 +415,48 @@ void CViewGDI::DrawAll(
                 m_needErase = false;
             }
 
-            // Copy back buffer to window client area
-            BitBlt(hdc, m_viewportXOffset, m_viewportYOffset, m_viewportWidth, m_viewportHeight, m_hdcBuffer, 0, 0, SRCCOPY);
+            // Copy back buffer to window client area, scaling up a half
+            // resolution frame
+            if (half)
+            {
+                SetStretchBltMode(hdc, COLORONCOLOR);
+                StretchBlt(
+                    hdc,
+                    m_viewportXOffset,
+                    m_viewportYOffset,
+                    m_viewportWidth,
+                    m_viewportHeight,
+                    m_hdcBuffer,
+                    0,
+                    0,
+                    width,
+                    height,
+                    SRCCOPY);
+            }
+            else
+                BitBlt(hdc, m_viewportXOffset, m_viewportYOffset, m_viewportWidth, m_viewportHeight, m_hdcBuffer, 0, 0, SRCCOPY);
 
             // Release the device context
             ReleaseDC(m_hWnd, hdc);
+            result = DRAW_PRESENTED;
         }
 
         // Unlock mutex
         gdiUpdateMutex.unlock();
     }
+    return result;
+}
+
+/// <summary>
+///     Set the quality level from the next frame.
+/// </summary>
+/// <param name="quality">Quality level.</param>
+void CViewGDI::setQuality(RenderQuality quality)
+{
+    std::lock_guard<std::mutex> lock(gdiUpdateMutex);
+
+    m_quality = quality;
+    m_dirtyValid = false;
+    if (m_graphics.get() != nullptr)
+        setAntialias();
 }
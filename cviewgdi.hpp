@@ -20,14 +20,16 @@
 #include <windows.h>
 #include <objidl.h>
 #include <gdiplus.h>
-#include <iomanip>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 // Include project header files
-#include "istate.hpp"
 #include "iview.hpp"
+#include "renderlist.hpp"
 #include "winten_constants.hpp"
 
 /// <summary>
@@ -45,12 +47,16 @@ private:
     HBITMAP m_hBitmapDraw;
     HBITMAP m_hBitmapBackground;
     HBITMAP m_hBitmapBackgroundPrevious;
+    // Background layer for drawing at half resolution
+    HDC m_hdcBackgroundHalf;
+    HBITMAP m_hBitmapBackgroundHalf;
+    HBITMAP m_hBitmapBackgroundHalfPrevious;
     // GDI resources allocated
     std::unique_ptr<Gdiplus::Graphics> m_graphics;
-    std::unique_ptr<Gdiplus::SolidBrush> m_brushGreen;
-    std::unique_ptr<Gdiplus::SolidBrush> m_brushBlack;
+    std::vector<std::pair<std::uint32_t, std::unique_ptr<Gdiplus::SolidBrush>>> m_brushes;
     std::unique_ptr<Gdiplus::FontFamily> m_fontFamily;
     std::unique_ptr<Gdiplus::Font> m_font;
+    std::unique_ptr<Gdiplus::Font> m_fontHalf;
     Gdiplus::GdiplusStartupInput m_gdiplusStartupInput;
     ULONG_PTR           m_gdiplusToken;
     // Internal state
@@ -60,17 +66,33 @@ private:
     int m_viewportYOffset;
     float m_scaling;
     bool m_needErase;
+    RenderQuality m_quality;
+    // Areas of the buffer the last frame drew over, and whether the rest
+    // of the buffer still holds the background
+    std::vector<RECT> m_dirty;
+    bool m_dirtyValid;
     std::mutex gdiUpdateMutex;
+    // Static court layout drawn into the background layer
+    CRenderList m_court;
+    // Wide copies of the render list string table
+    std::vector<std::wstring> m_text;
+    std::vector<std::uint32_t> m_textRevisions;
+    // Scratch rectangles for instanced drawing
+    std::vector<Gdiplus::RectF> m_rects;
+
+    Gdiplus::SolidBrush* brush(std::uint32_t colour);
+    void drawList(Gdiplus::Graphics* graphics, const CRenderList& list, float scaling, Gdiplus::Font* font);
+    void setAntialias(void);
+    void recordDirty(const CRenderList& list, float scaling, int width, int height);
 
 public:
     CViewGDI(HWND hWnd);
     ~CViewGDI();
     void initialize(int newXOffset, int newYOffset, int newWidth, int newHeight) override;
     void shutdown(void) override;
-    void DrawAll(
-        IState* state,
-        float fps,
-        float latency) override;
+    void setCourt(const CRenderList& court) override;
+    DrawResult DrawAll(const CRenderList& list) override;
+    void setQuality(RenderQuality quality) override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,393 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Include project header files
+#include "cframebuilder.hpp"
+#include "cviewterminal.hpp"
+#include "winten_constants.hpp"
+
+namespace
+{
+    // UTF-8 encodings of the half-block glyphs
+    const char UPPER_HALF[] = "\xE2\x96\x80";
+    const char LOWER_HALF[] = "\xE2\x96\x84";
+    const char FULL_BLOCK[] = "\xE2\x96\x88";
+    // Colour never drawn, forces a cell or attribute to be rewritten
+    const std::uint32_t COLOUR_NONE = 0;
+
+    /// <summary>
+    ///     Pixel range whose centres lie in [start, end), at least one pixel wide.
+    /// </summary>
+    void pixelSpan(float start, float end, int limit, int& first, int& last)
+    {
+        first = static_cast<int>(std::ceil(start - 0.5f));
+        last = static_cast<int>(std::ceil(end - 0.5f));
+        if (last <= first)
+        {
+            first = static_cast<int>(std::floor((start + end) / 2.0f));
+            last = first + 1;
+        }
+        first = std::max(first, 0);
+        last = std::min(last, limit);
+    }
+}
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="output">Stream the escape sequences are written to.</param>
+CViewTerminal::CViewTerminal(std::FILE* output)
+    : m_output(output)
+    , m_columns(0)
+    , m_rows(0)
+    , m_xOffset(0)
+    , m_yOffset(0)
+    , m_scaling(0)
+    , m_stats()
+    , m_needClear(true)
+    , m_cursorRow(-1)
+    , m_cursorColumn(-1)
+    , m_foreground(COLOUR_NONE)
+    , m_backgroundColour(COLOUR_NONE)
+{
+    CFrameBuilder::buildCourt(m_court);
+}
+
+/// <summary>
+///     Initialize the view.
+/// </summary>
+/// <param name="newXOffset">Margin from left in cells.</param>
+/// <param name="newYOffset">Margin from top in cells.</param>
+/// <param name="newWidth">Width of view in cells.</param>
+/// <param name="newHeight">Height of view in cells.</param>
+void CViewTerminal::initialize(int newXOffset, int newYOffset, int newWidth, int newHeight)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_columns = newWidth;
+    m_rows = newHeight;
+    m_xOffset = newXOffset;
+    m_yOffset = newYOffset;
+    m_scaling = static_cast<float>(m_columns) / winten_constants::W;
+
+    // Pre-render the court background
+    m_background.assign(static_cast<std::size_t>(m_columns) * m_rows * 2, COLOUR_NONE);
+    m_pixels.resize(m_background.size());
+    rasterize(m_background, m_court);
+
+    // Nothing is known to be on screen
+    TerminalCell blank = { COLOUR_NONE, COLOUR_NONE, 0 };
+    m_screen.assign(static_cast<std::size_t>(m_columns) * m_rows, blank);
+    m_cells.resize(m_screen.size());
+    m_buffer.reserve(m_screen.size() * 24);
+    m_needClear = true;
+}
+
+/// <summary>
+///     Set the static layout pre-rendered behind every frame.
+/// </summary>
+/// <param name="court">Layout to draw from the next initialize.</param>
+void CViewTerminal::setCourt(const CRenderList& court)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    m_court = court;
+}
+
+/// <summary>
+///     Shutdown the view, restoring the terminal's attributes and cursor.
+/// </summary>
+void CViewTerminal::shutdown(void)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    if (m_columns <= 0)
+        return;
+    std::fprintf(m_output, "\x1b[0m\x1b[%d;1H\x1b[?25h", m_yOffset + m_rows + 1);
+    std::fflush(m_output);
+    m_cursorRow = -1;
+    m_foreground = COLOUR_NONE;
+    m_backgroundColour = COLOUR_NONE;
+}
+
+/// <summary>
+///     Fill one rectangle, or the ellipse inscribed in it, into a pixel buffer.
+/// </summary>
+void CViewTerminal::fillShape(
+    std::vector<std::uint32_t>& pixels,
+    bool ellipse,
+    float x,
+    float y,
+    float width,
+    float height,
+    std::uint32_t colour)
+{
+    const int columns = m_columns;
+    int x0, x1, y0, y1;
+
+    pixelSpan(x * m_scaling, (x + width) * m_scaling, columns, x0, x1);
+    pixelSpan(y * m_scaling, (y + height) * m_scaling, m_rows * 2, y0, y1);
+
+    // Spans are clamped at each end on their own, so a shape wholly off the
+    // grid leaves an empty or reversed span
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    if (!ellipse)
+    {
+        for (int row = y0; row < y1; row++)
+            std::fill(&pixels[row * columns + x0], &pixels[row * columns + x1], colour);
+        return;
+    }
+
+    // Pixel centres inside the ellipse, or the centre pixel if it is sub-pixel
+    float cx = (x + width / 2.0f) * m_scaling;
+    float cy = (y + height / 2.0f) * m_scaling;
+    float rx = std::max(width / 2.0f * m_scaling, 0.5f);
+    float ry = std::max(height / 2.0f * m_scaling, 0.5f);
+    for (int row = y0; row < y1; row++)
+    {
+        for (int column = x0; column < x1; column++)
+        {
+            float dx = (column + 0.5f - cx) / rx;
+            float dy = (row + 0.5f - cy) / ry;
+            if (dx * dx + dy * dy <= 1.0f)
+                pixels[row * columns + column] = colour;
+        }
+    }
+}
+
+/// <summary>
+///     Fill the shapes of a render list into a pixel buffer. Text is drawn
+///     later as character cells.
+/// </summary>
+/// <param name="pixels">Buffer of two pixel rows per cell row.</param>
+/// <param name="list">Commands to draw.</param>
+void CViewTerminal::rasterize(std::vector<std::uint32_t>& pixels, const CRenderList& list)
+{
+    for (const RenderCommand& command : list.commands())
+    {
+        switch (command.type)
+        {
+        case RENDER_FILL_RECT:
+        case RENDER_FILL_ELLIPSE:
+            fillShape(
+                pixels,
+                command.type == RENDER_FILL_ELLIPSE,
+                command.x,
+                command.y,
+                command.width,
+                command.height,
+                command.colour);
+            break;
+        case RENDER_FILL_RECTS:
+        case RENDER_FILL_ELLIPSES:
+        {
+            const RenderInstance* positions = list.instances(command);
+            for (int index = 0; index < command.instanceCount; index++)
+                fillShape(
+                    pixels,
+                    command.type == RENDER_FILL_ELLIPSES,
+                    positions[index].x,
+                    positions[index].y,
+                    command.width,
+                    command.height,
+                    command.colour);
+            break;
+        }
+        case RENDER_TEXT:
+            break;
+        }
+    }
+}
+
+/// <summary>
+///     Append an SGR sequence selecting a 24-bit colour.
+/// </summary>
+/// <param name="prefix">"38" for foreground or "48" for background.</param>
+/// <param name="colour">Colour as 0xAARRGGBB.</param>
+void CViewTerminal::emitColour(const char* prefix, std::uint32_t colour)
+{
+    char sequence[32];
+    int length = std::snprintf(
+        sequence,
+        sizeof(sequence),
+        "\x1b[%s;2;%u;%u;%um",
+        prefix,
+        static_cast<unsigned int>((colour >> 16) & 0xFF),
+        static_cast<unsigned int>((colour >> 8) & 0xFF),
+        static_cast<unsigned int>(colour & 0xFF));
+    m_buffer.append(sequence, length);
+}
+
+/// <summary>
+///     Draws all objects in the view, writing only the cells that changed.
+/// </summary>
+/// <param name="list">Frame commands to draw.</param>
+/// <returns>Whether the frame was presented or skipped while resizing.</returns>
+DrawResult CViewTerminal::DrawAll(const CRenderList& list)
+{
+    const int width = m_columns;
+    char sequence[32];
+
+    // Skip the frame while the view is being resized
+    std::unique_lock<std::mutex> lock(m_updateMutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_columns <= 0 || m_rows <= 0)
+        return DRAW_SKIPPED;
+
+    m_buffer.clear();
+    if (m_needClear)
+    {
+        // Clear the screen and hide the cursor
+        m_buffer.append("\x1b[0m\x1b[2J\x1b[?25l");
+        m_cursorRow = -1;
+        m_foreground = COLOUR_NONE;
+        m_backgroundColour = COLOUR_NONE;
+        m_needClear = false;
+    }
+
+    // Shapes over the background
+    m_pixels = m_background;
+    rasterize(m_pixels, list);
+    for (int row = 0; row < m_rows; row++)
+    {
+        for (int column = 0; column < width; column++)
+        {
+            TerminalCell& cell = m_cells[row * width + column];
+            cell.top = m_pixels[(2 * row) * width + column];
+            cell.bottom = m_pixels[(2 * row + 1) * width + column];
+            cell.glyph = 0;
+        }
+    }
+
+    // Text as characters over the cells
+    for (const RenderCommand& command : list.commands())
+    {
+        if (command.type != RENDER_TEXT)
+            continue;
+
+        int startColumn = static_cast<int>(command.x * m_scaling);
+        int column = startColumn;
+        int row = static_cast<int>(command.y * m_scaling / 2.0f);
+        for (char character : list.string(command.textId))
+        {
+            if (character == '\n')
+            {
+                row++;
+                column = startColumn;
+                continue;
+            }
+            if (row >= 0 && row < m_rows && column >= 0 && column < width)
+            {
+                TerminalCell& cell = m_cells[row * width + column];
+                cell.top = command.colour;
+                cell.glyph = character;
+            }
+            column++;
+        }
+    }
+
+    // Emit the difference from what is on screen
+    for (int row = 0; row < m_rows; row++)
+    {
+        for (int column = 0; column < width; column++)
+        {
+            TerminalCell& cell = m_cells[row * width + column];
+            TerminalCell& screen = m_screen[row * width + column];
+            if (!(cell != screen))
+                continue;
+
+            // Move the cursor unless the previous write left it here
+            if (m_cursorRow != row || m_cursorColumn != column)
+            {
+                int length = std::snprintf(
+                    sequence,
+                    sizeof(sequence),
+                    "\x1b[%d;%dH",
+                    m_yOffset + row + 1,
+                    m_xOffset + column + 1);
+                m_buffer.append(sequence, length);
+            }
+
+            if (cell.glyph != 0)
+            {
+                // Text in the top colour over the cell's bottom pixel
+                if (m_foreground != cell.top)
+                    emitColour("38", m_foreground = cell.top);
+                if (m_backgroundColour != cell.bottom)
+                    emitColour("48", m_backgroundColour = cell.bottom);
+                m_buffer.push_back(cell.glyph);
+            }
+            else if (cell.top == cell.bottom)
+            {
+                // Solid cell, using whichever current colour matches
+                if (m_foreground == cell.top)
+                    m_buffer.append(FULL_BLOCK);
+                else
+                {
+                    if (m_backgroundColour != cell.top)
+                        emitColour("48", m_backgroundColour = cell.top);
+                    m_buffer.push_back(' ');
+                }
+            }
+            else if (m_foreground == cell.bottom || m_backgroundColour == cell.top)
+            {
+                // Lower half block avoids a colour change
+                if (m_foreground != cell.bottom)
+                    emitColour("38", m_foreground = cell.bottom);
+                if (m_backgroundColour != cell.top)
+                    emitColour("48", m_backgroundColour = cell.top);
+                m_buffer.append(LOWER_HALF);
+            }
+            else
+            {
+                if (m_foreground != cell.top)
+                    emitColour("38", m_foreground = cell.top);
+                if (m_backgroundColour != cell.bottom)
+                    emitColour("48", m_backgroundColour = cell.bottom);
+                m_buffer.append(UPPER_HALF);
+            }
+
+            screen = cell;
+            m_cursorRow = row;
+            m_cursorColumn = column + 1;
+        }
+    }
+
+    m_stats.frames++;
+    m_stats.bytes += m_buffer.size();
+    m_stats.maxBytes = std::max<std::uint64_t>(m_stats.maxBytes, m_buffer.size());
+    if (!m_buffer.empty())
+    {
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_output);
+        std::fflush(m_output);
+    }
+    return DRAW_PRESENTED;
+}
+
+/// <summary>
+///     Get the output written so far.
+/// </summary>
+/// <returns>The statistics.</returns>
+TerminalStats CViewTerminal::getStats(void)
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+    return m_stats;
+}
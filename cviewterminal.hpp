@@ -0,0 +1,113 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_CVIEWTERMINAL_HPP
+#define WINTEN_CVIEWTERMINAL_HPP
+
+// Include external header files
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "iview.hpp"
+#include "renderlist.hpp"
+
+/// <summary>
+///     A character cell made of two vertically stacked pixels, or a text glyph.
+/// </summary>
+struct TerminalCell
+{
+    std::uint32_t top;
+    std::uint32_t bottom;
+    // Text character drawn over the cell, zero for a half-block cell
+    char glyph;
+
+    bool operator !=(TerminalCell const& other) const
+    {
+        return top != other.top || bottom != other.bottom || glyph != other.glyph;
+    }
+};
+
+/// <summary>
+///     Output written by the terminal view.
+/// </summary>
+struct TerminalStats
+{
+    std::uint64_t frames;
+    std::uint64_t bytes;
+    // Largest single frame, usually the first after a clear
+    std::uint64_t maxBytes;
+
+    TerminalStats(void)
+        : frames(0)
+        , bytes(0)
+        , maxBytes(0) {}
+
+    double bytesPerFrame(void) const
+    {
+        return frames > 0 ? static_cast<double>(bytes) / frames : 0.0;
+    }
+};
+
+/// <summary>
+///     Class implements an ANSI terminal view using half-block characters.
+///     Each frame is diffed against the previous one and only changed cells
+///     are written, keeping output small enough for slow links.
+/// </summary>
+class CViewTerminal : public IView
+{
+private:
+    std::FILE* m_output;
+    // Viewport in character cells, two pixels per cell vertically
+    int m_columns;
+    int m_rows;
+    int m_xOffset;
+    int m_yOffset;
+    float m_scaling;
+    // Static layout and the pixel buffers of it and the current frame
+    CRenderList m_court;
+    std::vector<std::uint32_t> m_background;
+    std::vector<std::uint32_t> m_pixels;
+    // Cells on screen and cells for this frame
+    std::vector<TerminalCell> m_screen;
+    std::vector<TerminalCell> m_cells;
+    // Escape sequence output for this frame
+    std::string m_buffer;
+    TerminalStats m_stats;
+    bool m_needClear;
+    // Terminal state left by the last write
+    int m_cursorRow;
+    int m_cursorColumn;
+    std::uint32_t m_foreground;
+    std::uint32_t m_backgroundColour;
+    std::mutex m_updateMutex;
+
+    void fillShape(std::vector<std::uint32_t>& pixels, bool ellipse, float x, float y, float width, float height, std::uint32_t colour);
+    void rasterize(std::vector<std::uint32_t>& pixels, const CRenderList& list);
+    void emitColour(const char* prefix, std::uint32_t colour);
+
+public:
+    CViewTerminal(std::FILE* output);
+    void initialize(int newXOffset, int newYOffset, int newWidth, int newHeight) override;
+    void shutdown(void) override;
+    void setCourt(const CRenderList& court) override;
+    DrawResult DrawAll(const CRenderList& list) override;
+    TerminalStats getStats(void);
+};
+
+#endif
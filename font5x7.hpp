@@ -0,0 +1,108 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_FONT5X7_HPP
+#define WINTEN_FONT5X7_HPP
+
+/// <summary>
+///     Bitmap font for software rendering. Each glyph is seven rows of five
+///     pixels, most significant of the low five bits leftmost.
+/// </summary>
+namespace font5x7 {
+    const int GLYPH_WIDTH = 5;
+    const int GLYPH_HEIGHT = 7;
+    // Horizontal advance and font size in font pixels, including spacing
+    const int ADVANCE = 6;
+    const int EM_HEIGHT = 10;
+    // Range of characters with glyphs
+    const char FIRST = ' ';
+    const char LAST = 'Z';
+
+    const unsigned char GLYPHS[LAST - FIRST + 1][GLYPH_HEIGHT] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // "
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // #
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // $
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // &
+        { 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+        { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+        { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // *
+        { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+        { 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x08 }, // ,
+        { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06 }, // .
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+        { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+        { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+        { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+        { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+        { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+        { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+        { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+        { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // ;
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // <
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // =
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // >
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+        { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F }, // @
+        { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // A
+        { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+        { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+        { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+        { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+        { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+        { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+        { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+        { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+        { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+        { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+        { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+        { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+        { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+        { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+        { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 }, // Y
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+    };
+
+    /// <summary>
+    ///     Get the rows of a character's glyph, lower case drawn as upper case.
+    /// </summary>
+    inline const unsigned char* glyph(char character)
+    {
+        if (character >= 'a' && character <= 'z')
+            character = static_cast<char>(character - 'a' + 'A');
+        if (character < FIRST || character > LAST)
+            character = '?';
+        return GLYPHS[character - FIRST];
+    }
+}
+
+#endif
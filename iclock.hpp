@@ -0,0 +1,33 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_ICLOCK_HPP
+#define WINTEN_ICLOCK_HPP
+
+// Include external header files
+#include <cstdint>
+
+/// <summary>
+///     Interface class for a monotonic clock counting integer nanoseconds.
+/// </summary>
+class IClock
+{
+public:
+    virtual ~IClock() {}
+    // Current time in nanoseconds from an arbitrary fixed origin
+    virtual std::int64_t now(void) = 0;
+};
+
+#endif
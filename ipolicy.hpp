@@ -0,0 +1,69 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_IPOLICY_HPP
+#define WINTEN_IPOLICY_HPP
+
+/// <summary>
+///     Moves available to a paddle each decision.
+/// </summary>
+enum PolicyAction
+{
+    ACTION_STAY,
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_COUNT
+};
+
+/// <summary>
+///     What a paddle sees, relative to itself so that one policy plays from
+///     either end of the court. Every feature is roughly within -1 to 1.
+/// </summary>
+struct Observation
+{
+    // Horizontal distance to the nearest ball as a fraction of the court width
+    float distance;
+    // Ball height above (negative) or below the paddle centre, per court height
+    float offset;
+    // Vertical component of the ball's direction of travel
+    float vertical;
+    // 1 if the ball is travelling towards the paddle, otherwise 0
+    float approaching;
+    // Paddle height in the court, 0 at the top and 1 at the bottom
+    float height;
+};
+
+/// <summary>
+///     Interface class for a learned paddle controller.
+/// </summary>
+class IPolicy
+{
+public:
+    virtual ~IPolicy() {}
+    // Choose a move for an observation
+    virtual PolicyAction act(const Observation& observation) const = 0;
+
+    /// <summary>
+    ///     Choose moves for many observations at once, which policies that
+    ///     can evaluate several together override.
+    /// </summary>
+    virtual void actBatch(const Observation* observations, int count, PolicyAction* actions) const
+    {
+        for (int index = 0; index < count; index++)
+            actions[index] = act(observations[index]);
+    }
+};
+
+#endif
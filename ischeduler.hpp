@@ -0,0 +1,68 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_ISCHEDULER_HPP
+#define WINTEN_ISCHEDULER_HPP
+
+// Include external header files
+#include <cstdint>
+
+/// <summary>
+///     Wake-up accuracy statistics of a frame scheduler.
+/// </summary>
+struct SchedulerStats
+{
+    // Number of deadlines waited on
+    std::uint64_t wakeups;
+    // Number of whole periods skipped because a deadline was overrun
+    std::uint64_t missed;
+    // Wake-up error in nanoseconds (time woken after the deadline)
+    std::int64_t lastError;
+    std::int64_t maxError;
+    std::int64_t totalError;
+
+    SchedulerStats(void)
+        : wakeups(0)
+        , missed(0)
+        , lastError(0)
+        , maxError(0)
+        , totalError(0) {}
+
+    /// <summary>
+    ///     Mean wake-up error in nanoseconds.
+    /// </summary>
+    std::int64_t meanError(void) const
+    {
+        return wakeups > 0 ? totalError / static_cast<std::int64_t>(wakeups) : 0;
+    }
+};
+
+/// <summary>
+///     Interface class for the periodic frame scheduler driving the game loop.
+/// </summary>
+class IScheduler
+{
+public:
+    virtual ~IScheduler() {}
+    // Set the target frame rate in hertz
+    virtual void setRate(float rate) = 0;
+    // Restart the deadline sequence from the current time
+    virtual void reset(void) = 0;
+    // Block until the next deadline
+    virtual void wait(void) = 0;
+    virtual SchedulerStats getStats(void) const = 0;
+};
+
+#endif
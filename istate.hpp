@@ -17,35 +17,38 @@
 #define WINTEN_ISTATE_HPP
 
 // Include external header files
+#include <cstdint>
 #include <memory>
-#include <string>
 
 // Include project header files
-#include "vector2d.hpp"
+#include "cregistry.hpp"
 
 /// <summary>
-///		Defines the state interface for the state pattern.
+///		Defines the state interface for the state pattern. Each state is a
+///		configuration of the entities in its registry and the systems run on them.
 /// </summary>
 class IState
 {
 public:
-	vector2d<float> player;
-	vector2d<float> npc;
-	vector2d<float> ball;
-	std::string message;
-	int scorePlayer;
-	int scoreNpc;
-
-	IState(void)
-		: scorePlayer(0)
-		, scoreNpc(0) {}
+	CRegistry world;
 
+	virtual ~IState() {}
 	virtual std::unique_ptr<IState> update(
-		float deltaT,
+		std::int64_t deltaT,
 		bool keyUp,
 		bool keyDown,
 		bool keyEscape,
 		bool keyPressed) = 0;
+
+	/// <summary>
+	///		Clock ticks after its last update until the state next needs one if
+	///		no key is pressed, or zero if it needs every tick. A host may let a
+	///		state with a timeout sleep until then.
+	/// </summary>
+	virtual std::int64_t timeout(void) const
+	{
+		return 0;
+	}
 };
 
 #endif
\ No newline at end of file
@@ -17,7 +17,38 @@
 #define WINTEN_IVIEW_HPP
 
 // Include project header files
-#include "istate.hpp"
+#include "renderlist.hpp"
+
+/// <summary>
+///		Rendering quality from best to cheapest, each level keeping the
+///		reductions of those above it.
+/// </summary>
+enum RenderQuality
+{
+	QUALITY_FULL,
+	// No frame rate and latency text
+	QUALITY_NO_STATS,
+	// Shapes and text drawn without anti-aliasing
+	QUALITY_NO_ANTIALIAS,
+	// Drawn at half resolution and scaled up
+	QUALITY_HALF_RESOLUTION,
+	// Background restored only where the last frame drew
+	QUALITY_DIRTY_REGIONS,
+	QUALITY_LEVEL_COUNT
+};
+
+/// <summary>
+///		What became of a frame passed to the view.
+/// </summary>
+enum DrawResult
+{
+	// Drawn and shown
+	DRAW_PRESENTED,
+	// Drawn but its output could not keep up, as when every capture buffer is busy
+	DRAW_DROPPED,
+	// Not drawn as the view has no size or is being resized
+	DRAW_SKIPPED
+};
 
 /// <summary>
 ///		Interface class for the view object.
@@ -25,16 +56,26 @@
 class IView
 {
 public:
-	virtual void DrawAll(
-		IState* state,
-		float fps,
-		float latency) = 0;
+	virtual ~IView() {}
+	virtual DrawResult DrawAll(const CRenderList& list) = 0;
 	virtual void initialize(
 		int newXOffset,
 		int newYOffset,
 		int newWidth,
 		int newHeight) = 0;
 	virtual void shutdown(void) = 0;
+	// Set the static layout drawn behind every frame, taking effect on initialize
+	virtual void setCourt(const CRenderList& court) = 0;
+	// True if the view must be drawn on every tick even when the frame is unchanged
+	virtual bool drawsEveryFrame(void) const
+	{
+		return false;
+	}
+	// Trade image quality for drawing time, views ignoring levels they can't apply
+	virtual void setQuality(RenderQuality quality)
+	{
+		(void)quality;
+	}
 };
 
 #endif
\ No newline at end of file
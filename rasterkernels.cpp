@@ -0,0 +1,139 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Include project header files
+#include "rasterkernels.hpp"
+
+namespace
+{
+    /// <summary>
+    ///     Set a span of pixels to a colour.
+    /// </summary>
+    void fillSpanScalar(std::uint32_t* pixels, int count, std::uint32_t colour)
+    {
+        std::fill(pixels, pixels + count, colour);
+    }
+
+    /// <summary>
+    ///     Blend one row of an anti-aliased circle.
+    /// </summary>
+    void circleSpanScalar(std::uint32_t* pixels, int count, float dx0, float dy2, float radius, std::uint32_t colour)
+    {
+        for (int index = 0; index < count; index++)
+        {
+            float dx = dx0 + static_cast<float>(index);
+            std::uint32_t alpha = raster_kernels::circleAlpha(dx * dx + dy2, radius);
+
+            if (alpha == 256)
+                pixels[index] = colour;
+            else if (alpha > 0)
+                pixels[index] = raster_kernels::blend(pixels[index], colour, alpha);
+        }
+    }
+
+    /// <summary>
+    ///     Blend a colour through a coverage mask.
+    /// </summary>
+    void maskSpanScalar(std::uint32_t* pixels, const std::uint8_t* mask, int count, std::uint32_t colour)
+    {
+        for (int index = 0; index < count; index++)
+        {
+            std::uint32_t coverage = mask[index];
+
+            // Map 255 to 256 so full coverage gives the colour exactly
+            if (coverage > 0)
+                pixels[index] = raster_kernels::blend(pixels[index], colour, coverage + (coverage >> 7));
+        }
+    }
+}
+
+namespace raster_kernels {
+    const RasterKernels SCALAR = { "scalar", fillSpanScalar, circleSpanScalar, maskSpanScalar };
+
+#if WINTEN_RASTER_X86
+    /// <summary>
+    ///     Test whether the processor and operating system support a variant.
+    /// </summary>
+    bool cpuSupportsSSE2(void)
+    {
+#if defined(_M_X64) || defined(__x86_64__)
+        // Part of the x86-64 baseline
+        return true;
+#elif defined(_MSC_VER)
+        int registers[4];
+        __cpuid(registers, 1);
+        return (registers[3] & (1 << 26)) != 0;
+#else
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool cpuSupportsAVX2(void)
+    {
+#if defined(_MSC_VER)
+        int registers[4];
+
+        // The OS must save the YMM registers as well as the CPU having AVX2
+        __cpuid(registers, 0);
+        if (registers[0] < 7)
+            return false;
+        __cpuid(registers, 1);
+        if ((registers[2] & (1 << 27)) == 0 || (registers[2] & (1 << 28)) == 0)
+            return false;
+        if ((_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(registers, 7, 0);
+        return (registers[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    /// <summary>
+    ///     Get every variant the processor supports.
+    /// </summary>
+    /// <returns>Variants ordered slowest first.</returns>
+    std::vector<const RasterKernels*> supported(void)
+    {
+        std::vector<const RasterKernels*> variants;
+
+        variants.push_back(&SCALAR);
+#if WINTEN_RASTER_X86
+        if (cpuSupportsSSE2())
+            variants.push_back(&SSE2);
+        if (cpuSupportsAVX2())
+            variants.push_back(&AVX2);
+#endif
+        return variants;
+    }
+
+    /// <summary>
+    ///     Get the fastest variant the processor supports.
+    /// </summary>
+    /// <returns>The kernels, selected on first use.</returns>
+    const RasterKernels& selected(void)
+    {
+        static const RasterKernels* kernels = supported().back();
+        return *kernels;
+    }
+}
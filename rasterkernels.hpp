@@ -0,0 +1,104 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_RASTERKERNELS_HPP
+#define WINTEN_RASTERKERNELS_HPP
+
+// Include external header files
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Kernels for x86 instruction set extensions are built when targeting x86
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WINTEN_RASTER_X86 1
+#else
+#define WINTEN_RASTER_X86 0
+#endif
+
+// Allow AVX2 intrinsics in individual functions without building the file for AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define WINTEN_TARGET_AVX2 __attribute__((target("avx2")))
+#define WINTEN_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define WINTEN_TARGET_AVX2
+#define WINTEN_TARGET_SSE2
+#endif
+
+/// <summary>
+///     Software rasterization span kernels operating on 0xXXRRGGBB pixels.
+///     Every variant produces bit-identical output.
+/// </summary>
+struct RasterKernels
+{
+    const char* name;
+
+    // Set count pixels to an opaque colour
+    void (*fillSpan)(std::uint32_t* pixels, int count, std::uint32_t colour);
+
+    // Blend an anti-aliased circle row: pixel i has horizontal distance
+    // dx0 + i from the centre, dy2 is the squared vertical distance and
+    // coverage is the clamped overlap of the pixel with the radius
+    void (*circleSpan)(std::uint32_t* pixels, int count, float dx0, float dy2, float radius, std::uint32_t colour);
+
+    // Blend a colour through an 8-bit coverage mask
+    void (*maskSpan)(std::uint32_t* pixels, const std::uint8_t* mask, int count, std::uint32_t colour);
+};
+
+namespace raster_kernels {
+    // Variants compiled into this build, whether or not this CPU runs them
+    extern const RasterKernels SCALAR;
+#if WINTEN_RASTER_X86
+    extern const RasterKernels SSE2;
+    extern const RasterKernels AVX2;
+#endif
+
+#if WINTEN_RASTER_X86
+    // Instruction sets the processor and operating system support, shared
+    // with other kernels choosing variants at runtime
+    bool cpuSupportsSSE2(void);
+    bool cpuSupportsAVX2(void);
+#endif
+
+    // Fastest variant this CPU supports, detected once
+    const RasterKernels& selected(void);
+    // All variants this CPU supports, slowest first
+    std::vector<const RasterKernels*> supported(void);
+
+    /// <summary>
+    ///     Blend a colour over a pixel, all four channels, alpha in [0, 256].
+    ///     Alpha 0 leaves the pixel and 256 gives the colour exactly.
+    /// </summary>
+    inline std::uint32_t blend(std::uint32_t pixel, std::uint32_t colour, std::uint32_t alpha)
+    {
+        std::uint32_t inverse = 256 - alpha;
+        std::uint32_t rb = ((colour & 0x00FF00FF) * alpha + (pixel & 0x00FF00FF) * inverse) >> 8;
+        std::uint32_t ag = ((colour >> 8) & 0x00FF00FF) * alpha + ((pixel >> 8) & 0x00FF00FF) * inverse;
+        return (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+    }
+
+    /// <summary>
+    ///     Alpha in [0, 256] of a pixel at a squared distance from a circle's
+    ///     centre, from the approximate overlap of the pixel and the circle.
+    /// </summary>
+    inline std::uint32_t circleAlpha(float distanceSquared, float radius)
+    {
+        float coverage = radius + 0.5f - std::sqrt(distanceSquared);
+        coverage = coverage < 0.0f ? 0.0f : (coverage > 1.0f ? 1.0f : coverage);
+        return static_cast<std::uint32_t>(coverage * 256.0f + 0.5f);
+    }
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "rasterkernels.hpp"
+
+#if WINTEN_RASTER_X86
+
+// Include external header files
+#include <immintrin.h>
+
+namespace
+{
+    /// <summary>
+    ///     Blend a colour over eight pixels with per-pixel alpha in [0, 256],
+    ///     matching raster_kernels::blend. Each product fits 16 bits.
+    /// </summary>
+    WINTEN_TARGET_AVX2 inline __m256i blend8(__m256i pixels, __m256i colour, __m256i alpha)
+    {
+        const __m256i maskRB = _mm256_set1_epi32(0x00FF00FF);
+        const __m256i maskAG = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+        // Alpha in both 16-bit halves of each pixel
+        __m256i alpha16 = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+        __m256i inverse16 = _mm256_sub_epi16(_mm256_set1_epi16(256), alpha16);
+
+        __m256i rb = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_and_si256(colour, maskRB), alpha16),
+            _mm256_mullo_epi16(_mm256_and_si256(pixels, maskRB), inverse16));
+        __m256i ag = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_srli_epi16(colour, 8), alpha16),
+            _mm256_mullo_epi16(_mm256_srli_epi16(pixels, 8), inverse16));
+        return _mm256_or_si256(_mm256_srli_epi16(rb, 8), _mm256_and_si256(ag, maskAG));
+    }
+
+    WINTEN_TARGET_AVX2 void fillSpanAVX2(std::uint32_t* pixels, int count, std::uint32_t colour)
+    {
+        __m256i fill = _mm256_set1_epi32(static_cast<int>(colour));
+        int index = 0;
+
+        for (; index + 8 <= count; index += 8)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + index), fill);
+        for (; index < count; index++)
+            pixels[index] = colour;
+    }
+
+    WINTEN_TARGET_AVX2 void circleSpanAVX2(std::uint32_t* pixels, int count, float dx0, float dy2, float radius, std::uint32_t colour)
+    {
+        __m256i fill = _mm256_set1_epi32(static_cast<int>(colour));
+        __m256 start = _mm256_set1_ps(dx0);
+        __m256 distance2 = _mm256_set1_ps(dy2);
+        __m256 edge = _mm256_set1_ps(radius + 0.5f);
+        __m256 zero = _mm256_setzero_ps();
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 scale = _mm256_set1_ps(256.0f);
+        __m256 half = _mm256_set1_ps(0.5f);
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        int index = 0;
+
+        for (; index + 8 <= count; index += 8)
+        {
+            // Separate multiply and add, not FMA, for rounding identical to scalar
+            __m256 dx = _mm256_add_ps(start, _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(index), lanes)));
+            __m256 coverage = _mm256_sub_ps(edge, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), distance2)));
+            coverage = _mm256_min_ps(_mm256_max_ps(coverage, zero), one);
+            __m256i alpha = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(coverage, scale), half));
+
+            // Skip groups entirely outside the circle
+            if (_mm256_testz_si256(alpha, alpha))
+                continue;
+            __m256i* target = reinterpret_cast<__m256i*>(pixels + index);
+            _mm256_storeu_si256(target, blend8(_mm256_loadu_si256(target), fill, alpha));
+        }
+        if (index < count)
+            raster_kernels::SCALAR.circleSpan(pixels + index, count - index, dx0 + static_cast<float>(index), dy2, radius, colour);
+    }
+
+    WINTEN_TARGET_AVX2 void maskSpanAVX2(std::uint32_t* pixels, const std::uint8_t* mask, int count, std::uint32_t colour)
+    {
+        __m256i fill = _mm256_set1_epi32(static_cast<int>(colour));
+        int index = 0;
+
+        for (; index + 8 <= count; index += 8)
+        {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + index));
+            if (_mm_testz_si128(bytes, bytes))
+                continue;
+
+            // Widen eight coverage bytes to 32 bits and map 255 to 256
+            __m256i alpha = _mm256_cvtepu8_epi32(bytes);
+            alpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(alpha, 7));
+            __m256i* target = reinterpret_cast<__m256i*>(pixels + index);
+            _mm256_storeu_si256(target, blend8(_mm256_loadu_si256(target), fill, alpha));
+        }
+        if (index < count)
+            raster_kernels::SCALAR.maskSpan(pixels + index, mask + index, count - index, colour);
+    }
+}
+
+namespace raster_kernels {
+    const RasterKernels AVX2 = { "avx2", fillSpanAVX2, circleSpanAVX2, maskSpanAVX2 };
+}
+
+#endif
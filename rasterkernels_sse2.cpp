@@ -0,0 +1,118 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include project header files
+#include "rasterkernels.hpp"
+
+#if WINTEN_RASTER_X86
+
+// Include external header files
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+    /// <summary>
+    ///     Blend a colour over four pixels with per-pixel alpha in [0, 256],
+    ///     matching raster_kernels::blend. Each product fits 16 bits.
+    /// </summary>
+    WINTEN_TARGET_SSE2 inline __m128i blend4(__m128i pixels, __m128i colour, __m128i alpha)
+    {
+        const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+        const __m128i maskAG = _mm_set1_epi32(0xFF00FF00);
+        // Alpha in both 16-bit halves of each pixel
+        __m128i alpha16 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+        __m128i inverse16 = _mm_sub_epi16(_mm_set1_epi16(256), alpha16);
+
+        __m128i rb = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_and_si128(colour, maskRB), alpha16),
+            _mm_mullo_epi16(_mm_and_si128(pixels, maskRB), inverse16));
+        __m128i ag = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_srli_epi16(colour, 8), alpha16),
+            _mm_mullo_epi16(_mm_srli_epi16(pixels, 8), inverse16));
+        return _mm_or_si128(_mm_srli_epi16(rb, 8), _mm_and_si128(ag, maskAG));
+    }
+
+    WINTEN_TARGET_SSE2 void fillSpanSSE2(std::uint32_t* pixels, int count, std::uint32_t colour)
+    {
+        __m128i fill = _mm_set1_epi32(static_cast<int>(colour));
+        int index = 0;
+
+        for (; index + 4 <= count; index += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + index), fill);
+        for (; index < count; index++)
+            pixels[index] = colour;
+    }
+
+    WINTEN_TARGET_SSE2 void circleSpanSSE2(std::uint32_t* pixels, int count, float dx0, float dy2, float radius, std::uint32_t colour)
+    {
+        __m128i fill = _mm_set1_epi32(static_cast<int>(colour));
+        __m128 start = _mm_set1_ps(dx0);
+        __m128 distance2 = _mm_set1_ps(dy2);
+        __m128 edge = _mm_set1_ps(radius + 0.5f);
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 scale = _mm_set1_ps(256.0f);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+        int index = 0;
+
+        for (; index + 4 <= count; index += 4)
+        {
+            // Same operation order as the scalar kernel for identical rounding
+            __m128 dx = _mm_add_ps(start, _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(index), lanes)));
+            __m128 coverage = _mm_sub_ps(edge, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), distance2)));
+            coverage = _mm_min_ps(_mm_max_ps(coverage, zero), one);
+            __m128i alpha = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, scale), half));
+
+            // Skip groups entirely outside the circle
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xFFFF)
+                continue;
+            __m128i* target = reinterpret_cast<__m128i*>(pixels + index);
+            _mm_storeu_si128(target, blend4(_mm_loadu_si128(target), fill, alpha));
+        }
+        if (index < count)
+            raster_kernels::SCALAR.circleSpan(pixels + index, count - index, dx0 + static_cast<float>(index), dy2, radius, colour);
+    }
+
+    WINTEN_TARGET_SSE2 void maskSpanSSE2(std::uint32_t* pixels, const std::uint8_t* mask, int count, std::uint32_t colour)
+    {
+        __m128i fill = _mm_set1_epi32(static_cast<int>(colour));
+        int index = 0;
+
+        for (; index + 4 <= count; index += 4)
+        {
+            std::uint32_t packed;
+            std::memcpy(&packed, mask + index, sizeof(packed));
+            if (packed == 0)
+                continue;
+
+            // Widen four coverage bytes to 32 bits and map 255 to 256
+            __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(packed));
+            __m128i alpha = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_setzero_si128());
+            alpha = _mm_add_epi32(alpha, _mm_srli_epi32(alpha, 7));
+            __m128i* target = reinterpret_cast<__m128i*>(pixels + index);
+            _mm_storeu_si128(target, blend4(_mm_loadu_si128(target), fill, alpha));
+        }
+        if (index < count)
+            raster_kernels::SCALAR.maskSpan(pixels + index, mask + index, count - index, colour);
+    }
+}
+
+namespace raster_kernels {
+    const RasterKernels SSE2 = { "sse2", fillSpanSSE2, circleSpanSSE2, maskSpanSSE2 };
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <cstring>
+
+// Include project header files
+#include "renderlist.hpp"
+
+/// <summary>
+///     Remove all commands, retaining capacity and the string table.
+/// </summary>
+void CRenderList::clear(void)
+{
+    m_commands.clear();
+    m_instances.clear();
+}
+
+/// <summary>
+///     Append a filled rectangle.
+/// </summary>
+/// <param name="x">Left edge.</param>
+/// <param name="y">Top edge.</param>
+/// <param name="width">Width.</param>
+/// <param name="height">Height.</param>
+/// <param name="colour">Fill colour.</param>
+void CRenderList::fillRect(float x, float y, float width, float height, std::uint32_t colour)
+{
+    RenderCommand command = { RENDER_FILL_RECT, colour, x, y, width, height, -1, 0, 0 };
+    m_commands.push_back(command);
+}
+
+/// <summary>
+///     Append a filled ellipse inscribed in a rectangle.
+/// </summary>
+/// <param name="x">Left edge.</param>
+/// <param name="y">Top edge.</param>
+/// <param name="width">Width.</param>
+/// <param name="height">Height.</param>
+/// <param name="colour">Fill colour.</param>
+void CRenderList::fillEllipse(float x, float y, float width, float height, std::uint32_t colour)
+{
+    RenderCommand command = { RENDER_FILL_ELLIPSE, colour, x, y, width, height, -1, 0, 0 };
+    m_commands.push_back(command);
+}
+
+/// <summary>
+///     Append a text run referencing the string table.
+/// </summary>
+/// <param name="textId">String table index.</param>
+/// <param name="x">Left of text.</param>
+/// <param name="y">Top of text.</param>
+/// <param name="size">Font size.</param>
+/// <param name="colour">Text colour.</param>
+void CRenderList::text(int textId, float x, float y, float size, std::uint32_t colour)
+{
+    RenderCommand command = { RENDER_TEXT, colour, x, y, 0.0f, size, textId, 0, 0 };
+    m_commands.push_back(command);
+}
+
+/// <summary>
+///     Append a filled rectangle at each of a set of positions.
+/// </summary>
+/// <param name="positions">Top left corner of each rectangle.</param>
+/// <param name="count">Number of rectangles.</param>
+/// <param name="width">Width.</param>
+/// <param name="height">Height.</param>
+/// <param name="colour">Fill colour.</param>
+void CRenderList::fillRects(const RenderInstance* positions, int count, float width, float height, std::uint32_t colour)
+{
+    RenderCommand command = {
+        RENDER_FILL_RECTS, colour, 0.0f, 0.0f, width, height, -1, static_cast<int>(m_instances.size()), count };
+    m_instances.insert(m_instances.end(), positions, positions + count);
+    m_commands.push_back(command);
+}
+
+/// <summary>
+///     Append a filled ellipse inscribed in a rectangle at each of a set of positions.
+/// </summary>
+/// <param name="positions">Top left corner of each ellipse's rectangle.</param>
+/// <param name="count">Number of ellipses.</param>
+/// <param name="width">Width.</param>
+/// <param name="height">Height.</param>
+/// <param name="colour">Fill colour.</param>
+void CRenderList::fillEllipses(const RenderInstance* positions, int count, float width, float height, std::uint32_t colour)
+{
+    RenderCommand command = {
+        RENDER_FILL_ELLIPSES, colour, 0.0f, 0.0f, width, height, -1, static_cast<int>(m_instances.size()), count };
+    m_instances.insert(m_instances.end(), positions, positions + count);
+    m_commands.push_back(command);
+}
+
+/// <summary>
+///     Set a string table entry, bumping its revision only if the text changed.
+/// </summary>
+/// <param name="textId">String table index.</param>
+/// <param name="text">New text.</param>
+void CRenderList::setString(int textId, const char* text)
+{
+    if (textId >= static_cast<int>(m_strings.size()))
+    {
+        m_strings.resize(textId + 1);
+        m_revisions.resize(textId + 1, 0);
+    }
+    if (std::strcmp(m_strings[textId].c_str(), text) != 0)
+    {
+        m_strings[textId].assign(text);
+        m_revisions[textId]++;
+    }
+}
@@ -0,0 +1,157 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_RENDERLIST_HPP
+#define WINTEN_RENDERLIST_HPP
+
+// Include external header files
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+///     Kinds of primitive in a render list.
+/// </summary>
+enum RenderCommandType : std::uint8_t
+{
+    RENDER_FILL_RECT,
+    RENDER_FILL_ELLIPSE,
+    RENDER_TEXT,
+    // One shape drawn at each of a run of instance positions
+    RENDER_FILL_RECTS,
+    RENDER_FILL_ELLIPSES
+};
+
+/// <summary>
+///     Top left corner of one instance of an instanced shape.
+/// </summary>
+struct RenderInstance
+{
+    float x;
+    float y;
+
+    bool operator ==(RenderInstance const& other) const
+    {
+        return x == other.x && y == other.y;
+    }
+};
+
+/// <summary>
+///     A single drawing primitive in virtual field coordinates.
+/// </summary>
+struct RenderCommand
+{
+    RenderCommandType type;
+    // Colour as 0xAARRGGBB
+    std::uint32_t colour;
+    // Top left corner, or text origin, unused for instanced shapes
+    float x;
+    float y;
+    // Extent of shapes, height is the font size for text
+    float width;
+    float height;
+    // String table index for text, otherwise -1
+    int textId;
+    // Run of instance positions for instanced shapes
+    int instanceFirst;
+    int instanceCount;
+
+    bool operator ==(RenderCommand const& other) const
+    {
+        return type == other.type
+            && colour == other.colour
+            && x == other.x
+            && y == other.y
+            && width == other.width
+            && height == other.height
+            && textId == other.textId
+            && instanceFirst == other.instanceFirst
+            && instanceCount == other.instanceCount;
+    }
+};
+
+/// <summary>
+///     Reusable list of render commands with a string table for text runs.
+///     Clearing keeps allocated capacity and the string table, so steady state
+///     frames do not allocate.
+/// </summary>
+class CRenderList
+{
+private:
+    std::vector<RenderCommand> m_commands;
+    std::vector<RenderInstance> m_instances;
+    std::vector<std::string> m_strings;
+    // Incremented whenever a string changes so consumers can cache conversions
+    std::vector<std::uint32_t> m_revisions;
+
+public:
+    void clear(void);
+    void fillRect(float x, float y, float width, float height, std::uint32_t colour);
+    void fillEllipse(float x, float y, float width, float height, std::uint32_t colour);
+    void text(int textId, float x, float y, float size, std::uint32_t colour);
+    void fillRects(const RenderInstance* positions, int count, float width, float height, std::uint32_t colour);
+    void fillEllipses(const RenderInstance* positions, int count, float width, float height, std::uint32_t colour);
+    void setString(int textId, const char* text);
+
+    /// <summary>
+    ///     Commands in drawing order.
+    /// </summary>
+    const std::vector<RenderCommand>& commands(void) const
+    {
+        return m_commands;
+    }
+
+    /// <summary>
+    ///     Instance positions referenced by instanced commands.
+    /// </summary>
+    const std::vector<RenderInstance>& instances(void) const
+    {
+        return m_instances;
+    }
+
+    /// <summary>
+    ///     Instance positions of an instanced command.
+    /// </summary>
+    const RenderInstance* instances(const RenderCommand& command) const
+    {
+        return m_instances.data() + command.instanceFirst;
+    }
+
+    /// <summary>
+    ///     Text of a string table entry.
+    /// </summary>
+    const std::string& string(int textId) const
+    {
+        return m_strings[textId];
+    }
+
+    /// <summary>
+    ///     Revision of a string table entry.
+    /// </summary>
+    std::uint32_t revision(int textId) const
+    {
+        return m_revisions[textId];
+    }
+
+    /// <summary>
+    ///     Number of string table entries.
+    /// </summary>
+    int stringCount(void) const
+    {
+        return static_cast<int>(m_strings.size());
+    }
+};
+
+#endif
@@ -0,0 +1,614 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+
+// Include project header files
+#include "angletable.hpp"
+#include "systems.hpp"
+#include "tracing.hpp"
+#include "winten_constants.hpp"
+
+namespace systems {
+    namespace
+    {
+        // Policy given to the computer paddles of new matches
+        std::mutex s_npcPolicyMutex;
+        std::shared_ptr<const IPolicy> s_npcPolicy;
+
+        /// <summary>
+        ///     Unit vector of a grid step in the registry's scalar type.
+        /// </summary>
+        inline void heading(int step, float& x, float& y)
+        {
+            const angle_table::Direction& direction = angle_table::direction(step);
+            x = direction.x;
+            y = direction.y;
+        }
+
+        inline void heading(int step, CFixed& x, CFixed& y)
+        {
+            const angle_table::FixedDirection& direction = angle_table::fixedDirection(step);
+            x = direction.x;
+            y = direction.y;
+        }
+
+        /// <summary>
+        ///     Coordinate a fraction of the way between two others, exactly the
+        ///     second at the end.
+        /// </summary>
+        template <typename T>
+        inline float between(T from, T to, float alpha)
+        {
+            if (alpha >= 1.0f)
+                return static_cast<float>(to);
+            return static_cast<float>(from) + (static_cast<float>(to) - static_cast<float>(from)) * alpha;
+        }
+
+        /// <summary>
+        ///     Distance between two coordinates.
+        /// </summary>
+        template <typename T>
+        inline T separation(T a, T b)
+        {
+            return a > b ? a - b : b - a;
+        }
+    }
+
+    /// <summary>
+    ///     Create a paddle at the vertical centre of the field.
+    /// </summary>
+    /// <param name="world">Registry to add to.</param>
+    /// <param name="x">Horizontal centre.</param>
+    /// <param name="controller">What moves the paddle, or nullptr for a fixed paddle.</param>
+    /// <returns>The paddle.</returns>
+    template <typename T>
+    Entity createPaddle(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        const typename CBasicRegistry<T>::Controller* controller)
+    {
+        Entity paddle = world.create();
+        BasicPosition<T> position = { x, T(winten_constants::H / 2.0f) };
+        BasicCollider<T> collider = { COLLIDER_BOX, T(winten_constants::PADDLE_WIDTH), T(winten_constants::PADDLE_HEIGHT) };
+        Render render = {
+            RENDER_SHAPE_RECT,
+            winten_constants::COLOUR_FOREGROUND,
+            winten_constants::PADDLE_WIDTH,
+            winten_constants::PADDLE_HEIGHT };
+
+        world.positions.add(paddle, position);
+        world.colliders.add(paddle, collider);
+        world.renders.add(paddle, render);
+        if (controller != nullptr)
+            world.controllers.add(paddle, *controller);
+        return paddle;
+    }
+
+    /// <summary>
+    ///     Create a ball.
+    /// </summary>
+    /// <param name="world">Registry to add to.</param>
+    /// <param name="x">Horizontal centre.</param>
+    /// <param name="y">Vertical centre.</param>
+    /// <param name="velocity">Initial velocity, or nullptr for a stationary ball.</param>
+    /// <returns>The ball.</returns>
+    template <typename T>
+    Entity createBall(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        const typename CBasicRegistry<T>::Velocity* velocity)
+    {
+        Entity ball = world.create();
+        BasicPosition<T> position = { x, y };
+        BasicCollider<T> collider = { COLLIDER_BALL, T(winten_constants::BALL_DIAMETER), T(winten_constants::BALL_DIAMETER) };
+        Render render = {
+            RENDER_SHAPE_ELLIPSE,
+            winten_constants::COLOUR_FOREGROUND,
+            winten_constants::BALL_DIAMETER,
+            winten_constants::BALL_DIAMETER };
+
+        world.positions.add(ball, position);
+        world.colliders.add(ball, collider);
+        world.renders.add(ball, render);
+        if (velocity != nullptr)
+            world.velocities.add(ball, *velocity);
+        return ball;
+    }
+
+    /// <summary>
+    ///     Create a fixed box which balls bounce off.
+    /// </summary>
+    /// <returns>The obstacle.</returns>
+    template <typename T>
+    Entity createObstacle(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        typename CBasicRegistry<T>::Scalar width,
+        typename CBasicRegistry<T>::Scalar height)
+    {
+        Entity obstacle = world.create();
+        BasicPosition<T> position = { x, y };
+        BasicCollider<T> collider = { COLLIDER_BOX, width, height };
+        Render render = {
+            RENDER_SHAPE_RECT,
+            winten_constants::COLOUR_FOREGROUND,
+            static_cast<float>(width),
+            static_cast<float>(height) };
+
+        world.positions.add(obstacle, position);
+        world.colliders.add(obstacle, collider);
+        world.renders.add(obstacle, render);
+        return obstacle;
+    }
+
+    /// <summary>
+    ///     Create a text element.
+    /// </summary>
+    /// <param name="world">Registry to add to.</param>
+    /// <param name="x">Left of text.</param>
+    /// <param name="y">Top of text.</param>
+    /// <param name="text">Fixed text.</param>
+    /// <param name="scoreSide">Side whose score is shown instead, or -1.</param>
+    /// <returns>The text element.</returns>
+    template <typename T>
+    Entity createText(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        const char* text,
+        int scoreSide)
+    {
+        Entity element = world.create();
+        BasicPosition<T> position = { x, y };
+        Text component = { text, scoreSide, winten_constants::TEXT_SIZE, winten_constants::COLOUR_FOREGROUND };
+
+        world.positions.add(element, position);
+        world.texts.add(element, component);
+        return element;
+    }
+
+    /// <summary>
+    ///     Create the score of each side.
+    /// </summary>
+    template <typename T>
+    void createScores(CBasicRegistry<T>& world)
+    {
+        createText(world, T(winten_constants::SCORE_TEXT_NPC), T(winten_constants::SCORE_TEXT_Y), "", SIDE_LEFT);
+        createText(world, T(winten_constants::SCORE_TEXT_PLAYER), T(winten_constants::SCORE_TEXT_Y), "", SIDE_RIGHT);
+    }
+
+    /// <summary>
+    ///     Set the policy moving the computer paddles of matches created from
+    ///     now on. Running matches keep the policy they started with.
+    /// </summary>
+    /// <param name="policy">Learned policy, or nullptr to track the ball.</param>
+    void setNpcPolicy(std::shared_ptr<const IPolicy> policy)
+    {
+        std::lock_guard<std::mutex> lock(s_npcPolicyMutex);
+        s_npcPolicy = std::move(policy);
+    }
+
+    /// <summary>
+    ///     Get the controller for a computer paddle, giving the registry the
+    ///     current policy if one is set.
+    /// </summary>
+    /// <param name="world">Registry the paddle will belong to.</param>
+    /// <returns>A policy controller, or a tracking controller if no policy is set.</returns>
+    template <typename T>
+    BasicController<T> npcController(CBasicRegistry<T>& world)
+    {
+        std::lock_guard<std::mutex> lock(s_npcPolicyMutex);
+        BasicController<T> result = {
+            s_npcPolicy ? CONTROLLER_POLICY : CONTROLLER_TRACKING,
+            T(winten_constants::PADDLE_SPEED),
+            T(winten_constants::NPC_HORIZON),
+            false,
+            ACTION_STAY };
+
+        world.policy = s_npcPolicy;
+        return result;
+    }
+
+    /// <summary>
+    ///     Observe the ball horizontally nearest a paddle.
+    /// </summary>
+    /// <param name="world">Registry holding the paddle.</param>
+    /// <param name="paddle">Observing paddle.</param>
+    /// <returns>The observation, with the ball far away if there is none.</returns>
+    template <typename T>
+    Observation observe(const CBasicRegistry<T>& world, Entity paddle)
+    {
+        const BasicPosition<T>& position = world.positions.get(paddle);
+        float x = static_cast<float>(position.x);
+        float y = static_cast<float>(position.y);
+        Observation result = {
+            1.0f,
+            0.0f,
+            0.0f,
+            0.0f,
+            (y - winten_constants::FIELD_BORDER) / (winten_constants::H - 2.0f * winten_constants::FIELD_BORDER) };
+        float nearestDistance = winten_constants::W;
+
+        for (std::size_t slot = 0; slot < world.velocities.size(); slot++)
+        {
+            const BasicVelocity<T>& velocity = world.velocities[slot];
+            const BasicPosition<T>& ball = world.positions.get(world.velocities.entity(slot));
+            float distance = std::fabs(static_cast<float>(ball.x) - x);
+            if (distance > nearestDistance)
+                continue;
+
+            nearestDistance = distance;
+            result.distance = distance / winten_constants::W;
+            result.offset = (static_cast<float>(ball.y) - y) / winten_constants::H;
+            result.vertical = velocity.left
+                ? -angle_table::direction(velocity.angle).y
+                : angle_table::direction(velocity.angle).y;
+            result.approaching = velocity.left == (static_cast<float>(ball.x) > x) ? 1.0f : 0.0f;
+        }
+        return result;
+    }
+
+    /// <summary>
+    ///     Choose the next move of every policy paddle in a set of matches.
+    ///     Consecutive paddles sharing a policy are observed into a fixed
+    ///     buffer and evaluated together, so a policy which batches, such as a
+    ///     network, costs far less per paddle than deciding in each step.
+    /// </summary>
+    /// <param name="worlds">Matches to decide for.</param>
+    /// <param name="count">Number of matches.</param>
+    template <typename T>
+    void decide(CBasicRegistry<T>* const* worlds, int count)
+    {
+        WINTEN_TRACE_ZONE("systems::decide");
+        const int BATCH = 64;
+        Observation observations[BATCH];
+        PolicyAction actions[BATCH];
+        BasicController<T>* controllers[BATCH];
+        const IPolicy* policy = nullptr;
+        int pending = 0;
+
+        auto flush = [&]() {
+            if (pending == 0)
+                return;
+            policy->actBatch(observations, pending, actions);
+            for (int index = 0; index < pending; index++)
+            {
+                controllers[index]->decision = actions[index];
+                controllers[index]->decided = true;
+            }
+            pending = 0;
+        };
+
+        for (int index = 0; index < count; index++)
+        {
+            CBasicRegistry<T>& world = *worlds[index];
+            if (!world.policy)
+                continue;
+
+            for (std::size_t slot = 0; slot < world.controllers.size(); slot++)
+            {
+                if (world.controllers[slot].kind != CONTROLLER_POLICY)
+                    continue;
+                if (world.policy.get() != policy || pending == BATCH)
+                {
+                    flush();
+                    policy = world.policy.get();
+                }
+                observations[pending] = observe(world, world.controllers.entity(slot));
+                controllers[pending++] = &world.controllers[slot];
+            }
+        }
+        flush();
+    }
+
+    /// <summary>
+    ///     Move paddles by keyboard, towards the nearest ball in view or as the
+    ///     registry's policy chooses, keeping them inside the field.
+    /// </summary>
+    /// <param name="world">Registry to update.</param>
+    /// <param name="input">Keys held.</param>
+    /// <param name="delta">Time step in seconds.</param>
+    template <typename T>
+    void control(CBasicRegistry<T>& world, const Input& input, typename CBasicRegistry<T>::Scalar delta)
+    {
+        WINTEN_TRACE_ZONE("systems::control");
+        const T top = T(winten_constants::FIELD_BORDER);
+        const T bottom = T(winten_constants::H - winten_constants::FIELD_BORDER);
+
+        for (std::size_t slot = 0; slot < world.controllers.size(); slot++)
+        {
+            BasicController<T>& controller = world.controllers[slot];
+            Entity paddle = world.controllers.entity(slot);
+            BasicPosition<T>& position = world.positions.get(paddle);
+            const BasicCollider<T>* collider = world.colliders.find(paddle);
+            T halfHeight = collider != nullptr ? collider->height / T(2) : T();
+            T step = controller.speed * delta;
+
+            if (controller.kind == CONTROLLER_KEYBOARD)
+            {
+                if (input.up)
+                    position.y -= step;
+                if (input.down)
+                    position.y += step;
+            }
+            else if (controller.kind == CONTROLLER_POLICY)
+            {
+                PolicyAction action = ACTION_STAY;
+                if (controller.decided)
+                    action = controller.decision;
+                else if (world.policy)
+                    action = world.policy->act(observe(world, paddle));
+                controller.decided = false;
+
+                if (action == ACTION_UP)
+                    position.y -= step;
+                if (action == ACTION_DOWN)
+                    position.y += step;
+            }
+            else
+            {
+                // Nearest ball horizontally
+                const BasicPosition<T>* nearest = nullptr;
+                T nearestDistance = controller.horizon;
+                for (std::size_t ball = 0; ball < world.velocities.size(); ball++)
+                {
+                    const BasicPosition<T>& candidate = world.positions.get(world.velocities.entity(ball));
+                    T distance = separation(candidate.x, position.x);
+                    if (distance <= nearestDistance)
+                    {
+                        nearest = &candidate;
+                        nearestDistance = distance;
+                    }
+                }
+
+                // Move in direction of ball
+                if (nearest != nullptr)
+                {
+                    if (nearest->y > position.y)
+                        position.y += step;
+                    if (nearest->y < position.y)
+                        position.y -= step;
+                }
+            }
+
+            position.y = std::min(position.y, bottom - halfHeight);
+            position.y = std::max(position.y, top + halfHeight);
+        }
+    }
+
+    /// <summary>
+    ///     Move every entity with a velocity along its heading.
+    /// </summary>
+    /// <param name="world">Registry to update.</param>
+    /// <param name="delta">Time step in seconds.</param>
+    template <typename T>
+    void movement(CBasicRegistry<T>& world, typename CBasicRegistry<T>::Scalar delta)
+    {
+        WINTEN_TRACE_ZONE("systems::movement");
+
+        for (std::size_t slot = 0; slot < world.velocities.size(); slot++)
+        {
+            const BasicVelocity<T>& velocity = world.velocities[slot];
+            BasicPosition<T>& position = world.positions.get(world.velocities.entity(slot));
+            T directionX;
+            T directionY;
+            T distance = (velocity.left ? -velocity.speed : velocity.speed) * delta;
+
+            heading(velocity.angle, directionX, directionY);
+            position.x += directionX * distance;
+            position.y += directionY * distance;
+        }
+    }
+
+    /// <summary>
+    ///     Bounce moving balls off the top and bottom of the field and off
+    ///     boxes. Reaching either end scores for the other side and bounces.
+    ///     Each bounce and point is pushed to the registry's events.
+    /// </summary>
+    /// <param name="world">Registry to update.</param>
+    template <typename T>
+    void collision(CBasicRegistry<T>& world)
+    {
+        WINTEN_TRACE_ZONE("systems::collision");
+        const T border = T(winten_constants::FIELD_BORDER);
+        const T right = T(winten_constants::W - winten_constants::FIELD_BORDER);
+        const T bottom = T(winten_constants::H - winten_constants::FIELD_BORDER);
+        const T middle = T(winten_constants::W / 2.0f);
+        // Clearance keeping a returned ball off the box it hit
+        const T clearance = T(0.001f);
+
+        for (std::size_t slot = 0; slot < world.velocities.size(); slot++)
+        {
+            Entity ball = world.velocities.entity(slot);
+            BasicVelocity<T>& velocity = world.velocities[slot];
+            BasicPosition<T>& position = world.positions.get(ball);
+            const BasicCollider<T>* collider = world.colliders.find(ball);
+            if (collider == nullptr || collider->shape != COLLIDER_BALL)
+                continue;
+
+            T halfWidth = collider->width / T(2);
+            T halfHeight = collider->height / T(2);
+            T maxX = right - halfWidth;
+            T minX = border + halfWidth;
+            T maxY = bottom - halfHeight;
+            T minY = border + halfHeight;
+
+            // Reflect about the normal of the top or bottom surface
+            if (position.y > maxY || position.y < minY)
+            {
+                velocity.angle = angle_table::mirror(velocity.angle);
+                position.y = std::min(std::max(position.y, minY), maxY);
+                world.events.push(EVENT_WALL_BOUNCE, ball, ball, velocity.angle);
+            }
+
+            // Either end scores for the opposite side
+            if (position.x > maxX || position.x < minX)
+            {
+                bool scoredRight = position.x > maxX;
+                world.score[scoredRight ? SIDE_LEFT : SIDE_RIGHT]++;
+                world.events.push(EVENT_SCORE, ball, ball, scoredRight ? SIDE_LEFT : SIDE_RIGHT);
+                velocity.left = scoredRight;
+                velocity.angle = angle_table::mirror(velocity.angle);
+                position.x = scoredRight ? maxX : minX;
+            }
+
+            // Boxes return the ball towards the middle of the field with some
+            // noise, so a ball that slips behind a paddle is not trapped there.
+            // A box on the centre line sends it back the way it came.
+            for (std::size_t box = 0; box < world.colliders.size(); box++)
+            {
+                const BasicCollider<T>& boxCollider = world.colliders[box];
+                if (boxCollider.shape != COLLIDER_BOX)
+                    continue;
+
+                const BasicPosition<T>& boxPosition = world.positions.get(world.colliders.entity(box));
+                if (separation(boxPosition.x, position.x) >= halfWidth + boxCollider.width / T(2)
+                    || separation(boxPosition.y, position.y) >= halfHeight + boxCollider.height / T(2))
+                    continue;
+
+                bool left = boxPosition.x == middle ? !velocity.left : boxPosition.x > middle;
+                T offset = boxCollider.width / T(2) + halfWidth + clearance;
+                velocity.left = left;
+                velocity.angle = angle_table::hit(velocity.angle, world.random());
+                position.x = left ? boxPosition.x - offset : boxPosition.x + offset;
+                world.events.push(EVENT_PADDLE_HIT, ball, world.colliders.entity(box), velocity.angle);
+            }
+        }
+    }
+
+    /// <summary>
+    ///     Advance a match by one time step.
+    /// </summary>
+    /// <param name="world">Registry to update.</param>
+    /// <param name="input">Keys held.</param>
+    /// <param name="delta">Time step in seconds.</param>
+    template <typename T>
+    void step(CBasicRegistry<T>& world, const Input& input, typename CBasicRegistry<T>::Scalar delta)
+    {
+        world.events.beginTick();
+        control(world, input, delta);
+        movement(world, delta);
+        collision(world);
+    }
+
+    /// <summary>
+    ///     Record the position and heading of every entity, reusing the
+    ///     snapshot's storage.
+    /// </summary>
+    /// <param name="world">Registry to record.</param>
+    /// <param name="result">Receives the snapshot.</param>
+    template <typename T>
+    void snapshot(const CBasicRegistry<T>& world, Snapshot<T>& result)
+    {
+        result.positions = world.positions;
+        result.velocities = world.velocities;
+    }
+
+    /// <summary>
+    ///     Append every shape centred on its position, then every text element.
+    ///     Text changes its string table entry only when its value changes.
+    ///     Given a snapshot, shapes are drawn part way from where they were to
+    ///     where they are, except that anything which has changed heading since,
+    ///     by bouncing, being hit or scoring, or which did not exist, is drawn
+    ///     where it is rather than along a path it never took.
+    /// </summary>
+    /// <param name="world">Registry to draw.</param>
+    /// <param name="list">List to append to.</param>
+    /// <param name="firstTextId">String table entry of the first text element.</param>
+    /// <param name="previous">Snapshot taken before the last tick, or nullptr.</param>
+    /// <param name="alpha">Fraction of the way from the snapshot to now.</param>
+    template <typename T>
+    void draw(
+        const CBasicRegistry<T>& world,
+        CRenderList& list,
+        int firstTextId,
+        const Snapshot<T>* previous,
+        float alpha)
+    {
+        WINTEN_TRACE_ZONE("systems::draw");
+        char score[16];
+
+        for (std::size_t slot = 0; slot < world.renders.size(); slot++)
+        {
+            const Render& render = world.renders[slot];
+            Entity entity = world.renders.entity(slot);
+            const BasicPosition<T>& position = world.positions.get(entity);
+            const BasicPosition<T>* from = previous != nullptr ? previous->positions.find(entity) : nullptr;
+            const BasicVelocity<T>* velocity = world.velocities.find(entity);
+
+            if (from != nullptr && velocity != nullptr)
+            {
+                const BasicVelocity<T>* before = previous->velocities.find(entity);
+                if (before == nullptr || before->left != velocity->left || before->angle != velocity->angle)
+                    from = nullptr;
+            }
+            if (from == nullptr)
+                from = &position;
+
+            float left = between(from->x, position.x, alpha) - render.width / 2.0f;
+            float top = between(from->y, position.y, alpha) - render.height / 2.0f;
+
+            if (render.shape == RENDER_SHAPE_RECT)
+                list.fillRect(left, top, render.width, render.height, render.colour);
+            else
+                list.fillEllipse(left, top, render.width, render.height, render.colour);
+        }
+
+        for (std::size_t slot = 0; slot < world.texts.size(); slot++)
+        {
+            const Text& text = world.texts[slot];
+            const BasicPosition<T>& position = world.positions.get(world.texts.entity(slot));
+            int textId = firstTextId + static_cast<int>(slot);
+
+            if (text.scoreSide >= 0)
+            {
+                std::snprintf(score, sizeof(score), "%d", world.score[text.scoreSide]);
+                list.setString(textId, score);
+            }
+            else
+                list.setString(textId, text.text.c_str());
+            list.text(textId, static_cast<float>(position.x), static_cast<float>(position.y), text.size, text.colour);
+        }
+    }
+
+    // Instantiate every system for play in float and for the fixed-point core
+#define WINTEN_SYSTEMS_INSTANTIATE(T) \
+    template Entity createPaddle<T>(CBasicRegistry<T>&, CBasicRegistry<T>::Scalar, const CBasicRegistry<T>::Controller*); \
+    template Entity createBall<T>(CBasicRegistry<T>&, CBasicRegistry<T>::Scalar, CBasicRegistry<T>::Scalar, const CBasicRegistry<T>::Velocity*); \
+    template Entity createObstacle<T>( \
+        CBasicRegistry<T>&, CBasicRegistry<T>::Scalar, CBasicRegistry<T>::Scalar, CBasicRegistry<T>::Scalar, CBasicRegistry<T>::Scalar); \
+    template Entity createText<T>(CBasicRegistry<T>&, CBasicRegistry<T>::Scalar, CBasicRegistry<T>::Scalar, const char*, int); \
+    template void createScores<T>(CBasicRegistry<T>&); \
+    template BasicController<T> npcController<T>(CBasicRegistry<T>&); \
+    template Observation observe<T>(const CBasicRegistry<T>&, Entity); \
+    template void decide<T>(CBasicRegistry<T>* const*, int); \
+    template void control<T>(CBasicRegistry<T>&, const Input&, CBasicRegistry<T>::Scalar); \
+    template void movement<T>(CBasicRegistry<T>&, CBasicRegistry<T>::Scalar); \
+    template void collision<T>(CBasicRegistry<T>&); \
+    template void step<T>(CBasicRegistry<T>&, const Input&, CBasicRegistry<T>::Scalar); \
+    template void snapshot<T>(const CBasicRegistry<T>&, Snapshot<T>&); \
+    template void draw<T>(const CBasicRegistry<T>&, CRenderList&, int, const Snapshot<T>*, float);
+
+    WINTEN_SYSTEMS_INSTANTIATE(float)
+    WINTEN_SYSTEMS_INSTANTIATE(CFixed)
+#undef WINTEN_SYSTEMS_INSTANTIATE
+}
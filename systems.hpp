@@ -0,0 +1,122 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_SYSTEMS_HPP
+#define WINTEN_SYSTEMS_HPP
+
+// Include external header files
+#include <memory>
+
+// Include project header files
+#include "components.hpp"
+#include "cregistry.hpp"
+#include "ipolicy.hpp"
+#include "renderlist.hpp"
+
+/// <summary>
+///     Systems updating a match registry. Each iterates one dense component
+///     array and looks up the others it needs by entity, so any number of
+///     paddles, balls and obstacles cost no virtual calls. Every system is
+///     instantiated for the float registry and the fixed-point one.
+/// </summary>
+namespace systems {
+    /// <summary>
+    ///     Keys read by keyboard controllers.
+    /// </summary>
+    struct Input
+    {
+        bool up;
+        bool down;
+    };
+
+    /// <summary>
+    ///     Where the entities of a match were and how they were heading, taken
+    ///     before a tick so that frames between ticks can be drawn part way.
+    /// </summary>
+    template <typename T>
+    struct Snapshot
+    {
+        CComponentArray<BasicPosition<T>> positions;
+        CComponentArray<BasicVelocity<T>> velocities;
+    };
+
+    // Entity factories for the standard court
+    template <typename T>
+    Entity createPaddle(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        const typename CBasicRegistry<T>::Controller* controller);
+    template <typename T>
+    Entity createBall(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        const typename CBasicRegistry<T>::Velocity* velocity);
+    template <typename T>
+    Entity createObstacle(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        typename CBasicRegistry<T>::Scalar width,
+        typename CBasicRegistry<T>::Scalar height);
+    template <typename T>
+    Entity createText(
+        CBasicRegistry<T>& world,
+        typename CBasicRegistry<T>::Scalar x,
+        typename CBasicRegistry<T>::Scalar y,
+        const char* text,
+        int scoreSide);
+    template <typename T>
+    void createScores(CBasicRegistry<T>& world);
+
+    // Policy for the computer paddles of new matches, nullptr to track the ball
+    void setNpcPolicy(std::shared_ptr<const IPolicy> policy);
+    template <typename T>
+    BasicController<T> npcController(CBasicRegistry<T>& world);
+    // What a paddle sees of the nearest ball
+    template <typename T>
+    Observation observe(const CBasicRegistry<T>& world, Entity paddle);
+
+    // Choose the moves of the policy paddles of many matches, batching
+    // matches which share a policy into one evaluation
+    template <typename T>
+    void decide(CBasicRegistry<T>* const* worlds, int count);
+    // Move paddles by keyboard, by tracking the ball or by policy
+    template <typename T>
+    void control(CBasicRegistry<T>& world, const Input& input, typename CBasicRegistry<T>::Scalar delta);
+    // Integrate velocities
+    template <typename T>
+    void movement(CBasicRegistry<T>& world, typename CBasicRegistry<T>::Scalar delta);
+    // Bounce balls off the field edges and boxes, scoring at either end
+    template <typename T>
+    void collision(CBasicRegistry<T>& world);
+    // Control, movement and collision in order, as the registry's next tick
+    template <typename T>
+    void step(CBasicRegistry<T>& world, const Input& input, typename CBasicRegistry<T>::Scalar delta);
+    // Record positions and headings to draw between this tick and the next
+    template <typename T>
+    void snapshot(const CBasicRegistry<T>& world, Snapshot<T>& result);
+    // Append shapes and text, text using string table entries from firstTextId,
+    // shapes placed a fraction alpha of the way from a snapshot to now
+    template <typename T>
+    void draw(
+        const CBasicRegistry<T>& world,
+        CRenderList& list,
+        int firstTextId,
+        const Snapshot<T>* previous = nullptr,
+        float alpha = 1.0f);
+}
+
+#endif
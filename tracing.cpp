@@ -0,0 +1,148 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Include external header files
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Include project header files
+#include "tracing.hpp"
+
+namespace
+{
+    // Registry of per-thread buffers, only locked when a thread first traces or on flush
+    std::mutex g_buffersMutex;
+    std::vector<std::unique_ptr<CTraceBuffer>> g_buffers;
+    thread_local CTraceBuffer* t_buffer = nullptr;
+}
+
+std::atomic<bool> CTracer::s_enabled(false);
+
+/// <summary>
+///     Class constructor.
+/// </summary>
+/// <param name="threadId">Identifier written as the trace "tid".</param>
+CTraceBuffer::CTraceBuffer(unsigned int threadId)
+    : m_events()
+    , m_head(0)
+    , m_read(0)
+    , m_threadId(threadId)
+{
+}
+
+/// <summary>
+///     Append an event, called only from the owning thread.
+/// </summary>
+/// <param name="name">Zone name.</param>
+/// <param name="start">Start time in nanoseconds.</param>
+/// <param name="duration">Duration in nanoseconds.</param>
+void CTraceBuffer::record(const char* name, std::int64_t start, std::int64_t duration)
+{
+    std::uint64_t head = m_head.load(std::memory_order_relaxed);
+    TraceEvent& event = m_events[head % CAPACITY];
+
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+/// <summary>
+///     Write events recorded since the last flush as Chrome trace JSON objects.
+///     Events overwritten by the writer while being copied are discarded.
+/// </summary>
+/// <param name="out">Output stream.</param>
+/// <param name="first">True until the first event of the trace has been written.</param>
+void CTraceBuffer::flush(std::ostream& out, bool& first)
+{
+    std::uint64_t head = m_head.load(std::memory_order_acquire);
+    std::uint64_t index = m_read;
+
+    // Skip events already overwritten
+    if (head - index > CAPACITY)
+        index = head - CAPACITY;
+
+    for (; index < head; index++)
+    {
+        TraceEvent event = m_events[index % CAPACITY];
+
+        // Drop the copy if the writer has since reached this slot again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_head.load(std::memory_order_relaxed) - index >= CAPACITY)
+            continue;
+
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"" << event.name
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << m_threadId
+            << ",\"ts\":" << event.start / 1000 << "." << (event.start % 1000) / 100
+            << ",\"dur\":" << event.duration / 1000 << "." << (event.duration % 1000) / 100
+            << "}";
+        first = false;
+    }
+    m_read = head;
+}
+
+/// <summary>
+///     Turn trace recording on or off.
+/// </summary>
+/// <param name="enabled">True to record zones.</param>
+void CTracer::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/// <summary>
+///     Trace timestamp.
+/// </summary>
+/// <returns>Steady clock time in nanoseconds.</returns>
+std::int64_t CTracer::now(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+///     Get the calling thread's buffer, registering it on first use.
+/// </summary>
+/// <returns>The buffer.</returns>
+CTraceBuffer* CTracer::threadBuffer(void)
+{
+    if (t_buffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        g_buffers.emplace_back(new CTraceBuffer(static_cast<unsigned int>(g_buffers.size()) + 1));
+        t_buffer = g_buffers.back().get();
+    }
+    return t_buffer;
+}
+
+/// <summary>
+///     Write all events recorded since the last flush as a Chrome trace JSON
+///     document, loadable in chrome://tracing or Perfetto.
+/// </summary>
+/// <param name="out">Output stream.</param>
+void CTracer::flush(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+    bool first = true;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (auto& buffer : g_buffers)
+        buffer->flush(out, first);
+    out << "\n]}\n";
+}
@@ -0,0 +1,121 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef WINTEN_TRACING_HPP
+#define WINTEN_TRACING_HPP
+
+// Include external header files
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Compile-time switch, set to 0 to remove all trace zones from the build
+#ifndef WINTEN_TRACING
+#define WINTEN_TRACING 1
+#endif
+
+/// <summary>
+///     A completed trace zone.
+/// </summary>
+struct TraceEvent
+{
+    // Zone name, must be a string literal
+    const char* name;
+    // Start and duration in nanoseconds
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+/// <summary>
+///     Fixed-size ring of trace events written by a single thread. The writer
+///     never blocks; once full the oldest events are overwritten.
+/// </summary>
+class CTraceBuffer
+{
+public:
+    static const std::size_t CAPACITY = 16384;
+
+private:
+    TraceEvent m_events[CAPACITY];
+    // Total events written, published with release ordering
+    std::atomic<std::uint64_t> m_head;
+    // Events already flushed, only accessed by the flushing thread
+    std::uint64_t m_read;
+    unsigned int m_threadId;
+
+public:
+    CTraceBuffer(unsigned int threadId);
+    void record(const char* name, std::int64_t start, std::int64_t duration);
+    void flush(std::ostream& out, bool& first);
+};
+
+/// <summary>
+///     Global trace control and Chrome trace JSON output.
+/// </summary>
+class CTracer
+{
+private:
+    static std::atomic<bool> s_enabled;
+
+public:
+    /// <summary>
+    ///     Runtime switch checked on entry to every zone.
+    /// </summary>
+    static bool enabled(void)
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    static std::int64_t now(void);
+    static CTraceBuffer* threadBuffer(void);
+    static void flush(std::ostream& out);
+};
+
+/// <summary>
+///     Records the lifetime of a scope as a trace zone when tracing is enabled.
+/// </summary>
+class CTraceZone
+{
+private:
+    const char* m_name;
+    std::int64_t m_start;
+
+public:
+    explicit CTraceZone(const char* name)
+        : m_name(name)
+        , m_start(CTracer::enabled() ? CTracer::now() : -1)
+    {
+    }
+
+    ~CTraceZone()
+    {
+        if (m_start >= 0)
+            CTracer::threadBuffer()->record(m_name, m_start, CTracer::now() - m_start);
+    }
+
+    CTraceZone(const CTraceZone&) = delete;
+    CTraceZone& operator=(const CTraceZone&) = delete;
+};
+
+#define WINTEN_TRACE_CONCAT_(a, b) a##b
+#define WINTEN_TRACE_CONCAT(a, b) WINTEN_TRACE_CONCAT_(a, b)
+#if WINTEN_TRACING
+#define WINTEN_TRACE_ZONE(name) CTraceZone WINTEN_TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define WINTEN_TRACE_ZONE(name) ((void)0)
+#endif
+
+#endif
@@ -29,11 +29,17 @@
 #include <gdiplus.h>
 #include <deque>
 #include <mmsystem.h>
+#include <fstream>
+#include <thread>
+#include <wchar.h>
 
 // Include project headers
 #include "contextcontroller.hpp"
+#include "cschedulerchrono.hpp"
 #include "cstateintro.hpp"
+#include "cviewdib.hpp"
 #include "cviewgdi.hpp"
+#include "tracing.hpp"
 #include "winten.h"
 #include "winten_constants.hpp"
 
@@ -42,7 +48,8 @@
 #pragma comment (lib,"winmm.lib")
 
 #define MAX_LOADSTRING 100
-#define TIMER_ID 1
+#define TRACE_FILE "winten_trace.json"
+#define SOFTWARE_SWITCH L"/software"
 
 //std::deque<long double> counts(100, 0);
 
@@ -50,6 +57,7 @@
 HINSTANCE hInst;                                // current instance
 WCHAR szTitle[MAX_LOADSTRING];                  // The title bar text
 WCHAR szWindowClass[MAX_LOADSTRING];            // the main window class name
+bool softwareRender = false;                    // draw with the tiled software rasterizer
 
 // Forward declarations of functions included in this code module:
 ATOM                MyRegisterClass(HINSTANCE hInstance);
@@ -58,7 +66,7 @@ HWND                InitInstance(HINSTANCE, int, ContextController*);
 
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
-VOID CALLBACK gameTimer(UINT      uTimerID, UINT      uMsg, DWORD_PTR dwUser, DWORD_PTR dw1, DWORD_PTR dw2);
+void                toggleTracing(void);
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_opt_ HINSTANCE hPrevInstance,
@@ -66,9 +74,11 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_ int       nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
     ContextController controller; // Controller context object in local scope
 
+    // Select the software rasterizer, which scales better to large windows
+    softwareRender = lpCmdLine != nullptr && wcsstr(lpCmdLine, SOFTWARE_SWITCH) != nullptr;
+
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadStringW(hInstance, IDC_WINTEN, szWindowClass, MAX_LOADSTRING);
@@ -92,13 +102,23 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         )
     );  
 
-    // Set a timer for world update and rendering
-    timeSetEvent(
-        15, 
-        0, 
-        gameTimer, 
-        (DWORD_PTR) & controller, 
-        TIME_PERIODIC);
+    // Raise the system timer resolution so the scheduler's coarse sleep is accurate
+    timeBeginPeriod(1);
+
+    // Draw at the display's refresh rate, the simulation ticking at its own
+    // rate in between, falling back to the tick rate if the driver won't say
+    HDC screen = GetDC(nullptr);
+    int refresh = GetDeviceCaps(screen, VREFRESH);
+    ReleaseDC(nullptr, screen);
+
+    float rate = refresh > 1 ? static_cast<float>(refresh) : winten_constants::FRAME_RATE;
+
+    // Step rendering quality down when a frame takes longer than its period
+    controller.setFrameBudget(static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / rate));
+
+    // Run world update and rendering in the game loop thread
+    CSchedulerChrono scheduler(rate, winten_constants::FRAME_SPIN_THRESHOLD);
+    std::thread gameThread(&ContextController::run, &controller, &scheduler);
 
     // Main message loop:
     MSG msg;
@@ -111,6 +131,11 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         }
     }
 
+    // Wait for the game loop to exit
+    controller.stop();
+    gameThread.join();
+    timeEndPeriod(1);
+
     return (int)msg.wParam;
 }
 
@@ -141,25 +166,6 @@ ATOM MyRegisterClass(HINSTANCE hInstance)
     return RegisterClassExW(&wcex);
 }
 
-//VOID CALLBACK gameTimer(HWND hWnd, UINT ByVal, UINT_PTR id, DWORD dwTime)
-VOID CALLBACK gameTimer(UINT      uTimerID, UINT      uMsg, DWORD_PTR dwUser, DWORD_PTR dw1, DWORD_PTR dw2)
-{
-    ContextController *controller = (ContextController*)dwUser;
-    unsigned __int64 freq;
-    unsigned __int64 thisTime, timeAfterUpdate;
-
-    // Get frequency and counter ticks
-    QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
-    QueryPerformanceCounter((LARGE_INTEGER*)&thisTime);
-
-    // Update the world and render
-    controller->update(static_cast<long double>(thisTime) / static_cast<long double>(freq));
-            
-    QueryPerformanceCounter((LARGE_INTEGER*)&timeAfterUpdate);
-    controller->setAfterUpdateTime(static_cast<long double>(timeAfterUpdate) / static_cast<long double>(freq));
-
-}
-
 //
 //   FUNCTION: InitInstance(HINSTANCE, int)
 //
@@ -269,21 +275,24 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             // Resize the display
             controller->shutdown();
             controller->initialize(newXOffset, newYOffset, newWidth, newHeight);
-            //world.pause(false);
+            controller->setVisible(true);
         }
         break;
         case SIZE_MINIMIZED:
-            //world.pause(true);
+            // Pause the game loop until restored
+            controller->setVisible(false);
             break;
         }
     }
         return 0;
     case WM_PAINT:
+        // Redraw the next frame in full
+        controller->invalidate();
         ValidateRect(hWnd,NULL);
         return 0;
     case WM_DESTROY:
-        // Stop timers
-        timeKillEvent(TIMER_ID);
+        // Stop the game loop
+        controller->stop();
 
         controller->shutdown();
 
@@ -298,7 +307,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         SetWindowLongPtr(hWnd, 0, (LONG_PTR)controller);
         
         // Create the view and register with controller
-        std::unique_ptr<IView> pView(new CViewGDI(hWnd));
+        std::unique_ptr<IView> pView;
+        if (softwareRender)
+            pView.reset(new CViewDIB(hWnd));
+        else
+            pView.reset(new CViewGDI(hWnd));
         controller->setView(std::move(pView));
         controller->initialize(0, 0, create->cx, create->cy);
     }
@@ -318,6 +331,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         }
         break;
     case WM_KEYDOWN:
+        // F9 starts and stops a trace capture without affecting the game
+        if (wParam == VK_F9)
+        {
+            toggleTracing();
+            break;
+        }
         switch (wParam)
         {
         case VK_DOWN:
@@ -356,3 +375,22 @@ INT_PTR CALLBACK About(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
     }
     return (INT_PTR)FALSE;
 }
+
+//
+//  FUNCTION: toggleTracing()
+//
+//  PURPOSE: Starts recording trace zones, or stops and writes the trace to file.
+//
+void toggleTracing(void)
+{
+    if (!CTracer::enabled())
+    {
+        CTracer::setEnabled(true);
+    }
+    else
+    {
+        CTracer::setEnabled(false);
+        std::ofstream traceFile(TRACE_FILE);
+        CTracer::flush(traceFile);
+    }
+}
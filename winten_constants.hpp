@@ -16,44 +16,60 @@
 #ifndef WINTEN_WINTEN_CONSTANTS_HPP
 #define WINTEN_WINTEN_CONSTANTS_HPP
 
-#include <ctime>
+#include <cstdint>
 
 namespace winten_constants {
 	// General
-	const float PI = 3.141592654f;
+	constexpr float PI = 3.141592654f;
+	// Clock ticks are nanoseconds
+	constexpr std::int64_t TICKS_PER_SECOND = 1000000000;
+	constexpr float SECONDS_PER_TICK = 1.0e-9f;
 	// Canvas size
-	const float W = 640.0f;
-	const float H = 480.0f;
-	const float ASPECT_RATIO =  W / H;
+	constexpr float W = 640.0f;
+	constexpr float H = 480.0f;
+	constexpr float ASPECT_RATIO =  W / H;
+	// Frame scheduling
+	constexpr float FRAME_RATE = 1000.0f / 15.0f;
+	constexpr long long FRAME_SPIN_THRESHOLD = 2000000; // Nanoseconds
+	// Simulation ticks, independent of the frame rate, which draws between them
+	constexpr float TICK_RATE = FRAME_RATE;
+	// Ticks run in one frame at most, dropping time after a stall rather than racing to catch up
+	constexpr int MAX_TICKS_PER_FRAME = 8;
 	// Border
-	const float FIELD_BORDER = 15.0f;
+	constexpr float FIELD_BORDER = 15.0f;
 	// Paddle
-	const float PADDLE_HEIGHT = 40.0f;
-	const float PADDLE_WIDTH = 10.0f;
-	const float PADDLE_MAX_Y = H - FIELD_BORDER - PADDLE_HEIGHT/2.0f;
-	const float PADDLE_MIN_Y = FIELD_BORDER + PADDLE_HEIGHT/2.0f;
-	const float PADDLE_SPEED = H / 2.0f;
-	const float PADDLE_X_NPC = 2.0f * FIELD_BORDER;
-	const float PADDLE_X_PLAYER = W - 2.0f * FIELD_BORDER;
+	constexpr float PADDLE_HEIGHT = 40.0f;
+	constexpr float PADDLE_WIDTH = 10.0f;
+	constexpr float PADDLE_MAX_Y = H - FIELD_BORDER - PADDLE_HEIGHT/2.0f;
+	constexpr float PADDLE_MIN_Y = FIELD_BORDER + PADDLE_HEIGHT/2.0f;
+	constexpr float PADDLE_SPEED = H / 2.0f;
+	constexpr float PADDLE_X_NPC = 2.0f * FIELD_BORDER;
+	constexpr float PADDLE_X_PLAYER = W - 2.0f * FIELD_BORDER;
 	// Ball
-	const float BALL_DIAMETER = 10.0f;
-	const float BALL_MAX_X = W - BALL_DIAMETER/2.0f - FIELD_BORDER;
-	const float BALL_MIN_X = BALL_DIAMETER/2.0f + FIELD_BORDER;
-	const float BALL_MAX_Y = H - BALL_DIAMETER / 2.0f - FIELD_BORDER;
-	const float BALL_MIN_Y = BALL_DIAMETER / 2.0f + FIELD_BORDER;
-	const float BALL_MAX_THETA = PI / 3.0f;
-	const float BALL_MIN_THETA = -PI / 3.0f;
-	const float BALL_SPEED = W/2.0f;
-	const float BALL_ANGLE_NOISE = -PI / 10.0f;
-	const float NPC_HORIZON = 0.3f * W;
-	// Number of second before demo starts in intro screen
-	const time_t DELAY_DEMO = 10; 
+	constexpr float BALL_DIAMETER = 10.0f;
+	constexpr float BALL_MAX_X = W - BALL_DIAMETER/2.0f - FIELD_BORDER;
+	constexpr float BALL_MIN_X = BALL_DIAMETER/2.0f + FIELD_BORDER;
+	constexpr float BALL_MAX_Y = H - BALL_DIAMETER / 2.0f - FIELD_BORDER;
+	constexpr float BALL_MIN_Y = BALL_DIAMETER / 2.0f + FIELD_BORDER;
+	constexpr float BALL_MAX_THETA = PI / 3.0f;
+	constexpr float BALL_MIN_THETA = -PI / 3.0f;
+	constexpr float BALL_SPEED = W/2.0f;
+	constexpr float BALL_ANGLE_NOISE = -PI / 10.0f;
+	constexpr float NPC_HORIZON = 0.3f * W;
+	// Ticks before demo starts in intro screen
+	constexpr std::int64_t DELAY_DEMO = 10 * TICKS_PER_SECOND;
+	// Colours as 0xAARRGGBB
+	constexpr std::uint32_t COLOUR_FOREGROUND = 0xFF00FF00;
+	constexpr std::uint32_t COLOUR_BACKGROUND = 0xFF000000;
 	// Text
-	const float SCORE_TEXT_NPC = 40.0f;
-	const float SCORE_TEXT_PLAYER = W - 50.0f;
-	const float SCORE_TEXT_Y = 40.0f;
-	const float MESSAGE_TEXT_X = 200.0f;
-	const float MESSAGE_TEXT_Y = 180.0f;
+	constexpr float TEXT_SIZE = 24.0f;
+	// Seconds between refreshes of the frame rate and latency text
+	constexpr float STATS_REFRESH = 0.25f;
+	constexpr float SCORE_TEXT_NPC = 40.0f;
+	constexpr float SCORE_TEXT_PLAYER = W - 50.0f;
+	constexpr float SCORE_TEXT_Y = 40.0f;
+	constexpr float MESSAGE_TEXT_X = 200.0f;
+	constexpr float MESSAGE_TEXT_Y = 180.0f;
 }
 
 #endif
@@ -0,0 +1,2021 @@
+/*
+* Copyright (C) 2024 James Bott
+*
+* This program is free software: you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Headless entry point for POSIX and console builds, drawing to the terminal
+
+// Include external header files
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Include project header files
+#include "angletable.hpp"
+#include "ballkernels.hpp"
+#include "cclockvirtual.hpp"
+#include "ccourtgrid.hpp"
+#include "cfixed.hpp"
+#include "cframebuilder.hpp"
+#include "cframecapture.hpp"
+#include "contextcontroller.hpp"
+#include "cpolicymlp.hpp"
+#include "cpolicytabular.hpp"
+#include "cresultstore.hpp"
+#include "cschedulerchrono.hpp"
+#include "csessionhost.hpp"
+#include "cstatedemo.hpp"
+#include "cstategame.hpp"
+#include "cstateintro.hpp"
+#include "cstress.hpp"
+#include "cthreadpool.hpp"
+#include "ctrainer.hpp"
+#include "ctrajectory.hpp"
+#include "cviewframebuffer.hpp"
+#include "cviewterminal.hpp"
+#include "rasterkernels.hpp"
+#include "systems.hpp"
+#include "winten_constants.hpp"
+
+namespace
+{
+    volatile std::sig_atomic_t g_stop = 0;
+
+    /// <summary>
+    ///     Command line settings.
+    /// </summary>
+    struct Options
+    {
+        bool demo;
+        float rate;
+        long long spin;
+        const char* capturePath;
+        double seconds;
+        int width;
+        int height;
+        bool benchKernels;
+        bool benchRaster;
+        bool benchFixed;
+        int threads;
+        int gridColumns;
+        int gridRows;
+        bool latency;
+        const char* trainPath;
+        const char* policyPath;
+        const char* distillPath;
+        float speed;
+        bool soak;
+        int drawEvery;
+        bool stress;
+        float maxDelta;
+        const char* replayToken;
+        const char* tournamentPath;
+        const char* queryPath;
+        bool benchTrajectory;
+        bool events;
+        int serverSessions;
+        bool adaptive;
+
+        Options(void)
+            : demo(false)
+            , rate(winten_constants::FRAME_RATE)
+            , spin(winten_constants::FRAME_SPIN_THRESHOLD)
+            , capturePath(nullptr)
+            , seconds(60.0)
+            , width(640)
+            , height(480)
+            , benchKernels(false)
+            , benchRaster(false)
+            , benchFixed(false)
+            , threads(0)
+            , gridColumns(0)
+            , gridRows(0)
+            , latency(false)
+            , trainPath(nullptr)
+            , policyPath(nullptr)
+            , distillPath(nullptr)
+            , speed(1.0f)
+            , soak(false)
+            , drawEvery(0)
+            , stress(false)
+            , maxDelta(30.0f)
+            , replayToken(nullptr)
+            , tournamentPath(nullptr)
+            , queryPath(nullptr)
+            , benchTrajectory(false)
+            , events(false)
+            , serverSessions(0)
+            , adaptive(false) {}
+    };
+
+    /// <summary>
+    ///     Signal handler requesting shutdown.
+    /// </summary>
+    void onSignal(int)
+    {
+        g_stop = 1;
+    }
+
+    /// <summary>
+    ///     Get the size of the terminal in character cells.
+    /// </summary>
+    /// <param name="columns">Receives the number of columns.</param>
+    /// <param name="rows">Receives the number of rows.</param>
+    void terminalSize(int& columns, int& rows)
+    {
+        columns = 80;
+        rows = 24;
+#ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+        {
+            columns = info.srWindow.Right - info.srWindow.Left + 1;
+            rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+        }
+#else
+        struct winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0)
+        {
+            columns = size.ws_col;
+            rows = size.ws_row;
+        }
+#endif
+    }
+
+    /// <summary>
+    ///     Fit the court to the terminal keeping its aspect ratio, with two
+    ///     pixels per cell vertically and one row left for the shell prompt.
+    /// </summary>
+    /// <param name="view">View to resize, via its controller if it has one.</param>
+    /// <param name="columns">Terminal columns.</param>
+    /// <param name="rows">Terminal rows.</param>
+    template <typename View>
+    void resize(View& view, int columns, int rows)
+    {
+        int height = 2 * (rows - 1);
+        int newWidth;
+        int newHeight;
+
+        if (static_cast<float>(columns) / static_cast<float>(height) > winten_constants::ASPECT_RATIO)
+        {
+            newHeight = height;
+            newWidth = static_cast<int>(winten_constants::ASPECT_RATIO * height);
+        }
+        else
+        {
+            newWidth = columns;
+            newHeight = static_cast<int>(columns / winten_constants::ASPECT_RATIO);
+        }
+
+        view.shutdown();
+        view.initialize(
+            (columns - newWidth) / 2,
+            (rows - 1 - newHeight / 2) / 2,
+            newWidth,
+            newHeight / 2);
+    }
+
+    /// <summary>
+    ///     Create the initial state.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>Intro or demo state.</returns>
+    std::unique_ptr<IState> initialState(const Options& options)
+    {
+        if (options.demo)
+            return std::make_unique<CStateDemo>();
+        return std::make_unique<CStateIntro>();
+    }
+
+    /// <summary>
+    ///     Run in real time drawing to the terminal until interrupted.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    void runTerminal(const Options& options)
+    {
+        ContextController controller;
+        CViewTerminal* view = new CViewTerminal(stdout);
+        int columns;
+        int rows;
+
+#ifdef _WIN32
+        // Enable escape sequence processing in the console
+        DWORD mode = 0;
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        GetConsoleMode(console, &mode);
+        SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        SetConsoleOutputCP(CP_UTF8);
+#endif
+
+        // Create the view and initial state
+        controller.setTimeScale(options.speed);
+        controller.setView(std::unique_ptr<IView>(view));
+        controller.transitionTo(initialState(options));
+        terminalSize(columns, rows);
+        resize(controller, columns, rows);
+
+        // Run the game loop while watching for resizes and signals
+        CSchedulerChrono scheduler(options.rate, options.spin);
+        std::thread gameThread(&ContextController::run, &controller, &scheduler);
+        while (!g_stop)
+        {
+            int newColumns;
+            int newRows;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            terminalSize(newColumns, newRows);
+            if (newColumns != columns || newRows != rows)
+            {
+                columns = newColumns;
+                rows = newRows;
+                resize(controller, columns, rows);
+            }
+        }
+
+        controller.stop();
+        gameThread.join();
+
+        // The intro screen sleeps until its timeout rather than every frame,
+        // and only changed cells are written
+        TimeStats stats = controller.getTimeStats();
+        TerminalStats output = view->getStats();
+        controller.shutdown();
+        std::fprintf(stderr, "%.1f wakeups/s, %.2f%% cpu, %.0f%% idle, %.0f bytes/frame, %llu max\n",
+            stats.wakeupRate(),
+            stats.cpuUsage() * 100.0,
+            stats.wall > 0 ? static_cast<double>(stats.idle) * 100.0 / static_cast<double>(stats.wall) : 0.0,
+            output.bytesPerFrame(),
+            static_cast<unsigned long long>(output.maxBytes));
+    }
+
+    /// <summary>
+    ///     Run on simulated time as fast as possible, writing every frame to a
+    ///     Y4M video.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the output could not be opened or written.</returns>
+    bool runCapture(const Options& options)
+    {
+        ContextController controller;
+        CClockVirtual* clock = new CClockVirtual();
+        CViewFramebuffer* view = new CViewFramebuffer();
+        std::int64_t period = static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / options.rate);
+        long long frames = static_cast<long long>(options.seconds * options.rate);
+        int workers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+        std::FILE* file;
+        bool written;
+
+        file = std::fopen(options.capturePath, "wb");
+        if (file == nullptr)
+        {
+            std::perror(options.capturePath);
+            return false;
+        }
+
+        if (options.threads > 0)
+            view->setThreads(options.threads);
+        controller.setClock(std::unique_ptr<IClock>(clock));
+        controller.setTimeScale(options.speed);
+        controller.setView(std::unique_ptr<IView>(view));
+        controller.transitionTo(initialState(options));
+        controller.initialize(0, 0, options.width, options.height);
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            // Blocking submits apply back-pressure so no frame is lost
+            CFrameCapture capture(
+                file,
+                options.width,
+                options.height,
+                static_cast<int>(options.rate * 1000.0f + 0.5f),
+                1000,
+                8,
+                workers);
+            view->setCapture(&capture, true);
+
+            for (long long frame = 0; frame < frames && !g_stop && capture.getStats().failed == 0; frame++)
+            {
+                clock->advance(period);
+                controller.update();
+            }
+
+            view->setCapture(nullptr, false);
+            written = capture.close();
+
+            CaptureStats stats = capture.getStats();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::fprintf(
+                stderr,
+                "%llu frames in %.2f s (%.1fx real time), %llu submits waited for a buffer, %llu failed to write\n",
+                static_cast<unsigned long long>(stats.written),
+                elapsed,
+                stats.written / options.rate / elapsed,
+                static_cast<unsigned long long>(stats.stalled),
+                static_cast<unsigned long long>(stats.failed));
+        }
+
+        controller.shutdown();
+        written = std::fclose(file) == 0 && written;
+        if (!written)
+            std::fprintf(stderr, "%s: write failed, the video is incomplete\n", options.capturePath);
+        return written;
+    }
+
+    /// <summary>
+    ///     Check every entity of a match is on the court.
+    /// </summary>
+    /// <param name="world">Match to check.</param>
+    /// <returns>True if every position is finite and inside the court.</returns>
+    bool onCourt(const CRegistry& world)
+    {
+        for (std::size_t slot = 0; slot < world.positions.size(); slot++)
+        {
+            const Position& position = world.positions[slot];
+            if (!(position.x >= 0.0f && position.x <= winten_constants::W
+                && position.y >= 0.0f && position.y <= winten_constants::H))
+                return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    ///     Play the demo unthrottled for --seconds of simulated time, ticks
+    ///     running back to back and drawing only one frame in --draw-every to
+    ///     an offscreen framebuffer, or none. Every tick is checked for
+    ///     entities leaving the court, and progress is reported each second.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if any check failed.</returns>
+    bool runSoak(const Options& options)
+    {
+        ContextController controller;
+        std::int64_t target = static_cast<std::int64_t>(options.seconds * winten_constants::TICKS_PER_SECOND);
+        std::uint64_t failures = 0;
+        int points = 0;
+        auto report = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        if (options.drawEvery > 0)
+        {
+            CViewFramebuffer* view = new CViewFramebuffer();
+            if (options.threads > 0)
+                view->setThreads(options.threads);
+            controller.setView(std::unique_ptr<IView>(view));
+        }
+        controller.transitionTo(std::make_unique<CStateDemo>());
+        if (options.drawEvery > 0)
+            controller.initialize(0, 0, options.width, options.height);
+        controller.setUnthrottled(true, options.drawEvery);
+        controller.setEventStats(options.events);
+        controller.resetTimeStats();
+
+        while (controller.getTimeStats().simulated < target && !g_stop)
+        {
+            controller.update();
+
+            const CRegistry& world = controller.getState()->world;
+            if (!onCourt(world))
+                failures++;
+            points = world.score[SIDE_LEFT] + world.score[SIDE_RIGHT];
+
+            if (std::chrono::steady_clock::now() >= report)
+            {
+                TimeStats stats = controller.getTimeStats();
+                report += std::chrono::seconds(1);
+                std::fprintf(
+                    stderr,
+                    "%10.0f simulated s  %8.0fx real time  %d points\n",
+                    stats.simulated * winten_constants::SECONDS_PER_TICK,
+                    stats.speed(),
+                    points);
+            }
+        }
+        if (options.drawEvery > 0)
+            controller.shutdown();
+
+        TimeStats stats = controller.getTimeStats();
+        double wall = stats.wall * static_cast<double>(winten_constants::SECONDS_PER_TICK);
+        std::printf(
+            "%.0f simulated s (%.2f h) in %.2f s: %.0f simulated s per second, %.0f ticks/s, "
+            "%llu frames drawn, %d points, %llu ticks off court\n",
+            stats.simulated * static_cast<double>(winten_constants::SECONDS_PER_TICK),
+            stats.simulated * static_cast<double>(winten_constants::SECONDS_PER_TICK) / 3600.0,
+            wall,
+            stats.speed(),
+            wall > 0.0 ? stats.updates / wall : 0.0,
+            static_cast<unsigned long long>(stats.frames),
+            points,
+            static_cast<unsigned long long>(failures));
+        if (options.events)
+        {
+            EventStats events = controller.getEventStats();
+            std::printf(
+                "events: %llu wall bounces, %llu paddle hits, %llu points, %llu transitions, %llu lost\n",
+                static_cast<unsigned long long>(events.counts[EVENT_WALL_BOUNCE]),
+                static_cast<unsigned long long>(events.counts[EVENT_PADDLE_HIT]),
+                static_cast<unsigned long long>(events.counts[EVENT_SCORE]),
+                static_cast<unsigned long long>(events.counts[EVENT_TRANSITION]),
+                static_cast<unsigned long long>(events.lost));
+        }
+        return failures == 0;
+    }
+
+    /// <summary>
+    ///     Run a grid of demo matches, drawing to the terminal in real time or
+    ///     capturing on simulated time, then report the cost per court.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the output could not be opened or written.</returns>
+    bool runGrid(const Options& options)
+    {
+        CCourtGrid grid(options.gridColumns, options.gridRows);
+        CRenderList courts;
+        std::int64_t period = static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / options.rate);
+        std::unique_ptr<IView> view;
+        std::FILE* file = nullptr;
+        bool written = true;
+
+        grid.buildCourts(courts);
+        if (options.capturePath != nullptr)
+        {
+            long long frames = static_cast<long long>(options.seconds * options.rate);
+            int workers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+            CViewFramebuffer* framebuffer = new CViewFramebuffer();
+
+            file = std::fopen(options.capturePath, "wb");
+            if (file == nullptr)
+            {
+                std::perror(options.capturePath);
+                return false;
+            }
+            view.reset(framebuffer);
+            if (options.threads > 0)
+                framebuffer->setThreads(options.threads);
+            view->setCourt(courts);
+            view->initialize(0, 0, options.width, options.height);
+
+            CFrameCapture capture(
+                file,
+                options.width,
+                options.height,
+                static_cast<int>(options.rate * 1000.0f + 0.5f),
+                1000,
+                8,
+                workers);
+            framebuffer->setCapture(&capture, true);
+            for (long long frame = 0; frame < frames && !g_stop && capture.getStats().failed == 0; frame++)
+            {
+                grid.update(period);
+                grid.build();
+                grid.draw(*view);
+            }
+            framebuffer->setCapture(nullptr, false);
+            written = capture.close();
+        }
+        else
+        {
+            int columns;
+            int rows;
+            CSchedulerChrono scheduler(options.rate, options.spin);
+            auto lastResize = std::chrono::steady_clock::now();
+
+            view.reset(new CViewTerminal(stdout));
+            view->setCourt(courts);
+            terminalSize(columns, rows);
+            resize(*view, columns, rows);
+
+            scheduler.reset();
+            while (!g_stop)
+            {
+                scheduler.wait();
+                grid.update(period);
+                grid.build();
+                grid.draw(*view);
+
+                // Watch for resizes a few times a second
+                if (std::chrono::steady_clock::now() - lastResize > std::chrono::milliseconds(250))
+                {
+                    int newColumns;
+                    int newRows;
+
+                    lastResize = std::chrono::steady_clock::now();
+                    terminalSize(newColumns, newRows);
+                    if (newColumns != columns || newRows != rows)
+                    {
+                        columns = newColumns;
+                        rows = newRows;
+                        resize(*view, columns, rows);
+                    }
+                }
+            }
+        }
+        view->shutdown();
+        if (file != nullptr)
+        {
+            written = std::fclose(file) == 0 && written;
+            if (!written)
+                std::fprintf(stderr, "%s: write failed, the video is incomplete\n", options.capturePath);
+        }
+
+        GridStats stats = grid.getStats();
+        std::fprintf(
+            stderr,
+            "%d courts, %llu frames, per court: update %.0f ns, build %.0f ns, draw %.0f ns, "
+            "total %.0f ns (%.0f courts fit one %.1f Hz frame)\n",
+            stats.courts,
+            static_cast<unsigned long long>(stats.frames),
+            stats.update,
+            stats.build,
+            stats.draw,
+            stats.total(),
+            stats.total() > 0 ? period / stats.total() : 0.0,
+            options.rate);
+        return written;
+    }
+
+    /// <summary>
+    ///     Print one row of latency percentiles in milliseconds.
+    /// </summary>
+    /// <param name="name">Stage name.</param>
+    /// <param name="histogram">Latencies in ticks.</param>
+    void printLatency(const char* name, const CLatencyHistogram& histogram)
+    {
+        const double MS = 1000.0 / winten_constants::TICKS_PER_SECOND;
+
+        std::printf(
+            "%-9s %7llu %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+            name,
+            static_cast<unsigned long long>(histogram.count()),
+            histogram.minimum() * MS,
+            histogram.percentile(0.5) * MS,
+            histogram.percentile(0.9) * MS,
+            histogram.percentile(0.99) * MS,
+            histogram.maximum() * MS,
+            histogram.mean() * MS);
+    }
+
+    /// <summary>
+    ///     Play demo matches in real time into an offscreen framebuffer with
+    ///     the frame budget held by stepping quality, loading every core with
+    ///     busy threads for the middle third of the run. Reports the quality
+    ///     level and frame cost each second, then the transitions made.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    void runAdaptive(const Options& options)
+    {
+        const char* LEVELS[QUALITY_LEVEL_COUNT] = { "full", "no-stats", "no-aa", "half-res", "dirty" };
+        const double MS = 1000.0 / winten_constants::TICKS_PER_SECOND;
+        ContextController controller;
+        CViewFramebuffer* view = new CViewFramebuffer();
+        CSchedulerChrono scheduler(options.rate, options.spin);
+        int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        int seconds = std::max(static_cast<int>(options.seconds), 3);
+        std::atomic<bool> loaded(false);
+        std::vector<std::thread> load;
+
+        if (options.threads > 0)
+            view->setThreads(options.threads);
+        controller.setView(std::unique_ptr<IView>(view));
+        controller.setFrameBudget(static_cast<std::int64_t>(winten_constants::TICKS_PER_SECOND / options.rate));
+        controller.transitionTo(std::make_unique<CStateDemo>());
+        controller.initialize(0, 0, options.width, options.height);
+        std::thread gameThread(&ContextController::run, &controller, &scheduler);
+
+        std::printf(
+            "%dx%d framebuffer at %.2f Hz, %.2f ms budget, %d busy threads from %ds to %ds\n",
+            options.width,
+            options.height,
+            options.rate,
+            1000.0 / options.rate,
+            cores,
+            seconds / 3,
+            2 * seconds / 3);
+        std::printf("%4s %-9s %8s %6s %6s %6s\n", "s", "level", "cost ms", "over", "drop", "load");
+        QualityStats last = controller.getQualityStats();
+        for (int second = 0; second < seconds && !g_stop; second++)
+        {
+            if (second == seconds / 3)
+            {
+                loaded = true;
+                for (int thread = 0; thread < cores; thread++)
+                    load.emplace_back([&loaded]() { while (loaded) {} });
+            }
+            else if (second == 2 * seconds / 3)
+            {
+                loaded = false;
+                for (std::thread& thread : load)
+                    thread.join();
+                load.clear();
+            }
+
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            QualityStats stats = controller.getQualityStats();
+            std::printf(
+                "%4d %-9s %8.2f %6llu %6llu %6s\n",
+                second + 1,
+                LEVELS[stats.level],
+                static_cast<double>(stats.cost) * MS,
+                static_cast<unsigned long long>(stats.overBudget - last.overBudget),
+                static_cast<unsigned long long>(stats.dropped - last.dropped),
+                loaded ? "busy" : "");
+            last = stats;
+        }
+        loaded = false;
+        for (std::thread& thread : load)
+            thread.join();
+
+        controller.stop();
+        gameThread.join();
+        controller.shutdown();
+
+        QualityStats stats = controller.getQualityStats();
+        std::printf("%llu steps down, %llu up\n", static_cast<unsigned long long>(stats.downs), static_cast<unsigned long long>(stats.ups));
+        for (const QualityTransition& transition : stats.transitions)
+            std::printf(
+                "  %8.3f s  %-9s -> %-9s at %.2f ms\n",
+                static_cast<double>(transition.time - stats.transitions.front().time) * MS / 1000.0,
+                LEVELS[transition.from],
+                LEVELS[transition.to],
+                static_cast<double>(transition.cost) * MS);
+        for (int level = 0; level < QUALITY_LEVEL_COUNT; level++)
+            std::printf(
+                "  %-9s %5.1f%% of frames\n",
+                LEVELS[level],
+                stats.frames > 0 ? 100.0 * static_cast<double>(stats.levelFrames[level]) / static_cast<double>(stats.frames) : 0.0);
+    }
+
+    /// <summary>
+    ///     Play the game in real time against synthetic key presses at random
+    ///     intervals, drawing into an offscreen framebuffer, then report how
+    ///     long each input took to reach a presented frame.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    void runLatency(const Options& options)
+    {
+        const double MS = 1000.0 / winten_constants::TICKS_PER_SECOND;
+        ContextController controller;
+        CViewFramebuffer* view = new CViewFramebuffer();
+        CSchedulerChrono scheduler(options.rate, options.spin);
+        std::mt19937 random(std::random_device{}());
+        std::uniform_int_distribution<int> interval(10, 100);
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.seconds);
+
+        if (options.threads > 0)
+            view->setThreads(options.threads);
+        controller.setView(std::unique_ptr<IView>(view));
+        controller.transitionTo(std::make_unique<CStateGame>());
+        controller.initialize(0, 0, options.width, options.height);
+        std::thread gameThread(&ContextController::run, &controller, &scheduler);
+
+        // Press and release up then down, like the window's key messages
+        for (int action = 0; std::chrono::steady_clock::now() < end && !g_stop; action++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval(random)));
+            switch (action % 4)
+            {
+            case 0:
+                controller.keyUp(true);
+                controller.keyPressed();
+                break;
+            case 1:
+                controller.keyUp(false);
+                break;
+            case 2:
+                controller.keyDown(true);
+                controller.keyPressed();
+                break;
+            default:
+                controller.keyDown(false);
+            }
+        }
+
+        controller.stop();
+        gameThread.join();
+        controller.shutdown();
+
+        LatencyStats stats = controller.getLatencyStats();
+        std::printf(
+            "input latency at %.2f Hz (%.2f ms per frame), %dx%d framebuffer\n",
+            options.rate,
+            1000.0 / options.rate,
+            options.width,
+            options.height);
+        std::printf("%-9s %7s %8s %8s %8s %8s %8s %8s\n", "stage ms", "inputs", "min", "p50", "p90", "p99", "max", "mean");
+        printLatency("queued", stats.queued);
+        printLatency("rendered", stats.rendered);
+        printLatency("total", stats.total);
+
+        // Distribution of the total in doubling millisecond buckets
+        std::uint64_t below = 0;
+        std::uint64_t count = stats.total.count();
+        for (int upper = 1; below < count; upper *= 2)
+        {
+            std::int64_t limit = static_cast<std::int64_t>(upper / MS);
+            std::uint64_t next = limit > stats.total.maximum() ? count : stats.total.countBelow(limit);
+
+            std::printf(
+                "%5d-%-4d ms %7llu %s\n",
+                upper / 2,
+                upper,
+                static_cast<unsigned long long>(next - below),
+                std::string(static_cast<std::size_t>(50 * (next - below) / count), '#').c_str());
+            below = next;
+        }
+    }
+
+    /// <summary>
+    ///     Print a training progress line.
+    /// </summary>
+    /// <param name="label">Line label.</param>
+    /// <param name="stats">Counters to print.</param>
+    void printTraining(const char* label, const TrainerStats& stats)
+    {
+        std::printf(
+            "%-10s %12.0f %12.0f %9.3f %10llu %10llu\n",
+            label,
+            stats.stepsPerSecond(),
+            stats.stepsPerSecondPerCore(),
+            stats.hitRate(),
+            static_cast<unsigned long long>(stats.hits),
+            static_cast<unsigned long long>(stats.misses));
+    }
+
+    /// <summary>
+    ///     Describe the invariants broken in a violation mask.
+    /// </summary>
+    /// <param name="violations">Mask of StressViolation bits.</param>
+    /// <returns>Names separated by plus signs.</returns>
+    std::string violationNames(std::uint8_t violations)
+    {
+        std::string result;
+
+        if (violations & VIOLATION_FIELD)
+            result += "left field";
+        if (violations & VIOLATION_TUNNEL)
+            result += result.empty() ? "through paddle" : "+through paddle";
+        if (violations & VIOLATION_STUCK)
+            result += result.empty() ? "stuck on paddle" : "+stuck on paddle";
+        return result;
+    }
+
+    /// <summary>
+    ///     Stress the physics with randomized matches on every core for
+    ///     --seconds, reporting ticks checked per second each second, then
+    ///     minimize the first failures into replay tokens.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if any invariant failed.</returns>
+    bool runStress(const Options& options)
+    {
+        const std::size_t MINIMIZED = 8;
+        StressSettings settings;
+        std::vector<StressFailure> failures;
+        StressStats last;
+        auto start = std::chrono::steady_clock::now();
+        auto report = start + std::chrono::seconds(1);
+        double elapsed = 0.0;
+
+        settings.threads = options.threads > 0
+            ? options.threads
+            : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        settings.maxDelta = options.maxDelta / 1000.0f;
+        CStress stress(settings);
+
+        std::printf(
+            "stressing %d matches at a time on %d threads for %.0f s, steps up to %.1f ms\n",
+            settings.lanes * settings.threads,
+            settings.threads,
+            options.seconds,
+            options.maxDelta);
+        std::printf("%-8s %14s %14s %12s %10s\n", "", "ticks/s", "ticks/s/core", "matches", "failures");
+        while (elapsed < options.seconds && !g_stop)
+        {
+            stress.round();
+            std::vector<StressFailure> found = stress.takeFailures();
+            failures.insert(failures.end(), found.begin(), found.end());
+
+            auto now = std::chrono::steady_clock::now();
+            elapsed = std::chrono::duration<double>(now - start).count();
+            if (now >= report || elapsed >= options.seconds)
+            {
+                StressStats stats = stress.getStats();
+                double seconds = stats.seconds - last.seconds;
+                double rate = seconds > 0 ? (stats.ticks - last.ticks) / seconds : 0.0;
+
+                std::printf(
+                    "%6.0f s %14.0f %14.0f %12llu %10llu\n",
+                    elapsed,
+                    rate,
+                    rate / stats.threads,
+                    static_cast<unsigned long long>(stats.matches),
+                    static_cast<unsigned long long>(stats.failures));
+                last = stats;
+                report = now + std::chrono::seconds(1);
+            }
+        }
+
+        StressStats stats = stress.getStats();
+        std::printf(
+            "%llu ticks of %llu matches checked at %.0f ticks/s, %llu failures\n",
+            static_cast<unsigned long long>(stats.ticks),
+            static_cast<unsigned long long>(stats.matches),
+            stats.ticksPerSecond(),
+            static_cast<unsigned long long>(stats.failures));
+
+        // Replay tokens keep only the irregular steps each failure needs
+        for (std::size_t index = 0; index < failures.size() && index < MINIMIZED && !g_stop; index++)
+        {
+            StressFailure minimized = stress.minimize(failures[index]);
+            if (minimized.violations == 0)
+            {
+                std::printf("seed %llu did not fail again\n", static_cast<unsigned long long>(failures[index].seed));
+                continue;
+            }
+            std::printf(
+                "%s at tick %d, %zu of %d irregular steps needed: --stress-replay %s\n",
+                violationNames(minimized.violations).c_str(),
+                minimized.tick,
+                minimized.kept.size(),
+                minimized.irregular,
+                minimized.token().c_str());
+        }
+        return stats.failures == 0;
+    }
+
+    /// <summary>
+    ///     Replay one stress match from its token and print the ball, its
+    ///     heading and the paddles for the ticks leading to the failure.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the token is malformed.</returns>
+    bool runStressReplay(const Options& options)
+    {
+        const int SHOWN = 8;
+        StressSettings settings;
+        StressFailure failure;
+        std::vector<CRegistry> trace;
+
+        if (!failure.parse(options.replayToken))
+        {
+            std::fprintf(stderr, "bad replay token %s\n", options.replayToken);
+            return false;
+        }
+        // The token carries the step limit the failure was found with
+        settings.maxDelta = failure.maxDelta;
+        CStress stress(settings);
+        StressFailure result = stress.replay(failure, &trace);
+
+        std::printf("%6s %9s %9s %6s %6s %9s %9s\n", "tick", "ball x", "ball y", "angle", "left", "paddle 1", "paddle 2");
+        for (int tick = std::max(static_cast<int>(trace.size()) - SHOWN, 0); tick < static_cast<int>(trace.size()); tick++)
+        {
+            const CRegistry& world = trace[tick];
+            const Velocity& velocity = world.velocities[0];
+            const Position& ball = world.positions.get(world.velocities.entity(0));
+
+            std::printf(
+                "%6d %9.3f %9.3f %6d %6s %9.3f %9.3f\n",
+                tick,
+                ball.x,
+                ball.y,
+                velocity.angle,
+                velocity.left ? "yes" : "no",
+                world.positions[0].y,
+                world.positions[1].y);
+        }
+        if (result.violations != 0)
+            std::printf("%s at tick %d\n", violationNames(result.violations).c_str(), result.tick);
+        else
+            std::printf("no failure in %zu ticks\n", trace.size());
+        if (result.violations == 0 || result.tick != failure.tick)
+            std::printf("the token recorded a failure at tick %d\n", failure.tick);
+        return true;
+    }
+
+    /// <summary>
+    ///     Play one tournament match to five points between two controllers
+    ///     chosen by its seed, appending each rally and then the match.
+    /// </summary>
+    /// <param name="seed">Seed of the match.</param>
+    /// <param name="policy">Policy some paddles play, or nullptr.</param>
+    /// <param name="store">Store to append to.</param>
+    /// <returns>Number of rallies played, or -1 if the store is full.</returns>
+    int playTournamentMatch(std::uint64_t seed, std::shared_ptr<const IPolicy> policy, CResultStore& store)
+    {
+        const int WINNING_SCORE = 5;
+        const int MAX_TICKS = static_cast<int>(600 * winten_constants::TICK_RATE);
+        const float HORIZONS[] = { 0.15f, 0.3f, 0.5f, 1.0f };
+        const float delta = 1.0f / winten_constants::TICK_RATE;
+        CRegistry world;
+        Controller controllers[SIDE_COUNT];
+        MatchRecord match = {};
+        RallyRecord rally = {};
+        systems::Input input = { false, false };
+        int start = 0;
+        float angleSum = 0.0f;
+        bool stored = true;
+
+        world.seed(seed);
+        world.policy = policy;
+        for (int side = 0; side < SIDE_COUNT; side++)
+        {
+            bool learned = policy && world.random() % 3 == 0;
+            float horizon = HORIZONS[world.random() % 4] * winten_constants::W;
+            Controller controller = {
+                learned ? CONTROLLER_POLICY : CONTROLLER_TRACKING,
+                winten_constants::PADDLE_SPEED,
+                horizon,
+                false,
+                ACTION_STAY };
+            controllers[side] = controller;
+        }
+        Velocity serve = {
+            winten_constants::BALL_SPEED,
+            static_cast<int>(world.random() % angle_table::STEPS),
+            (world.random() & 1) != 0 };
+        systems::createPaddle(world, winten_constants::PADDLE_X_NPC, &controllers[SIDE_LEFT]);
+        systems::createPaddle(world, winten_constants::PADDLE_X_PLAYER, &controllers[SIDE_RIGHT]);
+        systems::createBall(world, winten_constants::W / 2.0f, winten_constants::H / 2.0f, &serve);
+
+        rally.seed = seed;
+        EventCursor events = world.events.subscribe();
+        bool over = false;
+        int tick = 0;
+        for (; tick < MAX_TICKS && !over; tick++)
+        {
+            systems::step(world, input, delta);
+            while (const GameEvent* event = world.events.next(events))
+            {
+                if (event->type == EVENT_PADDLE_HIT)
+                {
+                    float angle = std::fabs(angle_table::direction(event->value).angle) * 180.0f / winten_constants::PI;
+                    rally.hits++;
+                    angleSum += angle;
+                    rally.maxAngle = std::max(rally.maxAngle, angle);
+                }
+                else if (event->type == EVENT_SCORE && !over)
+                {
+                    // A point ends the rally
+                    rally.winner = event->value;
+                    rally.duration = (tick + 1 - start) * delta;
+                    rally.meanAngle = rally.hits > 0 ? angleSum / rally.hits : 0.0f;
+                    stored = store.append(rally) && stored;
+                    start = tick + 1;
+                    rally.rally++;
+                    rally.hits = 0;
+                    rally.maxAngle = 0.0f;
+                    angleSum = 0.0f;
+                    over = world.score[SIDE_LEFT] >= WINNING_SCORE || world.score[SIDE_RIGHT] >= WINNING_SCORE;
+                }
+            }
+        }
+
+        match.seed = seed;
+        match.npcController = controllers[SIDE_LEFT].kind;
+        match.playerController = controllers[SIDE_RIGHT].kind;
+        match.npcHorizon = controllers[SIDE_LEFT].horizon;
+        match.playerHorizon = controllers[SIDE_RIGHT].horizon;
+        match.scoreNpc = world.score[SIDE_LEFT];
+        match.scorePlayer = world.score[SIDE_RIGHT];
+        match.rallies = rally.rally;
+        match.duration = tick * delta;
+        stored = store.append(match) && stored;
+        return stored ? rally.rally : -1;
+    }
+
+    /// <summary>
+    ///     Play tournament matches on every core for --seconds, every thread
+    ///     appending its results to the same store, reporting each second.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <param name="policy">Policy some paddles play, or nullptr.</param>
+    /// <returns>False if the store could not be opened or filled up.</returns>
+    bool runTournament(const Options& options, std::shared_ptr<const IPolicy> policy)
+    {
+        int threads = options.threads > 0
+            ? options.threads
+            : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        CThreadPool pool(threads);
+        CResultStore store;
+        std::vector<std::uint64_t> played(static_cast<std::size_t>(threads));
+        std::atomic<std::uint64_t> rallies(0);
+        std::atomic<bool> full(false);
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+
+        if (!store.open(options.tournamentPath, true))
+        {
+            std::fprintf(stderr, "cannot open %s.matches and %s.rallies\n", options.tournamentPath, options.tournamentPath);
+            return false;
+        }
+        // Seeds continue after the matches already stored
+        std::uint64_t base = store.matches().rows();
+
+        std::printf("%-8s %12s %12s %12s\n", "", "matches", "rallies", "rows/s");
+        while (elapsed < options.seconds && !g_stop && !full)
+        {
+            auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            std::uint64_t before = store.matches().rows() + store.rallies().rows();
+
+            pool.run(threads, [&](int worker) {
+                std::uint64_t count = 0;
+                while (std::chrono::steady_clock::now() < end && !g_stop && !full)
+                {
+                    std::uint64_t seed = base + played[worker]++ * threads + worker;
+                    int matchRallies = playTournamentMatch(seed, policy, store);
+                    if (matchRallies < 0)
+                        full = true;
+                    else
+                        count += matchRallies;
+                }
+                rallies += count;
+            });
+
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf(
+                "%6.0f s %12llu %12llu %12.0f\n",
+                elapsed,
+                static_cast<unsigned long long>(store.matches().rows()),
+                static_cast<unsigned long long>(store.rallies().rows()),
+                static_cast<double>(store.matches().rows() + store.rallies().rows() - before));
+        }
+        store.close();
+        if (full)
+        {
+            std::fprintf(stderr, "%s.matches or %s.rallies is full\n", options.tournamentPath, options.tournamentPath);
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    ///     Run one aggregate query and print its result and scan rate.
+    /// </summary>
+    /// <param name="label">Query description.</param>
+    /// <param name="table">Table to query.</param>
+    /// <param name="column">Column to aggregate.</param>
+    /// <param name="filter">Filter column, or nullptr for every row.</param>
+    /// <param name="low">Lowest filter value.</param>
+    /// <param name="high">Highest filter value.</param>
+    void printQuery(
+        const char* label,
+        CColumnStore& table,
+        const char* column,
+        const char* filter,
+        double low,
+        double high)
+    {
+        ColumnFilter range = { filter != nullptr ? table.column(filter) : -1, low, high };
+        auto start = std::chrono::steady_clock::now();
+        ColumnAggregate result = table.aggregate(table.column(column), filter != nullptr ? &range : nullptr);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf(
+            "%-34s %11llu %10.3f %10.3f %10.3f %8.2f %8.2f %6llu %6llu\n",
+            label,
+            static_cast<unsigned long long>(result.count),
+            result.mean(),
+            result.minimum,
+            result.maximum,
+            seconds * 1000.0,
+            seconds > 0 ? result.bytesRead / seconds / 1e9 : 0.0,
+            static_cast<unsigned long long>(result.blocksScanned),
+            static_cast<unsigned long long>(result.blocksSkipped));
+    }
+
+    /// <summary>
+    ///     Print aggregates of a tournament's results, timing each scan.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the store could not be opened.</returns>
+    bool runQuery(const Options& options)
+    {
+        CResultStore store;
+
+        if (!store.open(options.queryPath, false))
+        {
+            std::fprintf(stderr, "cannot open %s.matches and %s.rallies\n", options.queryPath, options.queryPath);
+            return false;
+        }
+        CColumnStore& matches = store.matches();
+        CColumnStore& rallies = store.rallies();
+        double lastSeeds = static_cast<double>(matches.rows()) * 0.99;
+
+        std::printf(
+            "%llu matches, %llu rallies\n",
+            static_cast<unsigned long long>(matches.rows()),
+            static_cast<unsigned long long>(rallies.rows()));
+        std::printf(
+            "%-34s %11s %10s %10s %10s %8s %8s %6s %6s\n",
+            "query", "rows", "mean", "min", "max", "ms", "GB/s", "blocks", "skip");
+        printQuery("match duration s", matches, "duration", nullptr, 0.0, 0.0);
+        printQuery("rally hits", rallies, "hits", nullptr, 0.0, 0.0);
+        printQuery("rally hit angle deg", rallies, "meanAngle", "hits", 1.0, 1e9);
+        printQuery("hits of rallies over 30 s", rallies, "hits", "duration", 30.0, 1e9);
+        printQuery("NPC points, NPC horizon 0.15 W", matches, "scoreNpc", "npcHorizon", 0.1 * winten_constants::W, 0.2 * winten_constants::W);
+        printQuery("NPC points, NPC horizon 1.0 W", matches, "scoreNpc", "npcHorizon", 0.9 * winten_constants::W, 1.1 * winten_constants::W);
+        printQuery("rally hits, last 1% of seeds", rallies, "hits", "seed", lastSeeds, 1e30);
+        store.close();
+        return true;
+    }
+
+    /// <summary>
+    ///     Host many sessions at once, a third each starting on the intro,
+    ///     demo and game states, pressing keys in random sessions, and report
+    ///     the workers' load each second.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the build has no session host.</returns>
+    bool runServer(const Options& options)
+    {
+#if WINTEN_COROUTINES
+        const int INPUTS_PER_SECOND = 500;
+        const auto INTERVAL = std::chrono::milliseconds(10);
+        CSessionHost host(options.threads, winten_constants::TICK_RATE);
+        std::vector<CSessionHost::SessionId> ids;
+        std::mt19937 random(1);
+
+        for (int index = 0; index < options.serverSessions; index++)
+        {
+            std::unique_ptr<IState> state;
+            if (index % 3 == 0)
+                state = std::make_unique<CStateIntro>();
+            else if (index % 3 == 1)
+                state = std::make_unique<CStateDemo>();
+            else
+                state = std::make_unique<CStateGame>();
+            ids.push_back(host.open(std::move(state)));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration<double>(options.seconds);
+        auto report = start + std::chrono::seconds(1);
+        auto next = start;
+        HostStats last = host.getStats();
+        double sent = 0.0;
+        std::printf(
+            "%d sessions on %d threads\n%8s %12s %8s %8s %10s %8s %10s %10s\n",
+            options.serverSessions,
+            host.threads(),
+            "sessions", "ticks/s", "idle/s", "busy %", "steals/s", "missed", "late us", "max us");
+        while (std::chrono::steady_clock::now() < end && !g_stop)
+        {
+            next += INTERVAL;
+            std::this_thread::sleep_until(next);
+
+            // Key presses move intro sessions to games and demos to the intro
+            for (sent += INPUTS_PER_SECOND * std::chrono::duration<double>(INTERVAL).count(); sent >= 1.0; sent -= 1.0)
+            {
+                std::uint32_t bits = random();
+                SessionInput keys = { (bits & 1) != 0, (bits & 2) != 0, false, (bits & 12) == 0 };
+                host.input(ids[(bits >> 4) % ids.size()], keys);
+            }
+
+            if (std::chrono::steady_clock::now() >= report)
+            {
+                HostStats stats = host.getStats();
+                std::uint64_t ticks = stats.ticks - last.ticks;
+                report += std::chrono::seconds(1);
+                std::printf(
+                    "%8llu %12llu %8llu %8.1f %10llu %8llu %10.1f %10.1f\n",
+                    static_cast<unsigned long long>(stats.sessions),
+                    static_cast<unsigned long long>(ticks),
+                    static_cast<unsigned long long>(stats.idles - last.idles),
+                    (stats.busy - last.busy) * 100.0 / (winten_constants::TICKS_PER_SECOND * static_cast<double>(host.threads())),
+                    static_cast<unsigned long long>(stats.steals - last.steals),
+                    static_cast<unsigned long long>(stats.missed - last.missed),
+                    ticks > 0 ? (stats.totalLateness - last.totalLateness) / 1000.0 / ticks : 0.0,
+                    stats.maxLateness / 1000.0);
+                last = stats;
+            }
+        }
+        return true;
+#else
+        (void)options;
+        std::fprintf(stderr, "--server needs a C++20 build\n");
+        return false;
+#endif
+    }
+
+    /// <summary>
+    ///     Train a paddle policy offline for the given wall time, reporting
+    ///     throughput and how often the learner returns the ball each second,
+    ///     then compare it with the tracking rule and save it.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <returns>False if the policy could not be saved.</returns>
+    bool runTraining(const Options& options)
+    {
+        const float EXPLORATION_START = 0.2f;
+        const float EXPLORATION_END = 0.01f;
+        const int EVALUATION_FRAMES = 60 * static_cast<int>(winten_constants::FRAME_RATE);
+        TrainerSettings settings;
+        TrainerStats last;
+        char label[32];
+        auto start = std::chrono::steady_clock::now();
+        auto report = start + std::chrono::seconds(1);
+        double elapsed = 0.0;
+
+        settings.threads = options.threads > 0
+            ? options.threads
+            : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        settings.matches = std::max(settings.matches, 16 * settings.threads);
+        CTrainer trainer(settings);
+
+        std::printf(
+            "training %d matches on %d threads for %.0f s\n",
+            settings.matches,
+            settings.threads,
+            options.seconds);
+        std::printf("%-10s %12s %12s %9s %10s %10s\n", "", "steps/s", "steps/s/core", "hit rate", "hits", "misses");
+        while (elapsed < options.seconds && !g_stop)
+        {
+            float progress = static_cast<float>(elapsed / options.seconds);
+            trainer.round(EXPLORATION_START + (EXPLORATION_END - EXPLORATION_START) * progress);
+
+            // Report the last second and publish a snapshot
+            auto now = std::chrono::steady_clock::now();
+            elapsed = std::chrono::duration<double>(now - start).count();
+            if (now >= report || elapsed >= options.seconds)
+            {
+                TrainerStats stats = trainer.getStats();
+                TrainerStats interval = stats;
+
+                interval.steps -= last.steps;
+                interval.hits -= last.hits;
+                interval.misses -= last.misses;
+                interval.seconds -= last.seconds;
+                std::snprintf(label, sizeof(label), "%.0f s", elapsed);
+                printTraining(label, interval);
+                trainer.snapshot();
+                last = stats;
+                report = now + std::chrono::seconds(1);
+            }
+        }
+        printTraining("overall", trainer.getStats());
+
+        // Greedy play over fresh matches against the rule it replaces
+        std::shared_ptr<const CPolicyTabular> policy = trainer.snapshot();
+        printTraining("policy", trainer.evaluate(policy, settings.matches, EVALUATION_FRAMES));
+        printTraining("tracking", trainer.evaluate(nullptr, settings.matches, EVALUATION_FRAMES));
+        return policy->save(options.trainPath);
+    }
+
+    /// <summary>
+    ///     Load a saved policy of whichever kind the file holds.
+    /// </summary>
+    /// <param name="path">Policy file.</param>
+    /// <returns>The policy, or nullptr if it could not be read.</returns>
+    std::shared_ptr<IPolicy> loadPolicy(const char* path)
+    {
+        char magic[4] = {};
+        std::FILE* file = std::fopen(path, "rb");
+
+        if (file == nullptr)
+            return nullptr;
+        std::size_t read = std::fread(magic, 1, sizeof(magic), file);
+        std::fclose(file);
+        if (read == sizeof(magic) && std::memcmp(magic, "WTM1", sizeof(magic)) == 0)
+        {
+            std::shared_ptr<CPolicyMLP> policy = std::make_shared<CPolicyMLP>();
+            return policy->load(path) ? policy : nullptr;
+        }
+        std::shared_ptr<CPolicyTabular> policy = std::make_shared<CPolicyTabular>();
+        return policy->load(path) ? policy : nullptr;
+    }
+
+    /// <summary>
+    ///     Time one policy decision, made singly or a block at a time, over the
+    ///     given observations for at least a quarter of a second.
+    /// </summary>
+    /// <param name="policy">Policy to time.</param>
+    /// <param name="samples">Observations to decide on.</param>
+    /// <param name="batch">Make the decisions in blocks rather than singly.</param>
+    /// <returns>Nanoseconds per decision.</returns>
+    double timeDecisions(const IPolicy& policy, const std::vector<Observation>& samples, bool batch)
+    {
+        const int BLOCK = 64;
+        PolicyAction actions[BLOCK];
+        std::uint64_t decisions = 0;
+        unsigned checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+
+        do
+        {
+            for (std::size_t index = 0; index + BLOCK <= samples.size(); index += BLOCK)
+            {
+                if (batch)
+                    policy.actBatch(&samples[index], BLOCK, actions);
+                else
+                {
+                    for (int lane = 0; lane < BLOCK; lane++)
+                        actions[lane] = policy.act(samples[index + lane]);
+                }
+                checksum += actions[index % BLOCK];
+            }
+            decisions += samples.size() / BLOCK * BLOCK;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 0.25);
+
+        // Keep the decisions observable so they are not optimised away
+        if (checksum == ~0u)
+            std::printf(" ");
+        return decisions > 0 ? elapsed * 1e9 / decisions : 0.0;
+    }
+
+    /// <summary>
+    ///     Fit a network policy to the situations a tabular policy meets in
+    ///     play, compare the two on fresh matches, time the network's decisions
+    ///     with each kernel variant and save it.
+    /// </summary>
+    /// <param name="options">Command line settings.</param>
+    /// <param name="teacher">Policy to imitate.</param>
+    /// <returns>False if the network could not be saved.</returns>
+    bool runDistill(const Options& options, std::shared_ptr<const IPolicy> teacher)
+    {
+        const int MATCHES = 128;
+        const int FRAMES = 60 * static_cast<int>(winten_constants::FRAME_RATE);
+        const int INTERVAL = 4;
+        const int ROUNDS = 4;
+        const int EPOCHS = 6;
+        const float LEARNING_RATE = 0.005f;
+        TrainerSettings settings;
+        std::shared_ptr<CPolicyMLP> student = std::make_shared<CPolicyMLP>();
+
+        settings.threads = options.threads > 0
+            ? options.threads
+            : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        CTrainer trainer(settings);
+        std::vector<Observation> samples = trainer.collect(teacher, MATCHES, FRAMES, INTERVAL);
+
+        // Later rounds add the situations the network gets itself into,
+        // labelled by the teacher, so it learns to recover from its mistakes
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            if (round > 0)
+            {
+                std::vector<Observation> visited = trainer.collect(student, MATCHES, FRAMES, INTERVAL);
+                samples.insert(samples.end(), visited.begin(), visited.end());
+            }
+            float agreement = student->distill(*teacher, samples, EPOCHS, LEARNING_RATE, settings.seed);
+            std::printf("round %d: %llu samples, held-out agreement %.3f\n",
+                round + 1,
+                static_cast<unsigned long long>(samples.size()),
+                agreement);
+        }
+
+        std::printf("%-10s %12s %12s %9s %10s %10s\n", "", "steps/s", "steps/s/core", "hit rate", "hits", "misses");
+        printTraining("network", trainer.evaluate(student, MATCHES, FRAMES));
+        printTraining("tabular", trainer.evaluate(teacher, MATCHES, FRAMES));
+
+        std::printf("\n%-10s %12s %12s\n", "decision", "single ns", "batched ns");
+        std::printf("%-10s %12.1f %12.1f\n",
+            "tabular",
+            timeDecisions(*teacher, samples, false),
+            timeDecisions(*teacher, samples, true));
+        for (const CPolicyMLP::Kernel* kernel : CPolicyMLP::kernels())
+        {
+            student->setKernel(kernel);
+            std::printf("%-10s %12.1f %12.1f\n",
+                kernel->name,
+                timeDecisions(*student, samples, false),
+                timeDecisions(*student, samples, true));
+        }
+        student->setKernel(CPolicyMLP::kernels().back());
+        return student->save(options.distillPath);
+    }
+
+    /// <summary>
+    ///     Time a kernel pass over a whole frame, repeated for at least a
+    ///     quarter of a second.
+    /// </summary>
+    /// <param name="pass">Draws one frame.</param>
+    /// <returns>Mean milliseconds per frame.</returns>
+    template <typename Pass>
+    double timeFrames(Pass pass)
+    {
+        auto start = std::chrono::steady_clock::now();
+        double elapsed;
+        long long frames = 0;
+
+        do
+        {
+            pass();
+            frames++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 0.25);
+        return elapsed * 1000.0 / frames;
+    }
+
+    /// <summary>
+    ///     Benchmark every supported raster kernel variant over whole frames at
+    ///     common viewport sizes and check they agree.
+    /// </summary>
+    void benchKernels(void)
+    {
+        const int SIZES[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+        std::vector<const RasterKernels*> variants = raster_kernels::supported();
+
+        std::printf("selected kernels: %s\n", raster_kernels::selected().name);
+        std::printf("%-10s %-7s %12s %12s %12s\n", "size", "kernels", "fill ms", "circle ms", "mask ms");
+        for (const auto& size : SIZES)
+        {
+            int width = size[0];
+            int height = size[1];
+            std::size_t count = static_cast<std::size_t>(width) * height;
+            std::vector<std::uint32_t> pixels(count);
+            std::vector<std::uint32_t> reference;
+            std::vector<std::uint8_t> mask(static_cast<std::size_t>(width));
+            float radius = height / 2.0f - 1.0f;
+
+            // Coverage ramp with runs of empty and full mask like rendered text
+            for (int x = 0; x < width; x++)
+                mask[x] = static_cast<std::uint8_t>(x % 48 < 16 ? 0 : (x % 48 < 32 ? 255 : (x * 7) & 0xFF));
+
+            for (const RasterKernels* kernels : variants)
+            {
+                double fill = timeFrames([&]() {
+                    for (int y = 0; y < height; y++)
+                        kernels->fillSpan(&pixels[static_cast<std::size_t>(y) * width], width, winten_constants::COLOUR_BACKGROUND);
+                });
+                // A circle filling the frame height, blended over its bounding box
+                double circle = timeFrames([&]() {
+                    for (int y = 0; y < height; y++)
+                    {
+                        float dy = y + 0.5f - height / 2.0f;
+                        kernels->circleSpan(
+                            &pixels[static_cast<std::size_t>(y) * width],
+                            width,
+                            0.5f - width / 2.0f,
+                            dy * dy,
+                            radius,
+                            winten_constants::COLOUR_FOREGROUND);
+                    }
+                });
+                double blit = timeFrames([&]() {
+                    for (int y = 0; y < height; y++)
+                        kernels->maskSpan(&pixels[static_cast<std::size_t>(y) * width], mask.data(), width, 0xFF808080);
+                });
+
+                // Redraw a known frame to compare against the scalar result
+                for (int y = 0; y < height; y++)
+                {
+                    float dy = y + 0.5f - height / 2.0f;
+                    std::uint32_t* row = &pixels[static_cast<std::size_t>(y) * width];
+                    kernels->fillSpan(row, width, winten_constants::COLOUR_BACKGROUND);
+                    kernels->circleSpan(row, width, 0.5f - width / 2.0f, dy * dy, radius, winten_constants::COLOUR_FOREGROUND);
+                    kernels->maskSpan(row, mask.data(), width, 0xFF808080);
+                }
+                bool matches = reference.empty() || reference == pixels;
+                if (reference.empty())
+                    reference = pixels;
+
+                std::printf(
+                    "%4dx%-5d %-7s %12.3f %12.3f %12.3f%s\n",
+                    width,
+                    height,
+                    kernels->name,
+                    fill,
+                    circle,
+                    blit,
+                    matches ? "" : "  MISMATCH");
+            }
+        }
+    }
+
+    /// <summary>
+    ///     Benchmark drawing a demo frame with the tiled rasterizer at common
+    ///     viewport sizes, doubling the thread count up to the core count.
+    /// </summary>
+    void benchRaster(void)
+    {
+        const int SIZES[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+        int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        CStateDemo state;
+        CFrameBuilder builder;
+        const CRenderList& list = builder.build(&state, winten_constants::FRAME_RATE, 0.0f, 1.0f);
+
+        std::printf("%-10s %8s %12s %10s\n", "size", "threads", "frame ms", "speedup");
+        for (const auto& size : SIZES)
+        {
+            CViewFramebuffer view;
+            double single = 0.0;
+
+            view.initialize(0, 0, size[0], size[1]);
+            for (int threads = 1;; threads = std::min(threads * 2, cores))
+            {
+                view.setThreads(threads);
+                double frame = timeFrames([&]() { view.DrawAll(list); });
+                if (threads == 1)
+                    single = frame;
+                std::printf("%4dx%-5d %8d %12.3f %9.2fx\n", size[0], size[1], threads, frame, single / frame);
+                if (threads == cores)
+                    break;
+            }
+            view.shutdown();
+        }
+    }
+
+    /// <summary>
+    ///     Bits of a coordinate, for hashing match state.
+    /// </summary>
+    std::uint32_t bits(float value)
+    {
+        std::uint32_t result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+
+    std::uint32_t bits(CFixed value)
+    {
+        return static_cast<std::uint32_t>(value.raw());
+    }
+
+    /// <summary>
+    ///     Play seeded matches between two tracking paddles in one scalar type,
+    ///     hashing every position after every frame and the final scores.
+    /// </summary>
+    /// <param name="matches">Number of matches, seeded 0 upwards.</param>
+    /// <param name="frames">Frames each match lasts.</param>
+    /// <param name="seconds">Receives the wall time spent stepping.</param>
+    /// <returns>FNV-1a hash of the matches.</returns>
+    template <typename T>
+    std::uint64_t playSeeded(int matches, int frames, double& seconds)
+    {
+        const typename CBasicRegistry<T>::Controller tracking = {
+            CONTROLLER_TRACKING,
+            T(winten_constants::PADDLE_SPEED),
+            T(winten_constants::NPC_HORIZON),
+            false,
+            ACTION_STAY };
+        const T delta = T(1.0f / winten_constants::FRAME_RATE);
+        const systems::Input input = { false, false };
+        std::uint64_t hash = 14695981039346656037ull;
+
+        seconds = 0.0;
+        for (int match = 0; match < matches; match++)
+        {
+            CBasicRegistry<T> world;
+            // Serve at a different angle each match
+            typename CBasicRegistry<T>::Velocity serve = {
+                T(winten_constants::BALL_SPEED),
+                angle_table::ZERO + (match * 37) % (angle_table::STEPS / 2),
+                match % 2 == 0 };
+
+            world.seed(static_cast<std::uint64_t>(match));
+            systems::createPaddle(world, T(winten_constants::PADDLE_X_NPC), &tracking);
+            systems::createPaddle(world, T(winten_constants::PADDLE_X_PLAYER), &tracking);
+            systems::createBall(world, T(winten_constants::W / 2.0f), T(winten_constants::H / 2.0f), &serve);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                systems::step(world, input, delta);
+                for (std::size_t slot = 0; slot < world.positions.size(); slot++)
+                {
+                    hash = (hash ^ bits(world.positions[slot].x)) * 1099511628211ull;
+                    hash = (hash ^ bits(world.positions[slot].y)) * 1099511628211ull;
+                }
+            }
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            hash = (hash ^ static_cast<std::uint64_t>(world.score[SIDE_LEFT])) * 1099511628211ull;
+            hash = (hash ^ static_cast<std::uint64_t>(world.score[SIDE_RIGHT])) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// <summary>
+    ///     Compare the float and fixed-point match cores. Seeded matches are
+    ///     hashed frame by frame: the fixed-point digest is the same from every
+    ///     compiler, optimisation level and processor, where the float one
+    ///     need not be. Then time ball movement over a large batch with each
+    ///     SIMD kernel variant in both types.
+    /// </summary>
+    void benchFixed(void)
+    {
+        const int MATCHES = 16;
+        const int FRAMES = 60000;
+        const int BALLS = 4096;
+        const int BALL_FRAMES = 1000;
+        const float top = winten_constants::BALL_MIN_Y;
+        const float bottom = winten_constants::BALL_MAX_Y;
+        const float distance = winten_constants::BALL_SPEED / winten_constants::FRAME_RATE;
+        double floatSeconds;
+        double fixedSeconds;
+        std::uint64_t floatDigest = playSeeded<float>(MATCHES, FRAMES, floatSeconds);
+        std::uint64_t fixedDigest = playSeeded<CFixed>(MATCHES, FRAMES, fixedSeconds);
+        double steps = static_cast<double>(MATCHES) * FRAMES;
+
+        std::printf("%-14s %18s %14s\n", "match core", "digest", "steps/s");
+        std::printf("%-14s   %016llx %14.0f\n", "float", static_cast<unsigned long long>(floatDigest), steps / floatSeconds);
+        std::printf("%-14s   %016llx %14.0f\n", "fixed Q16.16", static_cast<unsigned long long>(fixedDigest), steps / fixedSeconds);
+
+        // Balls spread over the field at every angle of the grid
+        std::vector<float> floatX(BALLS);
+        std::vector<float> floatY(BALLS);
+        std::vector<float> floatStepX(BALLS);
+        std::vector<float> floatStepY(BALLS);
+        std::vector<std::int32_t> fixedX(BALLS);
+        std::vector<std::int32_t> fixedY(BALLS);
+        std::vector<std::int32_t> fixedStepX(BALLS);
+        std::vector<std::int32_t> fixedStepY(BALLS);
+        std::vector<std::int32_t> reference;
+        auto reset = [&]() {
+            for (int ball = 0; ball < BALLS; ball++)
+            {
+                int step = ball % angle_table::STEPS;
+                const angle_table::Direction& direction = angle_table::direction(step);
+                const angle_table::FixedDirection& fixedDirection = angle_table::fixedDirection(step);
+
+                floatX[ball] = winten_constants::W / 2.0f;
+                floatY[ball] = top + (bottom - top) * ball / BALLS;
+                floatStepX[ball] = direction.x * distance;
+                floatStepY[ball] = direction.y * distance;
+                fixedX[ball] = CFixed(floatX[ball]).raw();
+                fixedY[ball] = CFixed(floatY[ball]).raw();
+                fixedStepX[ball] = (fixedDirection.x * CFixed(distance)).raw();
+                fixedStepY[ball] = (fixedDirection.y * CFixed(distance)).raw();
+            }
+        };
+
+        std::printf("\n%-14s %14s %14s\n", "ball kernels", "float ns", "fixed ns");
+        for (const BallKernels* kernels : ball_kernels::supported())
+        {
+            reset();
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < BALL_FRAMES; frame++)
+                kernels->advanceFloat(floatX.data(), floatY.data(), floatStepX.data(), floatStepY.data(), BALLS, top, bottom);
+            double floatTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < BALL_FRAMES; frame++)
+                kernels->advanceFixed(
+                    fixedX.data(),
+                    fixedY.data(),
+                    fixedStepX.data(),
+                    fixedStepY.data(),
+                    BALLS,
+                    CFixed(top).raw(),
+                    CFixed(bottom).raw());
+            double fixedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Every fixed-point variant must land every ball on the same bits
+            fixedY.insert(fixedY.end(), fixedStepY.begin(), fixedStepY.end());
+            bool matches = reference.empty() || reference == fixedY;
+            if (reference.empty())
+                reference = fixedY;
+            fixedY.resize(BALLS);
+
+            std::printf(
+                "%-14s %14.3f %14.3f%s\n",
+                kernels->name,
+                floatTime * 1e9 / (static_cast<double>(BALLS) * BALL_FRAMES),
+                fixedTime * 1e9 / (static_cast<double>(BALLS) * BALL_FRAMES),
+                matches ? "" : "  MISMATCH");
+        }
+    }
+
+    /// <summary>
+    ///     Record the ball and paddle coordinates of a seeded demo match.
+    /// </summary>
+    /// <param name="seed">Match seed.</param>
+    /// <param name="ticks">Ticks to play.</param>
+    /// <param name="values">Receives TRAJECTORY_CHANNELS coordinates per tick.</param>
+    void recordTrajectory(std::uint64_t seed, int ticks, std::vector<float>& values)
+    {
+        const float HORIZONS[] = { 0.15f, 0.3f, 0.5f, 1.0f };
+        const float delta = 1.0f / winten_constants::TICK_RATE;
+        CRegistry world;
+        Controller controllers[SIDE_COUNT];
+        systems::Input input = { false, false };
+
+        world.seed(seed);
+        for (int side = 0; side < SIDE_COUNT; side++)
+        {
+            Controller controller = {
+                CONTROLLER_TRACKING,
+                winten_constants::PADDLE_SPEED,
+                HORIZONS[world.random() % 4] * winten_constants::W,
+                false,
+                ACTION_STAY };
+            controllers[side] = controller;
+        }
+        Velocity serve = {
+            winten_constants::BALL_SPEED,
+            static_cast<int>(world.random() % angle_table::STEPS),
+            (world.random() & 1) != 0 };
+        Entity npc = systems::createPaddle(world, winten_constants::PADDLE_X_NPC, &controllers[SIDE_LEFT]);
+        Entity player = systems::createPaddle(world, winten_constants::PADDLE_X_PLAYER, &controllers[SIDE_RIGHT]);
+        Entity ball = systems::createBall(world, winten_constants::W / 2.0f, winten_constants::H / 2.0f, &serve);
+
+        for (int tick = 0; tick < ticks; tick++)
+        {
+            systems::step(world, input, delta);
+            values.push_back(world.positions.get(ball).x);
+            values.push_back(world.positions.get(ball).y);
+            values.push_back(world.positions.get(npc).y);
+            values.push_back(world.positions.get(player).y);
+        }
+    }
+
+    /// <summary>
+    ///     Benchmark the trajectory codec on recorded demo matches: size per
+    ///     tick, worst reconstruction error and decode throughput per kernel.
+    /// </summary>
+    void benchTrajectory(void)
+    {
+        const int MATCHES = 16;
+        const int TICKS = static_cast<int>(600 * winten_constants::TICK_RATE);
+        const int PASSES = 20;
+        std::vector<float> values;
+        std::vector<std::uint8_t> encoded;
+
+        values.reserve(static_cast<std::size_t>(MATCHES) * TICKS * TRAJECTORY_CHANNELS);
+        for (int match = 0; match < MATCHES; match++)
+            recordTrajectory(0x5EED0000u + match, TICKS, values);
+        std::size_t ticks = values.size() / TRAJECTORY_CHANNELS;
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            CTrajectoryEncoder encoder(encoded);
+            for (std::size_t tick = 0; tick < ticks; tick++)
+                encoder.add(&values[tick * TRAJECTORY_CHANNELS]);
+            encoder.finish();
+        }
+        double encodeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // Against storing the ball and both paddles as float pairs
+        double raw = static_cast<double>(ticks) * 3 * 2 * sizeof(float);
+
+        std::printf("ticks %zu, raw %.0f bytes, encoded %zu bytes\n", ticks, raw, encoded.size());
+        std::printf(
+            "%.3f bytes/tick, ratio %.1f:1, encode %.1f Mticks/s\n\n",
+            static_cast<double>(encoded.size()) / ticks,
+            raw / encoded.size(),
+            ticks / encodeTime / 1e6);
+
+        std::unique_ptr<TrajectoryBlock> block(new TrajectoryBlock);
+        std::printf("%-8s %14s %14s\n", "kernels", "decode GB/s", "max error px");
+        for (const TrajectoryKernels* kernels : trajectory_kernels::supported())
+        {
+            // Check every reconstructed coordinate on the first pass
+            float error = 0.0f;
+            std::size_t decoded = 0;
+            {
+                CTrajectoryDecoder decoder(encoded.data(), encoded.size(), kernels);
+                while (decoder.next(*block))
+                {
+                    for (int tick = 0; tick < block->ticks && decoded + tick < ticks; tick++)
+                    {
+                        for (int channel = 0; channel < TRAJECTORY_CHANNELS; channel++)
+                        {
+                            float expected = values[(decoded + tick) * TRAJECTORY_CHANNELS + channel];
+                            error = std::max(error, std::fabs(block->values[channel][tick] - expected));
+                        }
+                    }
+                    decoded += block->ticks;
+                }
+            }
+
+            start = std::chrono::steady_clock::now();
+            for (int pass = 0; pass < PASSES; pass++)
+            {
+                CTrajectoryDecoder decoder(encoded.data(), encoded.size(), kernels);
+                while (decoder.next(*block))
+                    continue;
+            }
+            double decodeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::printf(
+                "%-8s %14.2f %14.4f%s\n",
+                kernels->name,
+                static_cast<double>(ticks * TRAJECTORY_CHANNELS * sizeof(float)) * PASSES / decodeTime / 1e9,
+                error,
+                decoded == ticks ? "" : "  TRUNCATED");
+        }
+    }
+
+    /// <summary>
+    ///     Print command line help.
+    /// </summary>
+    void usage(void)
+    {
+        std::fprintf(stderr,
+            "usage: winten_headless [options]\n"
+            "  --demo           start in demo mode instead of the intro screen\n"
+            "  --rate HZ        frame rate (default %.2f)\n"
+            "  --speed X        simulated seconds per real second, to fast-forward or slow down\n"
+            "  --spin NS        scheduler spin threshold in nanoseconds\n"
+            "  --capture FILE   write a Y4M video on simulated time instead of drawing\n"
+            "  --seconds N      simulated seconds to capture (default 60)\n"
+            "  --size WxH       capture size in pixels, even (default 640x480)\n"
+            "  --threads N      threads drawing captured frames (default one per core)\n"
+            "  --soak           play the demo for --seconds of simulated time as fast as\n"
+            "                   possible, checking every tick, and report the speed\n"
+            "  --draw-every N   draw one soak frame in N offscreen (default none)\n"
+            "  --events         count the game events of the soak by type\n"
+            "  --stress         check physics invariants over randomized matches on every\n"
+            "                   core for --seconds and print replay tokens of failures\n"
+            "  --max-delta MS   longest random time step of --stress (default 30)\n"
+            "  --stress-replay TOKEN  replay one stress match and show its last ticks\n"
+            "  --tournament PREFIX  play matches on every core for --seconds, appending\n"
+            "                   results to PREFIX.matches and PREFIX.rallies\n"
+            "  --query PREFIX   print aggregates of stored tournament results\n"
+            "  --server N       host N intro, demo and game sessions on --threads workers\n"
+            "                   for --seconds with random key presses, reporting load\n"
+            "  --grid CxR       run a grid of C by R demo matches and report cost per court\n"
+            "  --latency        play against synthetic key presses for --seconds and report\n"
+            "                   input-to-present latency\n"
+            "  --adaptive       play demo matches offscreen for --seconds, loading every core\n"
+            "                   in the middle third, and report frame quality held to budget\n"
+            "  --train FILE     learn an NPC policy for --seconds on --threads and save it\n"
+            "  --policy FILE    let a saved policy move the NPC paddles\n"
+            "  --distill FILE   fit a network policy to the tabular --policy, time its\n"
+            "                   decisions per kernel variant and save it\n"
+            "  --bench-kernels  time each raster kernel variant at 1080p, 4K and 8K\n"
+            "  --bench-raster   time tiled frame drawing at 1080p, 4K and 8K per thread count\n"
+            "  --bench-fixed    hash seeded float and fixed-point matches, the fixed digest\n"
+            "                   being the same on every build, and compare their throughput\n"
+            "  --bench-trajectory  compress recorded demo matches and time decoding them\n"
+            "                   per kernel variant\n",
+            winten_constants::FRAME_RATE);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    // Parse command line
+    for (int index = 1; index < argc; index++)
+    {
+        if (std::strcmp(argv[index], "--demo") == 0)
+            options.demo = true;
+        else if (std::strcmp(argv[index], "--rate") == 0 && index + 1 < argc)
+            options.rate = static_cast<float>(std::atof(argv[++index]));
+        else if (std::strcmp(argv[index], "--spin") == 0 && index + 1 < argc)
+            options.spin = std::atoll(argv[++index]);
+        else if (std::strcmp(argv[index], "--capture") == 0 && index + 1 < argc)
+            options.capturePath = argv[++index];
+        else if (std::strcmp(argv[index], "--seconds") == 0 && index + 1 < argc)
+            options.seconds = std::atof(argv[++index]);
+        else if (std::strcmp(argv[index], "--size") == 0 && index + 1 < argc
+            && std::sscanf(argv[++index], "%dx%d", &options.width, &options.height) == 2
+            && options.width > 0 && options.height > 0
+            && options.width % 2 == 0 && options.height % 2 == 0)
+            continue;
+        else if (std::strcmp(argv[index], "--bench-kernels") == 0)
+            options.benchKernels = true;
+        else if (std::strcmp(argv[index], "--bench-raster") == 0)
+            options.benchRaster = true;
+        else if (std::strcmp(argv[index], "--bench-fixed") == 0)
+            options.benchFixed = true;
+        else if (std::strcmp(argv[index], "--bench-trajectory") == 0)
+            options.benchTrajectory = true;
+        else if (std::strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            options.threads = std::atoi(argv[++index]);
+        else if (std::strcmp(argv[index], "--grid") == 0 && index + 1 < argc
+            && std::sscanf(argv[++index], "%dx%d", &options.gridColumns, &options.gridRows) == 2
+            && options.gridColumns > 0 && options.gridRows > 0)
+            continue;
+        else if (std::strcmp(argv[index], "--adaptive") == 0)
+            options.adaptive = true;
+        else if (std::strcmp(argv[index], "--latency") == 0)
+            options.latency = true;
+        else if (std::strcmp(argv[index], "--train") == 0 && index + 1 < argc)
+            options.trainPath = argv[++index];
+        else if (std::strcmp(argv[index], "--policy") == 0 && index + 1 < argc)
+            options.policyPath = argv[++index];
+        else if (std::strcmp(argv[index], "--distill") == 0 && index + 1 < argc)
+            options.distillPath = argv[++index];
+        else if (std::strcmp(argv[index], "--speed") == 0 && index + 1 < argc)
+            options.speed = static_cast<float>(std::atof(argv[++index]));
+        else if (std::strcmp(argv[index], "--soak") == 0)
+            options.soak = true;
+        else if (std::strcmp(argv[index], "--events") == 0)
+            options.events = true;
+        else if (std::strcmp(argv[index], "--draw-every") == 0 && index + 1 < argc)
+            options.drawEvery = std::atoi(argv[++index]);
+        else if (std::strcmp(argv[index], "--stress") == 0)
+            options.stress = true;
+        else if (std::strcmp(argv[index], "--max-delta") == 0 && index + 1 < argc)
+            options.maxDelta = static_cast<float>(std::atof(argv[++index]));
+        else if (std::strcmp(argv[index], "--stress-replay") == 0 && index + 1 < argc)
+            options.replayToken = argv[++index];
+        else if (std::strcmp(argv[index], "--tournament") == 0 && index + 1 < argc)
+            options.tournamentPath = argv[++index];
+        else if (std::strcmp(argv[index], "--server") == 0 && index + 1 < argc)
+            options.serverSessions = std::atoi(argv[++index]);
+        else if (std::strcmp(argv[index], "--query") == 0 && index + 1 < argc)
+            options.queryPath = argv[++index];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.rate <= 0.0f || options.speed <= 0.0f || options.drawEvery < 0)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    if (options.benchKernels)
+    {
+        benchKernels();
+        return EXIT_SUCCESS;
+    }
+    if (options.benchRaster)
+    {
+        benchRaster();
+        return EXIT_SUCCESS;
+    }
+    if (options.benchFixed)
+    {
+        benchFixed();
+        return EXIT_SUCCESS;
+    }
+    if (options.benchTrajectory)
+    {
+        benchTrajectory();
+        return EXIT_SUCCESS;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (options.queryPath != nullptr)
+        return runQuery(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.serverSessions > 0)
+        return runServer(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.stress)
+        return runStress(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.replayToken != nullptr)
+        return runStressReplay(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.trainPath != nullptr)
+        return runTraining(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.policyPath != nullptr)
+    {
+        std::shared_ptr<IPolicy> policy = loadPolicy(options.policyPath);
+        if (!policy)
+            return EXIT_FAILURE;
+        if (options.distillPath != nullptr)
+            return runDistill(options, policy) ? EXIT_SUCCESS : EXIT_FAILURE;
+        if (options.tournamentPath != nullptr)
+            return runTournament(options, policy) ? EXIT_SUCCESS : EXIT_FAILURE;
+        systems::setNpcPolicy(policy);
+    }
+    else if (options.distillPath != nullptr)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    if (options.tournamentPath != nullptr)
+        return runTournament(options, nullptr) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.latency)
+    {
+        runLatency(options);
+        return EXIT_SUCCESS;
+    }
+    if (options.adaptive)
+    {
+        runAdaptive(options);
+        return EXIT_SUCCESS;
+    }
+    if (options.soak)
+        return runSoak(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.gridColumns > 0)
+        return runGrid(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.capturePath != nullptr)
+        return runCapture(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    runTerminal(options);
+    return EXIT_SUCCESS;
+}